@@ -138,18 +138,44 @@ public:
 
     // Applies func to each vertex in bottom-up fashion. That is, func is applied to a vertex after it
     // has been applied to each downward neighbor. If this member function is called in a parallel
-    // region, the function calls are parallelized.
+    // region, the function calls are parallelized. Each subtree of the separator decomposition with
+    // at most grainSize vertices is processed by a single task (by default, n / (32 * #threads)).
     template<typename CallableT>
-    void forEachVertexBottomUp(CallableT func) const {
-        forEachVertexBottomUp(0, upGraph.numVertices(), 0, func);
+    void forEachVertexBottomUp(CallableT func, const int grainSize = 0) const {
+        forEachVertexBottomUp(func, grainSize, [func](const int first, const int last) {
+            for (auto v = first; v < last; ++v)
+                func(v);
+        });
+    }
+
+    // Like above, but applies separatorFunc(first, last) instead of func to the vertices in each
+    // separator [first, last) that is not part of a subtree processed by a single task. This allows
+    // the caller to split the work on the large separators near the root across the threads.
+    template<typename CallableT, typename SeparatorCallableT>
+    void forEachVertexBottomUp(CallableT func, const int grainSize, SeparatorCallableT separatorFunc) const {
+        const auto threshold = grainSize > 0 ? grainSize : getDefaultGrainSize();
+        forEachVertexBottomUp(0, upGraph.numVertices(), 0, threshold, func, separatorFunc);
     }
 
     // Applies func to each vertex in top-down fashion. That is, func is applied to a vertex after it
     // has been applied to each upward neighbor. If this member function is called in a parallel
-    // region, the function calls are parallelized.
+    // region, the function calls are parallelized. Each subtree of the separator decomposition with
+    // at most grainSize vertices is processed by a single task (by default, n / (32 * #threads)).
     template<typename CallableT>
-    void forEachVertexTopDown(CallableT func) const {
-        forEachVertexTopDown(0, upGraph.numVertices(), 0, func);
+    void forEachVertexTopDown(CallableT func, const int grainSize = 0) const {
+        forEachVertexTopDown(func, grainSize, [func](const int first, const int last) {
+            for (auto v = last - 1; v >= first; --v)
+                func(v);
+        });
+    }
+
+    // Like above, but applies separatorFunc(first, last) instead of func to the vertices in each
+    // separator [first, last) that is not part of a subtree processed by a single task. This allows
+    // the caller to split the work on the large separators near the root across the threads.
+    template<typename CallableT, typename SeparatorCallableT>
+    void forEachVertexTopDown(CallableT func, const int grainSize, SeparatorCallableT separatorFunc) const {
+        const auto threshold = grainSize > 0 ? grainSize : getDefaultGrainSize();
+        forEachVertexTopDown(0, upGraph.numVertices(), 0, threshold, func, separatorFunc);
     }
 
     // Applies func to each lower triangle of the specified edge.
@@ -243,48 +269,51 @@ public:
     }
 
 private:
+    // Returns the default maximum number of vertices in a subtree that is processed by a single task.
+    int getDefaultGrainSize() const {
+        return upGraph.numVertices() / (32 * omp_get_num_threads());
+    }
+
     // Applies func to each vertex in bottom-up fashion, starting from from and proceeding to to - 1.
     // That is, func is applied to a vertex after it has been applied to each downward neighbor. If
     // this member function is called in a parallel region, the function calls are parallelized.
-    template<typename CallableT>
-    void forEachVertexBottomUp(int from, int to, const int node, CallableT func) const {
+    template<typename CallableT, typename SeparatorCallableT>
+    void forEachVertexBottomUp(int from, int to, const int node, const int threshold, CallableT func,
+                               SeparatorCallableT separatorFunc) const {
         assert(to == decomp.lastSeparatorVertex(node));
         assert(from >= 0);
         assert(from <= to);
-        const auto threshold = upGraph.numVertices() / (32 * omp_get_num_threads());
         if (to - from <= threshold || omp_get_num_threads() == 1) {
             for (auto v = from; v < to; ++v)
                 func(v);
         } else {
             for (auto child = decomp.leftChild(node); child != 0; child = decomp.rightSibling(child)) {
 #pragma omp task
-                forEachVertexBottomUp(from, decomp.lastSeparatorVertex(child), child, func);
+                forEachVertexBottomUp(from, decomp.lastSeparatorVertex(child), child, threshold, func, separatorFunc);
                 from = decomp.lastSeparatorVertex(child);
             }
 #pragma omp taskwait
-            for (auto v = from; v < to; ++v)
-                func(v);
+            separatorFunc(from, to);
         }
     }
 
     // Applies func to each vertex in top-down fashion, starting from from and proceeding to to - 1.
     // That is, func is applied to a vertex after it has been applied to each upward neighbor. If
     // this member function is called in a parallel region, the function calls are parallelized.
-    template<typename CallableT>
-    void forEachVertexTopDown(int from, int to, const int node, CallableT func) const {
+    template<typename CallableT, typename SeparatorCallableT>
+    void forEachVertexTopDown(int from, int to, const int node, const int threshold, CallableT func,
+                              SeparatorCallableT separatorFunc) const {
         assert(to == decomp.lastSeparatorVertex(node));
         assert(from >= 0);
         assert(from <= to);
-        const auto threshold = upGraph.numVertices() / (32 * omp_get_num_threads());
         if (to - from <= threshold || omp_get_num_threads() == 1) {
             for (auto v = to - 1; v >= from; --v)
                 func(v);
         } else {
-            for (auto v = to - 1; v >= decomp.firstSeparatorVertex(node); --v)
-                func(v);
+            separatorFunc(decomp.firstSeparatorVertex(node), to);
             for (auto child = decomp.leftChild(node); child != 0; child = decomp.rightSibling(child)) {
 #pragma omp task
-                forEachVertexTopDown(from, decomp.lastSeparatorVertex(child), child, func);
+                forEachVertexTopDown(from, decomp.lastSeparatorVertex(child), child, threshold, func, separatorFunc);
                 from = decomp.lastSeparatorVertex(child);
             }
         }
@@ -13,6 +13,7 @@
 #include "DataStructures/Graph/Attributes/UnpackingInfoAttribute.h"
 #include "DataStructures/Graph/Graph.h"
 #include "Tools/Simd/AlignedVector.h"
+#include "Tools/ArenaAllocator.h"
 #include "Tools/ConcurrentHelpers.h"
 #include "Tools/Constants.h"
 #include "Tools/Workarounds.h"
@@ -215,6 +216,13 @@ class CCHMetric {
     return {std::move(upGraph), std::move(downGraph), std::move(order), std::move(ranks)};
   }
 
+  // Sets the maximum number of vertices in a subtree of the separator decomposition that is
+  // customized by a single task. A value of zero selects a default depending on the number of threads.
+  void setParallelGrainSize(const int size) {
+    assert(size >= 0);
+    grainSize = size;
+  }
+
   uint64_t sizeInBytes() const {
     return sizeof(*this)
            + upWeights.size() * sizeof(int32_t)
@@ -266,7 +274,7 @@ class CCHMetric {
           return true;
         });
       }
-    });
+    }, grainSize);
   }
 
   // Computes a customized metric in parallel.
@@ -280,7 +288,7 @@ class CCHMetric {
           return true;
         });
       }
-    });
+    }, grainSize);
   }
 
   // Runs the perfect customization algorithm.
@@ -311,12 +319,14 @@ class CCHMetric {
           return true;
         });
       }
-    });
+    }, grainSize);
   }
 
   const CCH& cch;                    // The associated CCH.
   const int32_t* const inputWeights; // The weights of the input edges.
 
-  std::vector<int32_t> upWeights;   // The upward weights of the edges in the CCH.
-  std::vector<int32_t> downWeights; // The downward weights of the edges in the CCH.
+  ArenaVector<int32_t> upWeights;   // The upward weights of the edges in the CCH.
+  ArenaVector<int32_t> downWeights; // The downward weights of the edges in the CCH.
+
+  int grainSize = 0; // The maximum number of vertices in a subtree customized by a single task.
 };
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "Algorithms/CCH/CCH.h"
+#include "Tools/Constants.h"
+#include "Tools/Workarounds.h"
+
+// This class unpacks an up-down path in a customized CCH (which generally contains shortcuts) into
+// the corresponding path in the original graph (which contains only original edges). Unlike a CH,
+// a CCH stores no unpacking information with its edges. Instead, we identify the input edge or the
+// lower triangle that each edge represents by comparing weights, exactly as the customization
+// computed them. Paths are represented and passed as in CHPathUnpacker.
+class CCHPathUnpacker {
+ public:
+  using Path = std::vector<int32_t>;
+
+  // Constructs a path unpacker for the specified CCH, customized with the specified input weights.
+  CCHPathUnpacker(
+      const CCH& cch, const int32_t* const upWeights, const int32_t* const downWeights,
+      const int32_t* const inputWeights)
+      : cch(cch), upWeights(upWeights), downWeights(downWeights), inputWeights(inputWeights) {
+    assert(upWeights != nullptr);
+    assert(downWeights != nullptr);
+    assert(inputWeights != nullptr);
+  }
+
+  // Appends the input edges on the specified up-down path to unpackedPath. Up edges are traversed
+  // from tail to head and down edges from head to tail.
+  void unpackUpDownPath(const Path& upPath, const Path& downPath, Path& unpackedPath) {
+    assert(packedPath.empty());
+    packedPath.insert(packedPath.end(), downPath.rbegin(), downPath.rend());
+    std::for_each(packedPath.begin(), packedPath.end(), [](int& edge) { edge = -(edge + 1); });
+    packedPath.insert(packedPath.end(), upPath.begin(), upPath.end());
+
+    while (!packedPath.empty()) {
+      const auto edge = packedPath.back();
+      packedPath.pop_back();
+      if (edge >= 0)
+        unpackUpEdge(edge, unpackedPath);
+      else
+        unpackDownEdge(-edge - 1, unpackedPath);
+    }
+  }
+
+ private:
+  // Unpacks the specified edge, traversed from its tail to its head.
+  void unpackUpEdge(const int e, Path& unpackedPath) {
+    auto inputEdge = INVALID_EDGE;
+    cch.forEachUpwardInputEdge(e, [&](const int i) {
+      if (inputWeights[i] == upWeights[e])
+        inputEdge = i;
+      return inputEdge == INVALID_EDGE;
+    });
+    if (inputEdge != INVALID_EDGE) {
+      unpackedPath.push_back(inputEdge);
+      return;
+    }
+
+    // The edge (u, v) is a shortcut for a lower triangle, i.e., for a down edge to some vertex w
+    // followed by an up edge from w to v. We push the edges in reverse order.
+    const auto& upGraph = cch.getUpwardGraph();
+    const auto foundTriangle = !cch.forEachLowerTriangle(
+        upGraph.edgeTail(e), upGraph.edgeHead(e), e, [&](int, const int lower, const int inter) {
+      if (downWeights[lower] + upWeights[inter] != upWeights[e])
+        return true;
+      packedPath.push_back(inter);
+      packedPath.push_back(-(lower + 1));
+      return false;
+    });
+    assert(foundTriangle);
+    unused(foundTriangle);
+  }
+
+  // Unpacks the specified edge, traversed from its head to its tail.
+  void unpackDownEdge(const int e, Path& unpackedPath) {
+    auto inputEdge = INVALID_EDGE;
+    cch.forEachDownwardInputEdge(e, [&](const int i) {
+      if (inputWeights[i] == downWeights[e])
+        inputEdge = i;
+      return inputEdge == INVALID_EDGE;
+    });
+    if (inputEdge != INVALID_EDGE) {
+      unpackedPath.push_back(inputEdge);
+      return;
+    }
+
+    // The edge (v, u) is a shortcut for a lower triangle, i.e., for a down edge to some vertex w
+    // followed by an up edge from w to u. We push the edges in reverse order.
+    const auto& upGraph = cch.getUpwardGraph();
+    const auto foundTriangle = !cch.forEachLowerTriangle(
+        upGraph.edgeTail(e), upGraph.edgeHead(e), e, [&](int, const int lower, const int inter) {
+      if (downWeights[inter] + upWeights[lower] != downWeights[e])
+        return true;
+      packedPath.push_back(lower);
+      packedPath.push_back(-(inter + 1));
+      return false;
+    });
+    assert(foundTriangle);
+    unused(foundTriangle);
+  }
+
+  const CCH& cch;                     // The CCH whose paths are unpacked.
+  const int32_t* const upWeights;     // The customized upward weights of the edges in the CCH.
+  const int32_t* const downWeights;   // The customized downward weights of the edges in the CCH.
+  const int32_t* const inputWeights;  // The weights of the input edges.
+  Path packedPath;                    // A stack of the edges that remain to be unpacked.
+};
@@ -100,10 +100,17 @@ public:
     // Runs a forward search from multiple sources and pins (stores) its distance labels.
     template<typename IteratorT>
     void pinForwardSearch(const IteratorT firstSource, const IteratorT lastSource) {
+        // An interleaved run() leaves the reverse label of the root behind.
+        reverseSearch.distanceLabels[reverseSearch.searchGraph.numVertices() - 1] = INFTY;
         tentativeDistances = INFTY;
         forwardSearch.run(firstSource, lastSource);
     }
 
+    // Resets the pinned forward labels, which is required before the next call to run().
+    void unpinForwardSearch() {
+        forwardSearch.resetDistanceLabels();
+    }
+
     // Runs a reverse search from t, which considers the pinned forward labels.
     void runReverseSearch(const int t) {
         runReverseSearch(&t, &t + 1);
@@ -60,6 +60,15 @@ public:
         return packedSideIds.size();
     }
 
+    // Returns the total number of hubs in the labels of all vertices that are not truncated.
+    uint64_t getTotalNumHubs() const {
+        uint64_t numHubs = 0;
+        for (int v = 0; v < numVertices(); ++v)
+            if (!isVertexTruncated(v))
+                numHubs += getNumHubs(v);
+        return numHubs;
+    }
+
     // Expects ranks in the CCH-order as inputs.
     uint32_t getLowestCommonHub(const int32_t &s, const int32_t &t) const {
 
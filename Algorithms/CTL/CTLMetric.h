@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <omp.h>
+
 #include "Algorithms/CTL/TruncatedTreeLabelling.h"
 #include "Algorithms/CTL/BalancedTopologyCentricTreeHierarchy.h"
 #include "Algorithms/CCH/CCHMetric.h"
@@ -65,6 +68,19 @@ public:
             return cchMetric.downWeights.data();
     }
 
+    // Returns the CH obtained by perfect customization, whose edges carry unpacking information. Only meaningful with
+    // perfect customization.
+    const CH &getMinimumWeightedCH() const {
+        return minimumWeightedCH;
+    }
+
+    // Sets the maximum number of vertices in a subtree of the separator decomposition that is customized by a single
+    // task. A value of zero selects a default depending on the number of threads.
+    void setParallelGrainSize(const int size) {
+        grainSize = size;
+        cchMetric.setParallelGrainSize(size);
+    }
+
     uint64_t sizeInBytes() const {
         return sizeof(*this) + cchMetric.sizeInBytes() + minimumWeightedCH.sizeInBytes();
     }
@@ -76,91 +92,155 @@ private:
     using Batch = typename LabelSet::DistanceLabel;
     using BatchMask = typename LabelSet::LabelMask;
 
+    // The minimum number of hubs in a chunk of a label that is customized by a single task.
+    static constexpr uint32_t MIN_HUBS_PER_CHUNK = 256;
+
+    // The minimum number of hubs in the label of a vertex inside a subtree task such that the chunks of the label
+    // are customized by several tasks.
+    static constexpr uint32_t MIN_HUBS_FOR_PARALLEL_LABEL = 4096;
+
     void customizeLabelling(LabellingT &ctl) {
         ctl.reset();
 
-        const auto &upGraph = upwardGraph();
-        const auto &downGraph = downwardGraph(); // reverse downward graph
-        const auto upWeights = upwardWeights();
-        const auto downWeights = downwardWeights();
-
 #pragma omp parallel // parallelizes forEachVertexTopDown
 #pragma omp single nowait
         cch.forEachVertexTopDown([&](const int u) {
             // Do not build labels for truncated vertices.
             if (hierarchy.isVertexTruncated(u))
                 return;
+            const auto numHubs = hierarchy.getNumHubs(u);
+            if (numHubs < MIN_HUBS_FOR_PARALLEL_LABEL) {
+                customizeLabelsOfVertex(ctl, u, 0, numHubs);
+                return;
+            }
 
-            BatchMask improved;
-            Batch dU, dV, eU;
-            const auto numHubsU = hierarchy.getNumHubs(u);
+            // Split long labels into chunks, since the chunks depend on disjoint parts of the neighbors' labels.
+            const auto hubsPerChunk = getHubsPerChunk(numHubs);
+            const int numChunks = (numHubs + hubsPerChunk - 1) / hubsPerChunk;
+#pragma omp taskloop default(shared) grainsize(1) if(numChunks > 1)
+            for (int c = 0; c < numChunks; ++c)
+                customizeLabelsOfVertex(ctl, u, c * hubsPerChunk, (c + 1) * hubsPerChunk);
+        }, grainSize, [&](const int first, const int last) {
+            customizeLabelsOfSeparator(ctl, first, last);
+        });
+    }
+
+    // Returns the number of hubs in each chunk of labels with the specified number of hubs, such that each thread
+    // gets a few chunks. The returned number is a multiple of K.
+    static uint32_t getHubsPerChunk(const uint32_t numHubs) {
+        const uint32_t numThreads = omp_get_num_threads();
+        auto hubsPerChunk = numThreads == 1 ? numHubs : (numHubs + 4 * numThreads - 1) / (4 * numThreads);
+        hubsPerChunk = std::max(MIN_HUBS_PER_CHUNK, hubsPerChunk);
+        return (hubsPerChunk + K - 1) / K * K;
+    }
+
+    // Customizes the labels of the vertices in the separator [first, last), which is not part of a subtree processed
+    // by a single task. Since the distance to hub i in the label of a vertex depends only on the distances to hub i in
+    // the labels of its upper neighbors, we split the hub range into chunks, and each task processes one chunk of the
+    // labels of all separator vertices in top-down order. This way, all threads work on the long labels of the
+    // separators near the root.
+    void customizeLabelsOfSeparator(LabellingT &ctl, const int first, const int last) {
+        uint32_t maxNumHubs = 0;
+        for (auto v = first; v < last; ++v)
+            if (!hierarchy.isVertexTruncated(v))
+                maxNumHubs = std::max(maxNumHubs, hierarchy.getNumHubs(v));
+
+        const auto hubsPerChunk = getHubsPerChunk(maxNumHubs);
+        const int numChunks = (maxNumHubs + hubsPerChunk - 1) / hubsPerChunk;
+
+#pragma omp taskloop default(shared) grainsize(1) if(numChunks > 1)
+        for (int c = 0; c < numChunks; ++c)
+            for (auto v = last - 1; v >= first; --v)
+                if (!hierarchy.isVertexTruncated(v))
+                    customizeLabelsOfVertex(ctl, v, c * hubsPerChunk, (c + 1) * hubsPerChunk);
+    }
+
+    // Customizes the distances to the hubs firstHub..lastHub-1 in the labels of u using the labels of the upper
+    // neighbors of u. Expects firstHub to be a multiple of K.
+    void customizeLabelsOfVertex(LabellingT &ctl, const int u, const uint32_t firstHub, const uint32_t lastHub) {
+        KASSERT(firstHub % K == 0);
+        const auto numHubsU = hierarchy.getNumHubs(u);
+        if (firstHub >= numHubsU)
+            return;
+        const auto hasLastHub = firstHub < numHubsU && numHubsU <= lastHub;
+
+        const auto &upGraph = upwardGraph();
+        const auto &downGraph = downwardGraph(); // reverse downward graph
+        const auto upWeights = upwardWeights();
+        const auto downWeights = downwardWeights();
 
-            // Customize upward label of u using upper neighbors
-            auto uUpLabel = ctl.upLabel(u);
+        BatchMask improved;
+        Batch dU, dV, eU;
+
+        // Customize upward label of u using upper neighbors
+        auto uUpLabel = ctl.upLabel(u);
+        if (hasLastHub) {
             uUpLabel.initializeLastHubDist(); // distance to self
             if constexpr (LabelSet::KEEP_PARENT_EDGES)
                 uUpLabel.initializeLastHubPathEdge(); // edge to self
-            int32_t* startUUp = uUpLabel.startDists();
-            int32_t* startEdgesUUp = uUpLabel.startEdges();
-            FORALL_INCIDENT_EDGES(upGraph, u, e) {
-                const auto v = upGraph.edgeHead(e);
-                const auto upWeight = upWeights[e];
-                const auto numHubsV = hierarchy.getNumHubs(v);
-                KASSERT(numHubsV < numHubsU);
-                KASSERT(numHubsV == hierarchy.getLowestCommonHub(u, v));
-                const auto vUpLabel = ctl.cUpLabel(v);
-                int const * const startVUp = vUpLabel.startDists();
-                const uint32_t numBlocks = numHubsV / K + (numHubsV % K != 0);
-                const Batch weightAsBatch(upWeight);
-                const Batch eAsBatch(e);
-                for (uint32_t b = 0; b < numBlocks; ++b) {
-                    dV.load(startVUp + b * K);
-                    dU.load(startUUp + b * K);
-                    const auto dNew = weightAsBatch + dV;
-                    improved = dNew < dU;
-                    dU = select(improved, dNew, dU);
-                    dU.store(startUUp + b * K);
-                    if constexpr (LabelSet::KEEP_PARENT_EDGES) {
-                        eU.load(startEdgesUUp + b * K);
-                        eU = select(improved, eAsBatch, eU);
-                        eU.store(startEdgesUUp + b * K);
-                    }
+        }
+        int32_t* startUUp = uUpLabel.startDists();
+        int32_t* startEdgesUUp = uUpLabel.startEdges();
+        FORALL_INCIDENT_EDGES(upGraph, u, e) {
+            const auto v = upGraph.edgeHead(e);
+            const auto upWeight = upWeights[e];
+            const auto numHubsV = hierarchy.getNumHubs(v);
+            KASSERT(numHubsV < numHubsU);
+            KASSERT(numHubsV == hierarchy.getLowestCommonHub(u, v));
+            const auto vUpLabel = ctl.cUpLabel(v);
+            int const * const startVUp = vUpLabel.startDists();
+            const auto endHub = std::min(lastHub, numHubsV);
+            const Batch weightAsBatch(upWeight);
+            const Batch eAsBatch(e);
+            for (uint32_t i = firstHub; i < endHub; i += K) {
+                dV.load(startVUp + i);
+                dU.load(startUUp + i);
+                const auto dNew = weightAsBatch + dV;
+                improved = dNew < dU;
+                dU = select(improved, dNew, dU);
+                dU.store(startUUp + i);
+                if constexpr (LabelSet::KEEP_PARENT_EDGES) {
+                    eU.load(startEdgesUUp + i);
+                    eU = select(improved, eAsBatch, eU);
+                    eU.store(startEdgesUUp + i);
                 }
             }
+        }
 
-            // Customize (reverse) downward label of u using upper neighbors
-            auto uDownLabel = ctl.downLabel(u);
+        // Customize (reverse) downward label of u using upper neighbors
+        auto uDownLabel = ctl.downLabel(u);
+        if (hasLastHub) {
             uDownLabel.initializeLastHubDist(); // distance to self
             if constexpr (LabelSet::KEEP_PARENT_EDGES)
                 uDownLabel.initializeLastHubPathEdge(); // edge to self
-            int32_t* startUDown = uDownLabel.startDists();
-            int32_t* startEdgesUDown = uDownLabel.startEdges();
-            FORALL_INCIDENT_EDGES(downGraph, u, e) {
-                const auto v = downGraph.edgeHead(e);
-                const auto downWeight = downWeights[e];
-                const auto numHubsV = hierarchy.getNumHubs(v);
-                KASSERT(numHubsV < numHubsU);
-                KASSERT(numHubsV == hierarchy.getLowestCommonHub(u, v));
-                const auto vDownLabel = ctl.cDownLabel(v);
-                int32_t const * const startVDown = vDownLabel.startDists();
-                const uint32_t numBlocks = numHubsV / K + (numHubsV % K != 0);
-                const Batch weightAsBatch(downWeight);
-                const Batch eAsBatch(e);
-                for (uint32_t b = 0; b < numBlocks; ++b) {
-                    dV.load(startVDown + b * K);
-                    dU.load(startUDown + b * K);
-                    const auto dNew = weightAsBatch + dV;
-                    improved = dNew < dU;
-                    dU = select(improved, dNew, dU);
-                    dU.store(startUDown + b * K);
-                    if constexpr (LabelSet::KEEP_PARENT_EDGES) {
-                        eU.load(startEdgesUDown + b * K);
-                        eU = select(improved, eAsBatch, eU);
-                        eU.store(startEdgesUDown + b * K);
-                    }
+        }
+        int32_t* startUDown = uDownLabel.startDists();
+        int32_t* startEdgesUDown = uDownLabel.startEdges();
+        FORALL_INCIDENT_EDGES(downGraph, u, e) {
+            const auto v = downGraph.edgeHead(e);
+            const auto downWeight = downWeights[e];
+            const auto numHubsV = hierarchy.getNumHubs(v);
+            KASSERT(numHubsV < numHubsU);
+            KASSERT(numHubsV == hierarchy.getLowestCommonHub(u, v));
+            const auto vDownLabel = ctl.cDownLabel(v);
+            int32_t const * const startVDown = vDownLabel.startDists();
+            const auto endHub = std::min(lastHub, numHubsV);
+            const Batch weightAsBatch(downWeight);
+            const Batch eAsBatch(e);
+            for (uint32_t i = firstHub; i < endHub; i += K) {
+                dV.load(startVDown + i);
+                dU.load(startUDown + i);
+                const auto dNew = weightAsBatch + dV;
+                improved = dNew < dU;
+                dU = select(improved, dNew, dU);
+                dU.store(startUDown + i);
+                if constexpr (LabelSet::KEEP_PARENT_EDGES) {
+                    eU.load(startEdgesUDown + i);
+                    eU = select(improved, eAsBatch, eU);
+                    eU.store(startEdgesUDown + i);
                 }
             }
-        });
+        }
     }
 
     const BalancedTopologyCentricTreeHierarchy &hierarchy;
@@ -168,5 +248,7 @@ private:
     CCHMetric cchMetric;
 
     CH minimumWeightedCH;
+
+    int grainSize = 0; // The maximum number of vertices in a subtree customized by a single task.
 };
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Algorithms/CTL/TruncatedLabelCache.h"
 #include "Algorithms/CTL/TruncatedTreeLabelling.h"
 #include "Algorithms/Dijkstra/DagShortestPaths.h"
 
@@ -13,16 +14,44 @@ class CTLQuery {
 
     static constexpr bool NoTruncatedVertices = BalancedTopologyCentricTreeHierarchy::NoTruncatedVertices;
 
-    // Temporary label being constructed for truncated vertices.
+    // Rounds the specified number of hubs up to the next multiple of K.
+    static constexpr uint32_t padToNextMultipleOfK(const uint32_t numHubs) {
+        return (numHubs + K - 1) / K * K;
+    }
+
+    // Temporary label being constructed for truncated vertices. The arrays only ever grow, so after the first few
+    // queries no memory is allocated, and init() only resets the (padded) prefix that the next query will use.
     struct TemporaryLabel {
 
         TemporaryLabel() = default;
 
         void init(const size_t numHubs) {
             _numHubs = numHubs;
-            dists.assign(numHubs, INFTY);
+            const auto paddedNumHubs = padToNextMultipleOfK(numHubs);
+            if (paddedNumHubs > dists.size()) {
+                dists.resize(paddedNumHubs);
+                if constexpr (LabelSet::KEEP_PARENT_EDGES)
+                    accessVertices.resize(paddedNumHubs);
+            }
+
+            std::fill(dists.begin(), dists.begin() + paddedNumHubs, INFTY);
+            if constexpr (LabelSet::KEEP_PARENT_EDGES)
+                std::fill(accessVertices.begin(), accessVertices.begin() + paddedNumHubs, INVALID_VERTEX);
+        }
+
+        // Initializes the label with the first numHubs hubs of the specified (padded) distances and access vertices.
+        void assign(int32_t const *const otherDists, int32_t const *const otherAccessVertices, const size_t numHubs) {
+            _numHubs = numHubs;
+            const auto paddedNumHubs = padToNextMultipleOfK(numHubs);
+            if (paddedNumHubs > dists.size()) {
+                dists.resize(paddedNumHubs);
+                if constexpr (LabelSet::KEEP_PARENT_EDGES)
+                    accessVertices.resize(paddedNumHubs);
+            }
+
+            std::copy(otherDists, otherDists + paddedNumHubs, dists.begin());
             if constexpr (LabelSet::KEEP_PARENT_EDGES)
-                accessVertices.assign(numHubs, INVALID_VERTEX);
+                std::copy(otherAccessVertices, otherAccessVertices + paddedNumHubs, accessVertices.begin());
         }
 
         const int32_t& dist(const uint32_t &hubIdx) const {
@@ -45,16 +74,26 @@ class CTLQuery {
             return accessVertices[hubIdx];
         }
 
+        // Returns pointers to the distances and access vertices. Both arrays are padded to a multiple of K.
+        int32_t *startDists() {
+            return dists.data();
+        }
+
+        int32_t *startAccessVertices() {
+            return accessVertices.data();
+        }
+
         uint32_t numHubs() const {
             return _numHubs;
         }
 
         uint64_t sizeInBytes() const {
-            return sizeof(TemporaryLabel) + dists.capacity() * sizeof(Batch) + accessVertices.capacity() * sizeof(Batch);
+            return sizeof(TemporaryLabel) + dists.capacity() * sizeof(int32_t) +
+                   accessVertices.capacity() * sizeof(int32_t);
         }
 
     private:
-        uint32_t _numHubs;
+        uint32_t _numHubs = 0;
         AlignedVector<int32_t> dists;
         AlignedVector<int32_t> accessVertices;
     };
@@ -78,17 +117,41 @@ class CTLQuery {
                 return false;
             }
 
-            // TODO: manually vectorize (?)
-            // Update temporary label of source / target with label of v.
+            // Update temporary label of source / target with label of v. Both labels are padded to a multiple of K,
+            // so we process K hubs at a time. The last block may update entries beyond the last relevant hub of the
+            // temporary label, which are never read.
             const auto labelOfV = UP ? ctl.upLabel(v) : ctl.downLabel(v);
             const auto endHub = std::min(temporaryLabel.numHubs(), labelOfV.numHubs);
-            for (int i = 0; i < endHub; ++i) {
-                const auto distViaV = distToV[0] + labelOfV.dist(i);
-                auto& distTemp = temporaryLabel.dist(i);
-                if (distViaV < distTemp) {
-                    distTemp = distViaV;
+            int32_t const *const startDistsV = labelOfV.startDists();
+            int32_t *const startDistsTemp = temporaryLabel.startDists();
+            int32_t *const startAccessVerticesTemp = temporaryLabel.startAccessVertices();
+            if constexpr (K == 1) {
+                // Without SIMD label sets, use a branchless scalar loop that the compiler can vectorize.
+                const int32_t distToVScalar = distToV[0];
+                for (uint32_t i = 0; i < endHub; ++i) {
+                    const auto distViaV = distToVScalar + startDistsV[i];
+                    const bool improved = distViaV < startDistsTemp[i];
+                    startDistsTemp[i] = improved ? distViaV : startDistsTemp[i];
                     if constexpr (LabelSet::KEEP_PARENT_EDGES)
-                        temporaryLabel.accessVertex(i) = v;
+                        startAccessVerticesTemp[i] = improved ? v : startAccessVerticesTemp[i];
+                }
+            } else {
+                const Batch distToVAsBatch(distToV[0]);
+                Batch dV, dTemp;
+                for (uint32_t i = 0; i < endHub; i += K) {
+                    dV.load(startDistsV + i);
+                    dTemp.load(startDistsTemp + i);
+                    const auto distViaV = distToVAsBatch + dV;
+                    const BatchMask improved = distViaV < dTemp;
+                    dTemp = select(improved, distViaV, dTemp);
+                    dTemp.store(startDistsTemp + i);
+                    if constexpr (LabelSet::KEEP_PARENT_EDGES) {
+                        const Batch vAsBatch(v);
+                        Batch accTemp;
+                        accTemp.load(startAccessVerticesTemp + i);
+                        accTemp = select(improved, vAsBatch, accTemp);
+                        accTemp.store(startAccessVerticesTemp + i);
+                    }
                 }
             }
 
@@ -117,66 +180,44 @@ class CTLQuery {
 
 public:
 
+    // Constructs a query instance. If labelCacheBudget is positive, the complete temporary labels of truncated
+    // vertices are cached for reuse by later queries, using at most labelCacheBudget bytes (split evenly between up
+    // and down labels).
     CTLQuery(const BalancedTopologyCentricTreeHierarchy &hierarchy,
              const SearchGraphT &upGraph,
              const SearchGraphT &downGraph,
              int const *const upWeights,
              int const *const downWeights,
-             const LabellingT &ctl)
+             const LabellingT &ctl,
+             const uint64_t labelCacheBudget = 0)
             : hierarchy(hierarchy), upGraph(upGraph), downGraph(downGraph), ctl(ctl),
               buildUpLabelSearch(upGraph, upWeights, {tempUpLabel, upTruncatedSearchSpace, hierarchy, ctl}),
-              buildDownLabelSearch(downGraph, downWeights, {tempDownLabel, downTruncatedSearchSpace, hierarchy, ctl}) {}
+              buildDownLabelSearch(downGraph, downWeights, {tempDownLabel, downTruncatedSearchSpace, hierarchy, ctl}),
+              upLabelCache(labelCacheBudget / 2), downLabelCache(labelCacheBudget / 2) {}
 
     // Expects ranks in the underlying separator decomposition order as inputs.
     void run(const int32_t s, const int32_t t) {
-        lastDistance = INFTY;
-        lastMeetingHubIdx = INVALID_INDEX;
-        minCCHDistMeetingVertex = INVALID_VERTEX;
         lastS = s;
-        lastT = t;
         const auto lch = hierarchy.getLowestCommonHub(s, t);
-
-        if constexpr (NoTruncatedVertices) {
-            const auto sUpLabel = ctl.cUpLabel(s);
-            const auto tDownLabel = ctl.cDownLabel(t);
-            computeMinDistanceInLabels(sUpLabel, tDownLabel, lch);
-        } else {
-            if (!hierarchy.isVertexTruncated(s) && !hierarchy.isVertexTruncated(t)) {
-                const auto sUpLabel = ctl.cUpLabel(s);
-                const auto tDownLabel = ctl.cDownLabel(t);
-                computeMinDistanceInLabels(sUpLabel, tDownLabel, lch);
-            } else if (!hierarchy.isVertexTruncated(s)) {
-                const auto sUpLabel = ctl.cUpLabel(s);
-                buildTempDownLabel(t, lch);
-                computeMinDistanceInLabels(sUpLabel, tempDownLabel, lch);
-            } else if (!hierarchy.isVertexTruncated(t)) {
-                buildTempUpLabel(s, lch);
-                const auto tDownLabel = ctl.cDownLabel(t);
-                computeMinDistanceInLabels(tempUpLabel, tDownLabel, lch);
-            } else {
+        if constexpr (!NoTruncatedVertices)
+            if (hierarchy.isVertexTruncated(s))
                 buildTempUpLabel(s, lch);
-                buildTempDownLabel(t, lch);
-                computeMinDistanceInLabels(tempUpLabel, tempDownLabel, lch);
+        computeDistanceTo(t, lch);
+    }
 
-                // If both s and t are truncated, they may be within the same truncated separator subtree, which we can
-                // check by comparing their number of hubs with the lch.
-                // In this case, their shortest distance may not use a vertex that is high enough in the hierarchy
-                // to be non-truncated. In this case, the shortest path is found using just the distances found during
-                // the two elimination tree searches in the CCH. We only have to consider the truncated vertices in
-                // the search space of the higher ranked vertex between s and t.
-                if (hierarchy.getNumHubs(s) == lch && hierarchy.getNumHubs(t) == lch) {
-                    const auto &searchSpace = s > t ? upTruncatedSearchSpace : downTruncatedSearchSpace;
-                    for (const auto &v: searchSpace) {
-                        const auto cchDist = buildUpLabelSearch.getDistance(v) + buildDownLabelSearch.getDistance(v);
-                        if (cchDist < lastDistance) {
-                            lastDistance = cchDist;
-                            minCCHDistMeetingVertex = v;
-                        }
-                    }
-                }
-            }
-        }
+    // Fixes the source of subsequent one-to-many queries issued via runToTarget(t). If s is truncated, its
+    // complete temporary up label is built once and reused for all targets. Expects a rank as input.
+    void setSource(const int32_t s) {
+        lastS = s;
+        if constexpr (!NoTruncatedVertices)
+            if (hierarchy.isVertexTruncated(s))
+                buildTempUpLabel(s, hierarchy.getNumHubs(s));
+    }
 
+    // Computes the distance from the source fixed by the last call to setSource() to t. Only work specific to t is
+    // done. Expects a rank as input.
+    void runToTarget(const int32_t t) {
+        computeDistanceTo(t, hierarchy.getLowestCommonHub(lastS, t));
     }
 
     // Returns the distance of the last query.
@@ -188,6 +229,16 @@ public:
         return lastMeetingHubIdx;
     }
 
+    // Returns the number of temporary labels that were found in the label cache.
+    uint64_t getNumLabelCacheHits() const {
+        return upLabelCache.getNumHits() + downLabelCache.getNumHits();
+    }
+
+    // Returns the number of temporary labels that had to be built because they were not in the label cache.
+    uint64_t getNumLabelCacheMisses() const {
+        return upLabelCache.getNumMisses() + downLabelCache.getNumMisses();
+    }
+
     // Returns the CCH edges in the upward graph on the up segment of the up-down path (in reverse order to conform to
     // default orientation in graph-traversal-based searches).
     template<bool hasPathEdges = LabelSet::KEEP_PARENT_EDGES, std::enable_if_t<hasPathEdges, bool> = true>
@@ -210,6 +261,7 @@ public:
             if (hierarchy.isVertexTruncated(lastS)) {
                 // If s was truncated, get path to access vertex, i.e., the first non-truncated vertex used on the up path,
                 // using parent pointers in topo search.
+                updateUpSearch();
                 const auto accVertex = tempUpLabel.accessVertex(lastMeetingHubIdx);
                 lastUpPath = buildUpLabelSearch.getReverseEdgePath(accVertex);
                 std::reverse(lastUpPath.begin(), lastUpPath.end());
@@ -254,6 +306,7 @@ public:
             if (hierarchy.isVertexTruncated(lastS)) {
                 // If s was truncated, get path to access vertex, i.e., the first non-truncated vertex used on the up path,
                 // using parent pointers in topo search.
+                updateUpSearch();
                 const auto accVertex = tempUpLabel.accessVertex(lastMeetingHubIdx);
                 lastUpPath = buildUpLabelSearch.getReverseEdgePath(accVertex);
                 v = accVertex;
@@ -294,6 +347,7 @@ public:
             if (hierarchy.isVertexTruncated(lastT)) {
                 // If t was truncated, get path to access vertex, i.e., the first non-truncated vertex used on the down path,
                 // using parent pointers in topo search.
+                updateDownSearch();
                 const auto accVertex = tempDownLabel.accessVertex(lastMeetingHubIdx);
                 lastDownPath = buildDownLabelSearch.getReverseEdgePath(accVertex);
                 std::reverse(lastDownPath.begin(), lastDownPath.end());
@@ -337,6 +391,7 @@ public:
             if (hierarchy.isVertexTruncated(lastT)) {
                 // If t was truncated, get path to access vertex, i.e., the first non-truncated vertex used on the down path,
                 // using parent pointers in topo search.
+                updateDownSearch();
                 const auto accVertex = tempDownLabel.accessVertex(lastMeetingHubIdx);
                 lastDownPath = buildDownLabelSearch.getReverseEdgePath(accVertex);
                 v = accVertex;
@@ -367,31 +422,129 @@ public:
         size += buildDownLabelSearch.sizeInBytes();
         size += upTruncatedSearchSpace.capacity() * sizeof(int32_t);
         size += downTruncatedSearchSpace.capacity() * sizeof(int32_t);
+        size += upLabelCache.sizeInBytes() + downLabelCache.sizeInBytes();
         return size;
     }
 
 private:
 
+    // Computes the distance from lastS to t, given their lowest common hub. If lastS is truncated, tempUpLabel and
+    // the up search space must already be populated for at least the first lch hubs.
+    void computeDistanceTo(const int32_t t, const uint32_t lch) {
+        const auto s = lastS;
+        lastDistance = INFTY;
+        lastMeetingHubIdx = INVALID_INDEX;
+        minCCHDistMeetingVertex = INVALID_VERTEX;
+        lastT = t;
+
+        if constexpr (NoTruncatedVertices) {
+            const auto sUpLabel = ctl.cUpLabel(s);
+            const auto tDownLabel = ctl.cDownLabel(t);
+            computeMinDistanceInLabels(sUpLabel, tDownLabel, lch);
+        } else {
+            if (!hierarchy.isVertexTruncated(s) && !hierarchy.isVertexTruncated(t)) {
+                const auto sUpLabel = ctl.cUpLabel(s);
+                const auto tDownLabel = ctl.cDownLabel(t);
+                computeMinDistanceInLabels(sUpLabel, tDownLabel, lch);
+            } else if (!hierarchy.isVertexTruncated(s)) {
+                const auto sUpLabel = ctl.cUpLabel(s);
+                buildTempDownLabel(t, lch);
+                computeMinDistanceInLabels(sUpLabel, tempDownLabel, lch);
+            } else if (!hierarchy.isVertexTruncated(t)) {
+                const auto tDownLabel = ctl.cDownLabel(t);
+                computeMinDistanceInLabels(tempUpLabel, tDownLabel, lch);
+            } else {
+                buildTempDownLabel(t, lch);
+                computeMinDistanceInLabels(tempUpLabel, tempDownLabel, lch);
+
+                // If both s and t are truncated, they may be within the same truncated separator subtree, which we can
+                // check by comparing their number of hubs with the lch.
+                // In this case, their shortest distance may not use a vertex that is high enough in the hierarchy
+                // to be non-truncated. In this case, the shortest path is found using just the distances found during
+                // the two elimination tree searches in the CCH. We only have to consider the truncated vertices in
+                // the search space of the higher ranked vertex between s and t.
+                if (hierarchy.getNumHubs(s) == lch && hierarchy.getNumHubs(t) == lch) {
+                    updateUpSearch();
+                    updateDownSearch();
+                    const auto &searchSpace = s > t ? upTruncatedSearchSpace : downTruncatedSearchSpace;
+                    for (const auto &v: searchSpace) {
+                        const auto cchDist = buildUpLabelSearch.getDistance(v) + buildDownLabelSearch.getDistance(v);
+                        if (cchDist < lastDistance) {
+                            lastDistance = cchDist;
+                            minCCHDistMeetingVertex = v;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
     // Populates tempUpLabel with up label for truncated vertex v by running topological upwards search from v.
     // Whenever search runs into a non-truncated vertex w, the label of w is used to update tempUpLabel and the
     // search is pruned.
-    // Populates distances only for hubs 0..lch (inclusive).
+    // Populates distances only for hubs 0..lch (inclusive). If the label cache is enabled, the label is taken from
+    // the cache if possible, in which case no search is run.
     void buildTempUpLabel(const int32_t v, const uint32_t lch) {
-        KASSERT(lch <= hierarchy.getNumHubs(v));
-        tempUpLabel.init(lch);
-        upTruncatedSearchSpace.clear();
-        buildUpLabelSearch.run(v);
+        buildTempLabel(v, lch, tempUpLabel, buildUpLabelSearch, upTruncatedSearchSpace, upLabelCache,
+                       isUpSearchUpToDate);
     }
 
     // Populates tempDownLabel with down label for truncated vertex v by running topological reverse-downwards search
     // from v. Whenever search runs into a non-truncated vertex w, the label of w is used to update tempDownLabel and
     // the search is pruned.
-    // Populates distances only for hubs 0..lch (inclusive).
+    // Populates distances only for hubs 0..lch (inclusive). If the label cache is enabled, the label is taken from
+    // the cache if possible, in which case no search is run.
     void buildTempDownLabel(const int32_t v, const uint32_t lch) {
+        buildTempLabel(v, lch, tempDownLabel, buildDownLabelSearch, downTruncatedSearchSpace, downLabelCache,
+                       isDownSearchUpToDate);
+    }
+
+    // Reruns the up search from lastS if the temporary up label was taken from the cache, since the search space
+    // of the search and its parent pointers are needed.
+    void updateUpSearch() {
+        if (!isUpSearchUpToDate)
+            runTempLabelSearch(lastS, tempUpLabel.numHubs(), tempUpLabel, buildUpLabelSearch, upTruncatedSearchSpace,
+                               isUpSearchUpToDate);
+    }
+
+    // Reruns the down search from lastT if the temporary down label was taken from the cache, since the search
+    // space of the search and its parent pointers are needed.
+    void updateDownSearch() {
+        if (!isDownSearchUpToDate)
+            runTempLabelSearch(lastT, tempDownLabel.numHubs(), tempDownLabel, buildDownLabelSearch,
+                               downTruncatedSearchSpace, isDownSearchUpToDate);
+    }
+
+    template<typename SearchT>
+    void buildTempLabel(const int32_t v, const uint32_t lch, TemporaryLabel &label, SearchT &search,
+                        std::vector<int32_t> &searchSpace, TruncatedLabelCache &cache, bool &isSearchUpToDate) {
         KASSERT(lch <= hierarchy.getNumHubs(v));
-        tempDownLabel.init(lch);
-        downTruncatedSearchSpace.clear();
-        buildDownLabelSearch.run(v);
+        if (!cache.isEnabled()) {
+            runTempLabelSearch(v, lch, label, search, searchSpace, isSearchUpToDate);
+            return;
+        }
+
+        const auto idx = cache.find(v);
+        if (idx != -1) {
+            label.assign(cache.dists(idx), cache.accessVertices(idx), lch);
+            isSearchUpToDate = false;
+            return;
+        }
+
+        // On a cache miss, build the complete label of v so that it can be reused for any later query.
+        const auto numHubs = hierarchy.getNumHubs(v);
+        runTempLabelSearch(v, numHubs, label, search, searchSpace, isSearchUpToDate);
+        int32_t const *const accessVertices = LabelSet::KEEP_PARENT_EDGES ? label.startAccessVertices() : nullptr;
+        cache.insert(v, label.startDists(), accessVertices, padToNextMultipleOfK(numHubs));
+    }
+
+    template<typename SearchT>
+    void runTempLabelSearch(const int32_t v, const uint32_t numHubs, TemporaryLabel &label, SearchT &search,
+                            std::vector<int32_t> &searchSpace, bool &isSearchUpToDate) {
+        label.init(numHubs);
+        searchSpace.clear();
+        search.run(v);
+        isSearchUpToDate = true;
     }
 
 
@@ -427,6 +580,11 @@ private:
     TruncatedVertexDownwardSearch buildDownLabelSearch;
     std::vector<int32_t> upTruncatedSearchSpace; // All truncated vertices that the last up search visited
     std::vector<int32_t> downTruncatedSearchSpace; // All truncated vertices that the last down search visited
+    bool isUpSearchUpToDate = true; // Indicates whether the up search was run from the current source
+    bool isDownSearchUpToDate = true; // Indicates whether the down search was run from the current target
+
+    TruncatedLabelCache upLabelCache; // Caches complete temporary up labels of truncated vertices
+    TruncatedLabelCache downLabelCache; // Caches complete temporary down labels of truncated vertices
 
 };
 
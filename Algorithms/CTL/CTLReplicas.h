@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <omp.h>
+
+#include "Algorithms/CTL/BalancedTopologyCentricTreeHierarchy.h"
+#include "Tools/Numa.h"
+
+// Read-only replicas of a customized CTL, i.e., of the tree hierarchy and the labelling, one on each NUMA node that
+// runs threads of the current team. Query threads use the replica on their own node, so that label reads do not go
+// to remote memory. This only pays off if threads are bound to cores (e.g., by OMP_PROC_BIND=true).
+template<typename LabellingT>
+class CTLReplicas {
+
+    // A replica of the tree hierarchy and the labelling.
+    struct Replica {
+
+        Replica(const BalancedTopologyCentricTreeHierarchy &hierarchy, const LabellingT &ctl)
+                : hierarchy(hierarchy), ctl(ctl, this->hierarchy) {}
+
+        BalancedTopologyCentricTreeHierarchy hierarchy;
+        LabellingT ctl;
+    };
+
+public:
+
+    // Constructs replicas of the specified tree hierarchy and labelling, which are copied when calling build().
+    CTLReplicas(const BalancedTopologyCentricTreeHierarchy &hierarchy, const LabellingT &ctl)
+            : hierarchy(hierarchy), ctl(ctl) {}
+
+    // Allocates a replica on each NUMA node that runs threads of the team, unless all threads run on a single node.
+    // Each replica is allocated and its hierarchy is copied by a thread on its node. Must be called after the
+    // labelling is initialized and outside of parallel regions.
+    void build() {
+        replicas.clear();
+        replicas.resize(getNumNumaNodes());
+        std::vector<std::atomic_flag> isNodeUsed(replicas.size());
+        std::vector<std::atomic_flag> isReplicaClaimed(replicas.size());
+        std::atomic<int> numUsedNodes = 0;
+#pragma omp parallel
+        {
+            const auto node = getCurrentNumaNode();
+            if (!isNodeUsed[node].test_and_set())
+                ++numUsedNodes;
+#pragma omp barrier
+            if (numUsedNodes > 1 && !isReplicaClaimed[node].test_and_set())
+                replicas[node] = std::make_unique<Replica>(hierarchy, ctl);
+        }
+        if (numUsedNodes <= 1)
+            replicas.clear();
+    }
+
+    // Copies the current labels into each replica. The threads on each node share the work of copying into the
+    // replica on their node. Must be called after each customization and outside of parallel regions.
+    void update() {
+        if (replicas.empty())
+            return;
+        std::vector<int> nodeOfThread;
+        std::vector<char> isReplicaUpdated(replicas.size(), false);
+#pragma omp parallel
+        {
+#pragma omp single
+            nodeOfThread.resize(omp_get_num_threads());
+            const auto thread = omp_get_thread_num();
+            const auto node = getCurrentNumaNode();
+            nodeOfThread[thread] = node;
+#pragma omp barrier
+            auto rank = 0;
+            auto numThreadsOnNode = 0;
+            for (auto t = 0; t < nodeOfThread.size(); ++t) {
+                rank += t < thread && nodeOfThread[t] == node;
+                numThreadsOnNode += nodeOfThread[t] == node;
+            }
+            if (replicas[node] != nullptr) {
+                replicas[node]->ctl.copyLabelDataFrom(ctl, rank, numThreadsOnNode);
+                if (rank == 0)
+                    isReplicaUpdated[node] = true;
+            }
+        }
+
+        // Threads may have migrated to other nodes since build() was called.
+        for (auto node = 0; node < replicas.size(); ++node)
+            if (replicas[node] != nullptr && !isReplicaUpdated[node])
+                replicas[node]->ctl.copyLabelDataFrom(ctl, 0, 1);
+    }
+
+    // Returns the number of replicas.
+    int numReplicas() const {
+        int num = 0;
+        for (const auto &replica: replicas)
+            num += replica != nullptr;
+        return num;
+    }
+
+    // Returns the tree hierarchy that the calling thread should use.
+    const BalancedTopologyCentricTreeHierarchy &localHierarchy() const {
+        const auto replica = localReplica();
+        return replica != nullptr ? replica->hierarchy : hierarchy;
+    }
+
+    // Returns the labelling that the calling thread should use.
+    const LabellingT &localLabelling() const {
+        const auto replica = localReplica();
+        return replica != nullptr ? replica->ctl : ctl;
+    }
+
+    // Returns the memory taken up by the replicas, i.e., the cost of replication.
+    uint64_t sizeInBytes() const {
+        uint64_t size = sizeof(*this) + replicas.capacity() * sizeof(std::unique_ptr<Replica>);
+        for (const auto &replica: replicas)
+            if (replica != nullptr)
+                size += replica->hierarchy.sizeInBytes() + replica->ctl.sizeInBytes();
+        return size;
+    }
+
+private:
+
+    // Returns the replica on the node of the calling thread, or nullptr if there is none.
+    Replica const *localReplica() const {
+        if (replicas.empty())
+            return nullptr;
+        return replicas[getCurrentNumaNode()].get();
+    }
+
+    const BalancedTopologyCentricTreeHierarchy &hierarchy; // The original tree hierarchy.
+    const LabellingT &ctl;                                 // The original labelling.
+    std::vector<std::unique_ptr<Replica>> replicas;        // The replica on each node, or nullptr if none.
+};
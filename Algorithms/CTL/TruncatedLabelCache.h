@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <kassert/kassert.hpp>
+
+#include "Tools/Constants.h"
+#include "Tools/Simd/AlignedVector.h"
+
+// A bounded cache of the materialized labels of truncated vertices, keyed by vertex. Each label consists of a
+// distance and, optionally, an access vertex per hub. Whenever inserting a label would exceed the memory budget,
+// labels are evicted according to the CLOCK policy, which approximates LRU: a hand sweeps over the cached labels,
+// clearing the reference bit of recently used labels and evicting the first label whose bit is already clear.
+class TruncatedLabelCache {
+
+    // A cached label together with the vertex it belongs to and its reference bit.
+    struct Entry {
+        int32_t vertex = INVALID_VERTEX;
+        bool referenced = false;
+        AlignedVector<int32_t> dists;
+        AlignedVector<int32_t> accessVertices;
+    };
+
+public:
+
+    // Constructs a cache that holds labels taking up at most the specified number of bytes. A budget of zero
+    // disables the cache.
+    explicit TruncatedLabelCache(const uint64_t budgetInBytes = 0) : budget(budgetInBytes) {}
+
+    // Returns whether the cache may hold any labels.
+    bool isEnabled() const {
+        return budget > 0;
+    }
+
+    // Returns the index of the cached label of v, or -1 if the label of v is not cached.
+    int find(const int32_t v) {
+        const auto it = entryIdx.find(v);
+        if (it == entryIdx.end()) {
+            ++numMisses;
+            return -1;
+        }
+        ++numHits;
+        entries[it->second].referenced = true;
+        return it->second;
+    }
+
+    // Returns the distances of the label with the specified index.
+    int32_t const *dists(const int idx) const {
+        KASSERT(idx >= 0 && idx < entries.size());
+        return entries[idx].dists.data();
+    }
+
+    // Returns the access vertices of the label with the specified index.
+    int32_t const *accessVertices(const int idx) const {
+        KASSERT(idx >= 0 && idx < entries.size());
+        return entries[idx].accessVertices.data();
+    }
+
+    // Returns the number of values stored per hub array of the label with the specified index.
+    uint32_t size(const int idx) const {
+        KASSERT(idx >= 0 && idx < entries.size());
+        return entries[idx].dists.size();
+    }
+
+    // Inserts the label of v, consisting of size distances and (if accessVertices is not null) size access
+    // vertices, evicting other labels as needed. Labels larger than the whole budget are not cached.
+    void insert(const int32_t v, int32_t const *const dists, int32_t const *const accessVertices,
+                const uint32_t size) {
+        KASSERT(entryIdx.find(v) == entryIdx.end());
+        const auto bytes = bytesOf(size, accessVertices != nullptr);
+        if (bytes > budget)
+            return;
+        while (usedBytes + bytes > budget)
+            evictNext();
+
+        int idx;
+        if (!freeEntries.empty()) {
+            idx = freeEntries.back();
+            freeEntries.pop_back();
+        } else {
+            idx = entries.size();
+            entries.emplace_back();
+        }
+        auto &entry = entries[idx];
+        entry.vertex = v;
+        entry.referenced = false;
+        entry.dists.assign(dists, dists + size);
+        if (accessVertices != nullptr)
+            entry.accessVertices.assign(accessVertices, accessVertices + size);
+        entryIdx[v] = idx;
+        usedBytes += bytes;
+    }
+
+    // Returns the number of lookups that found the requested label.
+    uint64_t getNumHits() const {
+        return numHits;
+    }
+
+    // Returns the number of lookups that did not find the requested label.
+    uint64_t getNumMisses() const {
+        return numMisses;
+    }
+
+    uint64_t sizeInBytes() const {
+        return sizeof(TruncatedLabelCache) + usedBytes + entries.capacity() * sizeof(Entry) +
+               freeEntries.capacity() * sizeof(int) + entryIdx.size() * 2 * sizeof(int32_t);
+    }
+
+private:
+
+    // Returns the number of bytes that a label with the specified number of values per hub array occupies.
+    static uint64_t bytesOf(const uint32_t size, const bool hasAccessVertices) {
+        return uint64_t{size} * sizeof(int32_t) * (hasAccessVertices ? 2 : 1);
+    }
+
+    // Advances the clock hand until a label without reference bit is found, and evicts this label.
+    void evictNext() {
+        KASSERT(!entryIdx.empty());
+        while (true) {
+            clockHand = clockHand + 1 < entries.size() ? clockHand + 1 : 0;
+            auto &entry = entries[clockHand];
+            if (entry.vertex == INVALID_VERTEX)
+                continue;
+            if (entry.referenced) {
+                entry.referenced = false;
+                continue;
+            }
+            usedBytes -= bytesOf(entry.dists.size(), !entry.accessVertices.empty());
+            entryIdx.erase(entry.vertex);
+            entry.vertex = INVALID_VERTEX;
+            AlignedVector<int32_t>().swap(entry.dists);
+            AlignedVector<int32_t>().swap(entry.accessVertices);
+            freeEntries.push_back(clockHand);
+            return;
+        }
+    }
+
+    uint64_t budget;                                 // The maximum number of bytes taken up by cached labels.
+    uint64_t usedBytes = 0;                          // The number of bytes taken up by cached labels.
+    std::vector<Entry> entries;                      // The cached labels, including free entries.
+    std::vector<int> freeEntries;                    // The indices of free entries.
+    std::unordered_map<int32_t, int> entryIdx;       // Maps each vertex with a cached label to its entry.
+    int clockHand = -1;                              // The entry the clock hand points to.
+
+    uint64_t numHits = 0;
+    uint64_t numMisses = 0;
+};
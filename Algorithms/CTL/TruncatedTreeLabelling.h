@@ -3,6 +3,7 @@
 #include "Algorithms/CTL/BalancedTopologyCentricTreeHierarchy.h"
 #include "DataStructures/Labels/BasicLabelSet.h"
 #include "DataStructures/Labels/SimdLabelSet.h"
+#include "Tools/ArenaAllocator.h"
 
 template<int K, bool KEEP_PARENT_EDGES>
 class TruncatedTreeLabelling {
@@ -109,6 +110,14 @@ public:
     explicit TruncatedTreeLabelling(const BalancedTopologyCentricTreeHierarchy &hierarchy)
             : hierarchy(hierarchy), upLabelData(), downLabelData() {}
 
+    // Constructs a labelling with the same layout as other, based on a copy of the tree hierarchy of other. The label
+    // data are allocated but not touched, so that copyLabelDataFrom decides where its pages are placed.
+    TruncatedTreeLabelling(const TruncatedTreeLabelling &other, const BalancedTopologyCentricTreeHierarchy &hierarchy)
+            : hierarchy(hierarchy), labelOffsets(other.labelOffsets), upLabelData(), downLabelData() {
+        upLabelData.resize(other.upLabelData.size());
+        downLabelData.resize(other.downLabelData.size());
+    }
+
     // Initializes tree labelling with underlying tree hierarchy. (Make sure to preprocess tree hierarchy before calling).
     void init() {
         uint64_t offset = 0;
@@ -125,13 +134,30 @@ public:
             if constexpr (KEEP_PARENT_EDGES)
                 offset += paddedNumHubs; // one path edge per hub, K edges per vec
         }
-        upLabelData.resize(offset, INFTY);
-        downLabelData.resize(offset, INFTY);
+        // Resizing does not touch the label data, so the parallel reset decides where its pages are placed.
+        upLabelData.resize(offset);
+        downLabelData.resize(offset);
+        reset();
     }
 
     void reset() {
-        std::fill(upLabelData.begin(), upLabelData.end(), INFTY);
-        std::fill(downLabelData.begin(), downLabelData.end(), INFTY);
+        const int64_t size = upLabelData.size();
+#pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < size; ++i) {
+            upLabelData[i] = INFTY;
+            downLabelData[i] = INFTY;
+        }
+    }
+
+    // Copies the i-th of n equal parts of the label data from other, which must have the same layout.
+    void copyLabelDataFrom(const TruncatedTreeLabelling &other, const int i, const int n) {
+        KASSERT(other.upLabelData.size() == upLabelData.size());
+        const uint64_t size = upLabelData.size();
+        const auto first = size * i / n;
+        const auto last = size * (i + 1) / n;
+        std::copy(other.upLabelData.begin() + first, other.upLabelData.begin() + last, upLabelData.begin() + first);
+        std::copy(other.downLabelData.begin() + first, other.downLabelData.begin() + last,
+                  downLabelData.begin() + first);
     }
 
     ConstBatchLabel upLabel(const int32_t &v) const {
@@ -210,7 +236,7 @@ private:
     const BalancedTopologyCentricTreeHierarchy &hierarchy;
 
     std::vector<uint64_t> labelOffsets;
-    AlignedVector<int32_t> upLabelData; // expects distances, and edge IDs to be int32_t.
-    AlignedVector<int32_t> downLabelData; // expects distances, and edge IDs to be int32_t.
+    ArenaVector<int32_t> upLabelData; // expects distances, and edge IDs to be int32_t.
+    ArenaVector<int32_t> downLabelData; // expects distances, and edge IDs to be int32_t.
 
 };
\ No newline at end of file
@@ -45,8 +45,10 @@ class BiDijkstraAdapter {
       assert(reverseGraph.numEdges() == flowsOnReverseEdges.size());
     }
 
-    // Computes shortest paths from each source to its target simultaneously.
-    void run(std::array<int, K>& sources, std::array<int, K>& targets, const int k) {
+    // Computes shortest paths from each source to its target simultaneously, and assigns the
+    // specified number of flow units to each path.
+    void run(std::array<int, K>& sources, std::array<int, K>& targets, const std::array<int, K>& weights,
+             const int k) {
       // Run a centralized bidirectional search.
       search.run(sources, targets);
 
@@ -54,11 +56,11 @@ class BiDijkstraAdapter {
       for (auto i = 0; i < k; ++i) {
         for (const auto e : search.getEdgePathToMeetingVertex(i)) {
           assert(e >= 0); assert(e < localFlowsOnForwardEdges.size());
-          ++localFlowsOnForwardEdges[e];
+          localFlowsOnForwardEdges[e] += weights[i];
         }
         for (const auto e : search.getEdgePathFromMeetingVertex(i)) {
           assert(e >= 0); assert(e < localFlowsOnReverseEdges.size());
-          ++localFlowsOnReverseEdges[e];
+          localFlowsOnReverseEdges[e] += weights[i];
         }
       }
     }
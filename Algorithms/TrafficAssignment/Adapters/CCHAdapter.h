@@ -17,6 +17,7 @@
 #include "DataStructures/Labels/BasicLabelSet.h"
 #include "DataStructures/Labels/ParentInfo.h"
 #include "DataStructures/Labels/SimdLabelSet.h"
+#include "DataStructures/Partitioning/InertialFlowSeparator.h"
 #include "DataStructures/Partitioning/SeparatorDecomposition.h"
 #include "Tools/Simd/AlignedVector.h"
 #include "Algorithms/CH/CHPathUnpacker.h"
@@ -46,6 +47,7 @@ class CCHAdapter {
         AlignedVector<int>& flowsOnUpEdges, AlignedVector<int>& flowsOnDownEdges)
         : minimumWeightedCH(minimumWeightedCH),
           search(minimumWeightedCH, eliminationTree),
+          distances(K, INFTY),
           flowsOnUpEdges(flowsOnUpEdges),
           flowsOnDownEdges(flowsOnDownEdges),
           localFlowsOnUpEdges(flowsOnUpEdges.size()),
@@ -54,8 +56,10 @@ class CCHAdapter {
       assert(minimumWeightedCH.downwardGraph().numEdges() == flowsOnDownEdges.size());
     }
 
-    // Computes shortest paths from each source to its target simultaneously.
-    void run(std::array<int, K>& sources, std::array<int, K>& targets, const int k) {
+    // Computes shortest paths from each source to its target simultaneously, and assigns the
+    // specified number of flow units to each path.
+    void run(std::array<int, K>& sources, std::array<int, K>& targets, const std::array<int, K>& weights,
+             const int k) {
 
         // Run a centralized CH search.
       for (auto i = 0; i < K; ++i) {
@@ -66,20 +70,30 @@ class CCHAdapter {
 
       // Assign flow to the edges on the computed paths.
       for (auto i = 0; i < k; ++i) {
-        for (const auto e : search.getUpEdgePath(i)) {
-          assert(e >= 0); assert(e < localFlowsOnUpEdges.size());
-          ++localFlowsOnUpEdges[e];
-        }
-        for (const auto e : search.getDownEdgePath(i)) {
-          assert(e >= 0); assert(e < localFlowsOnDownEdges.size());
-          ++localFlowsOnDownEdges[e];
-        }
+        distances[i] = search.getDistance(i);
+        assignFlowToPath(i, weights[i]);
+      }
+    }
+
+    // Computes shortest paths from a single source to each of the given targets. The forward
+    // elimination tree search is run once and pinned, followed by one reverse search per target.
+    // The path to the i-th target carries weights[i] flow units.
+    void runOneToMany(
+        const int source, const std::vector<int>& targets, const std::vector<int>& weights) {
+      if (distances.size() < targets.size())
+        distances.resize(targets.size());
+      search.pinForwardSearch(minimumWeightedCH.rank(source));
+      for (auto i = 0; i < targets.size(); ++i) {
+        search.runReverseSearch(minimumWeightedCH.rank(targets[i]));
+        distances[i] = search.getDistance();
+        assignFlowToPath(0, weights[i]);
       }
+      search.unpinForwardSearch();
     }
 
     // Returns the length of the i-th shortest path.
     int getDistance(const int /*dst*/, const int i) {
-      return search.getDistance(i);
+      return distances[i];
     }
 
     // Adds the local flow counters to the global ones. Must be synchronized externally.
@@ -91,8 +105,21 @@ class CCHAdapter {
     }
 
    private:
+    // Assigns the given flow to the edges on the i-th path computed by the last search.
+    void assignFlowToPath(const int i, const int flow) {
+      for (const auto e : search.getUpEdgePath(i)) {
+        assert(e >= 0); assert(e < localFlowsOnUpEdges.size());
+        localFlowsOnUpEdges[e] += flow;
+      }
+      for (const auto e : search.getDownEdgePath(i)) {
+        assert(e >= 0); assert(e < localFlowsOnDownEdges.size());
+        localFlowsOnDownEdges[e] += flow;
+      }
+    }
+
     const CH& minimumWeightedCH;            // The CH resulting from perfect customization.
     EliminationTreeQuery<LabelSet> search;  // The CH search on the minimum weighted CH.
+    std::vector<int> distances;             // The path lengths computed by the last search.
     AlignedVector<int>& flowsOnUpEdges;     // The flows in the upward graph.
     AlignedVector<int>& flowsOnDownEdges;   // The flows in the downward graph.
     std::vector<int> localFlowsOnUpEdges;   // The local flows in the upward graph.
@@ -105,8 +132,22 @@ class CCHAdapter {
     assert(inputGraph.numEdges() > 0); assert(inputGraph.isDefrag());
   }
 
-  // Invoked before the first iteration.
-  void preprocess() {
+  // Invoked before the first iteration. The balance parameters and the number of rotations are
+  // passed to the inertial-flow cut routine.
+  void preprocess(const std::vector<int>& balances = {30}, const int numRotations = 1) {
+    preprocess(computeSeparatorDecomposition(inputGraph, balances, numRotations));
+  }
+
+  // Invoked before the first iteration instead of preprocess() if a separator decomposition of the
+  // input graph is already available.
+  void preprocess(const SeparatorDecomposition& sepDecomp) {
+    cch.preprocess(inputGraph, sepDecomp);
+  }
+
+  // Computes a separator decomposition of the specified graph using inertial flow.
+  static SeparatorDecomposition computeSeparatorDecomposition(
+      const InputGraph& inputGraph, const std::vector<int>& balances = {30},
+      const int numRotations = 1) {
     // Convert the input graph to RoutingKit's graph representation.
     std::vector<float> lats(inputGraph.numVertices());
     std::vector<float> lngs(inputGraph.numVertices());
@@ -123,8 +164,9 @@ class CCHAdapter {
 
     // Compute a separator decomposition for the input graph.
     const auto graph = RoutingKit::make_graph_fragment(inputGraph.numVertices(), tails, heads);
+    const InertialFlowSeparator computeCut(lats, lngs, balances, numRotations);
     auto computeSep = [&](const RoutingKit::GraphFragment& fragment) {
-      const auto cut = inertial_flow(fragment, 30, lats, lngs);
+      const auto cut = computeCut(fragment);
       return derive_separator_from_cut(fragment, cut.is_node_on_side);
     };
     const auto decomp = compute_separator_decomposition(graph, computeSep);
@@ -140,9 +182,7 @@ class CCHAdapter {
       sepDecomp.tree.push_back(node);
     }
     sepDecomp.order.assign(decomp.order.begin(), decomp.order.end());
-
-    // Build the CCH.
-    cch.preprocess(inputGraph, sepDecomp);
+    return sepDecomp;
   }
 
   // Invoked before each iteration.
@@ -157,6 +197,11 @@ class CCHAdapter {
     return {minimumWeightedCH, cch.getEliminationTree(), flowsOnUpEdges, flowsOnDownEdges};
   }
 
+  // Returns the metric-independent CCH. Valid after preprocessing.
+  const CCH& getCCH() const {
+    return cch;
+  }
+
   // Propagates the flows on the edges in the search graphs to the edges in the input graph.
   void propagateFlowsToInputEdges(AlignedVector<int>& flowsOnInputEdges) {
     const auto& upGraph = minimumWeightedCH.upwardGraph();
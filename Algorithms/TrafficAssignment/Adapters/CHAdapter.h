@@ -44,8 +44,10 @@ class CHAdapter {
       assert(ch.downwardGraph().numEdges() == flowsOnDownEdges.size());
     }
 
-    // Computes shortest paths from each source to its target simultaneously.
-    void run(std::array<int, K>& sources, std::array<int, K>& targets, const int k) {
+    // Computes shortest paths from each source to its target simultaneously, and assigns the
+    // specified number of flow units to each path.
+    void run(std::array<int, K>& sources, std::array<int, K>& targets, const std::array<int, K>& weights,
+             const int k) {
       // Run a centralized CH search.
       for (auto i = 0; i < K; ++i) {
         sources[i] = ch.rank(sources[i]);
@@ -57,11 +59,11 @@ class CHAdapter {
       for (auto i = 0; i < k; ++i) {
         for (const auto e : search.getUpEdgePath(i)) {
           assert(e >= 0); assert(e < localFlowsOnUpEdges.size());
-          ++localFlowsOnUpEdges[e];
+          localFlowsOnUpEdges[e] += weights[i];
         }
         for (const auto e : search.getDownEdgePath(i)) {
           assert(e >= 0); assert(e < localFlowsOnDownEdges.size());
-          ++localFlowsOnDownEdges[e];
+          localFlowsOnDownEdges[e] += weights[i];
         }
       }
     }
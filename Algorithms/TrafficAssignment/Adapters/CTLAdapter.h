@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <vector>
 #include <kassert/kassert.hpp>
+#include "DataStructures/Partitioning/InertialFlowSeparator.h"
 #include "DataStructures/Partitioning/nested_strict_dissection.h"
 
 #include "DataStructures/Graph/Graph.h"
@@ -17,6 +18,8 @@
 #include "Algorithms/CTL/BalancedTopologyCentricTreeHierarchy.h"
 #include "Algorithms/CTL/CTLMetric.h"
 #include "Algorithms/CTL/CTLQuery.h"
+#include "Algorithms/CTL/CTLReplicas.h"
+#include "Tools/ArenaAllocator.h"
 
 namespace trafficassignment {
 
@@ -52,39 +55,40 @@ namespace trafficassignment {
                     ranks(ranks),
                     ctlQuery(hierarchy, metric.upwardGraph(), metric.downwardGraph(), metric.upwardWeights(),
                              metric.downwardWeights(), ctl),
+                    distances(K, INFTY),
                     flowsOnUpEdges(flowsOnUpEdges),
                     flowsOnDownEdges(flowsOnDownEdges),
                     localFlowsOnUpEdges(flowsOnUpEdges.size(), 0),
                     localFlowsOnDownEdges(flowsOnDownEdges.size(), 0) {
                 assert(upGraph.numEdges() == flowsOnUpEdges.size());
                 assert(downGraph.numEdges() == flowsOnDownEdges.size());
-                distances.fill(INFTY);
             }
 
             // Computes shortest paths from each source to its target simultaneously.
             // Parameter k is actual number of source-target pairs if batch is partially filled,
-            // i.e., only pairs 0..k are relevant.
-            void run(std::array<int, K> &sources, std::array<int, K> &targets, const int k) {
+            // i.e., only pairs 0..k are relevant. The i-th path carries weights[i] flow units.
+            void run(std::array<int, K> &sources, std::array<int, K> &targets, const std::array<int, K> &weights,
+                     const int k) {
 
                 // No facilities for centralized searches in CTL. Run each search individually:
                 for (auto j = 0; j < k; ++j) {
                     ctlQuery.run(ranks[sources[j]], ranks[targets[j]]);
                     distances[j] = ctlQuery.getDistance();
+                    assignFlowToLastPath(weights[j]);
+                }
+            }
 
-                    // Assign flow to the edges (possibly shortcuts) on the computed paths.
-                    const auto &upEdges = ctlQuery.getEdgesOnUpPathUnordered();
-                    const auto &downEdges = ctlQuery.getEdgesOnDownPathUnordered();
-                    for (const auto &e: upEdges) {
-                        KASSERT(e >= 0);
-                        KASSERT(e < localFlowsOnUpEdges.size());
-                        ++localFlowsOnUpEdges[e];
-                    }
-                    for (const auto &e: downEdges) {
-                        KASSERT(e >= 0);
-                        KASSERT(e < localFlowsOnDownEdges.size());
-                        ++localFlowsOnDownEdges[e];
-                    }
-
+            // Computes shortest paths from a single source to each of the given targets. The up label of the source
+            // is obtained only once and reused for all targets. Afterwards, getDistance(dst, i) returns the length of
+            // the path to the i-th target. The path to the i-th target carries weights[i] flow units.
+            void runOneToMany(const int source, const std::vector<int> &targets, const std::vector<int> &weights) {
+                if (distances.size() < targets.size())
+                    distances.resize(targets.size());
+                ctlQuery.setSource(ranks[source]);
+                for (auto j = 0; j < targets.size(); ++j) {
+                    ctlQuery.runToTarget(ranks[targets[j]]);
+                    distances[j] = ctlQuery.getDistance();
+                    assignFlowToLastPath(weights[j]);
                 }
             }
 
@@ -105,11 +109,28 @@ namespace trafficassignment {
 
         private:
 
+            // Assigns the given number of flow units to the edges (possibly shortcuts) on the path computed by the
+            // last CTL query.
+            void assignFlowToLastPath(const int flow) {
+                const auto &upEdges = ctlQuery.getEdgesOnUpPathUnordered();
+                const auto &downEdges = ctlQuery.getEdgesOnDownPathUnordered();
+                for (const auto &e: upEdges) {
+                    KASSERT(e >= 0);
+                    KASSERT(e < localFlowsOnUpEdges.size());
+                    localFlowsOnUpEdges[e] += flow;
+                }
+                for (const auto &e: downEdges) {
+                    KASSERT(e >= 0);
+                    KASSERT(e < localFlowsOnDownEdges.size());
+                    localFlowsOnDownEdges[e] += flow;
+                }
+            }
+
             const CTLMetricT::SearchGraph &upGraph;
             const CTLMetricT::SearchGraph &downGraph;
             const Permutation &ranks; // rank[v] is the rank of vertex v in the contraction order
             CTLQuery <CTLMetricT::SearchGraph, LabellingT, CTLLabelSet> ctlQuery;
-            std::array<int, K> distances; // distances computed in last call to run()
+            std::vector<int> distances; // distances computed in last call to run() or runOneToMany()
 
             AlignedVector<int> &flowsOnUpEdges;     // The flows in the upward graph.
             AlignedVector<int> &flowsOnDownEdges;   // The flows in the downward graph.
@@ -120,13 +141,39 @@ namespace trafficassignment {
         // Constructs an adapter for CTLs.
         explicit CTLAdapter(const InputGraphT &inputGraph)
                 : inputGraph(inputGraph), treeHierarchy(), cch(),
-                  metric(treeHierarchy, cch, &inputGraph.template get<WeightT>(0)), ctl(treeHierarchy) {
+                  metric(treeHierarchy, cch, &inputGraph.template get<WeightT>(0)), ctl(treeHierarchy),
+                  replicas(treeHierarchy, ctl) {
             assert(inputGraph.numEdges() > 0);
             assert(inputGraph.isDefrag());
         }
 
-        // Invoked before the first iteration.
-        void preprocess() {
+        // Invoked before the first iteration. The balance parameters and the number of rotations are passed to the
+        // inertial-flow cut routine.
+        void preprocess(const std::vector<int> &balances = {30}, const int numRotations = 1) {
+            preprocess(computeSeparatorDecomposition(inputGraph, balances, numRotations));
+        }
+
+        // Invoked before the first iteration instead of preprocess() if a separator decomposition of the input
+        // graph is already available. The decomposition must be a strict dissection.
+        void preprocess(const SeparatorDecomposition &sepDecomp) {
+            // Build the CCH.
+            cch.preprocess(inputGraph, sepDecomp);
+
+            // Build the tree hierarchy.
+            treeHierarchy.preprocess(inputGraph, sepDecomp);
+
+            // Allocate labels.
+            ctl.init();
+
+            // Allocate a replica of the hierarchy and the labels on each NUMA node if requested.
+            if (ArenaPolicy::global().replicate)
+                replicas.build();
+        }
+
+        // Computes a separator decomposition of the specified graph using inertial flow with strict dissection.
+        static SeparatorDecomposition computeSeparatorDecomposition(const InputGraphT &inputGraph,
+                                                                    const std::vector<int> &balances = {30},
+                                                                    const int numRotations = 1) {
             // Convert the input graph to RoutingKit's graph representation.
             std::vector<float> lats(inputGraph.numVertices());
             std::vector<float> lngs(inputGraph.numVertices());
@@ -143,13 +190,14 @@ namespace trafficassignment {
 
             // Compute a separator decomposition for the input graph.
             auto graph = RoutingKit::make_graph_fragment(inputGraph.numVertices(), tails, heads);
-            auto computeCut = [&](const RoutingKit::GraphFragment &fragment) {
-                return inertial_flow(fragment, 30, lats, lngs);
-            };
+            const InertialFlowSeparator computeCut(lats, lngs, balances, numRotations);
             RoutingKit::BitVector all(graph.node_count(), true);
             RoutingKit::BitVector none = ~all;
-            const auto decomp = compute_separator_decomposition_with_strict_dissection(std::move(graph), computeCut,
-                                                                                       std::move(none), std::move(all));
+            RoutingKit::SeparatorDecomposition decomp;
+#pragma omp parallel // parallelizes the recursion within compute_separator_decomposition_with_strict_dissection.
+#pragma omp single nowait
+            decomp = compute_separator_decomposition_with_strict_dissection(std::move(graph), computeCut,
+                                                                            std::move(none), std::move(all));
 
             // Convert the separator decomposition to our representation.
             SeparatorDecomposition sepDecomp;
@@ -162,27 +210,31 @@ namespace trafficassignment {
                 sepDecomp.tree.push_back(node);
             }
             sepDecomp.order.assign(decomp.order.begin(), decomp.order.end());
-
-            // Build the CCH.
-            cch.preprocess(inputGraph, sepDecomp);
-
-            // Build the tree hierarchy.
-            treeHierarchy.preprocess(inputGraph, sepDecomp);
-
-            // Allocate labels.
-            ctl.init();
+            return sepDecomp;
         }
 
         // Invoked before each iteration.
         void customize() {
             metric.buildCustomizedCTL(ctl);
+            replicas.update();
             flowsOnUpEdges.assign(metric.upwardGraph().numEdges(), 0);
             flowsOnDownEdges.assign(metric.downwardGraph().numEdges(), 0);
         }
 
-        // Returns an instance of the query algorithm.
+        // Returns an instance of the query algorithm, working on the replica on the NUMA node of the calling thread.
         QueryAlgo getQueryAlgoInstance() {
-            return {treeHierarchy, ctl, metric, cch.getRanks(), flowsOnUpEdges, flowsOnDownEdges};
+            return {replicas.localHierarchy(), replicas.localLabelling(), metric, cch.getRanks(), flowsOnUpEdges,
+                    flowsOnDownEdges};
+        }
+
+        // Returns the per-node replicas of the CTL. Valid after preprocessing.
+        const CTLReplicas<LabellingT> &getReplicas() const {
+            return replicas;
+        }
+
+        // Returns the metric-independent CCH. Valid after preprocessing.
+        const CCH &getCCH() const {
+            return cch;
         }
 
         // Propagates the flows on the edges in the search graphs to the edges in the input graph.
@@ -324,6 +376,7 @@ namespace trafficassignment {
         CCH cch;                      // The metric-independent CCH.
         CTLMetricT metric;      // The current metric for the CCH.
         LabellingT ctl;   // The customized tree labelling.
+        CTLReplicas<LabellingT> replicas; // Replicas of the tree hierarchy and labelling on each NUMA node.
 
         AlignedVector<int> flowsOnUpEdges;   // The flows on the edges in the upward graph.
         AlignedVector<int> flowsOnDownEdges; // The flows on the edges in the downward graph.
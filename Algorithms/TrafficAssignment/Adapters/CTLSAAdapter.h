@@ -56,8 +56,9 @@ namespace trafficassignment {
 
             // Computes shortest paths from each source to its target simultaneously.
             // Parameter k is actual number of source-target pairs if batch is partially filled,
-            // i.e., only pairs 0..k are relevant.
-            void run(std::array<int, K> &sources, std::array<int, K> &targets, const int k) {
+            // i.e., only pairs 0..k are relevant. The i-th path carries weights[i] flow units.
+            void run(std::array<int, K> &sources, std::array<int, K> &targets, const std::array<int, K> &weights,
+                     const int k) {
 
                 // No facilities for centralized searches in CTLSA. Run each search individually:
                 for (auto i = 0; i < k; ++i) {
@@ -76,7 +77,7 @@ namespace trafficassignment {
                         const auto head = vertexPath[j] - 1; // -1 because inputGraph vertex IDs start at 0
                         const auto e = inputGraph.uniqueEdgeBetween(tail, head);
                         KASSERT(e != -1);
-                        ++localFlow[e];
+                        localFlow[e] += weights[i];
                         recomputedDist += inputGraph.template get<WeightT>(e);
 
                         tail = head;
@@ -49,8 +49,9 @@ namespace trafficassignment {
 
             // Computes shortest paths from each source to its target simultaneously.
             // Parameter k is actual number of source-target pairs if batch is partially filled,
-            // i.e., only pairs 0..k are relevant.
-            void run(std::array<int, K> &sources, std::array<int, K> &targets, const int k) {
+            // i.e., only pairs 0..k are relevant. The i-th path carries weights[i] flow units.
+            void run(std::array<int, K> &sources, std::array<int, K> &targets, const std::array<int, K> &weights,
+                     const int k) {
 
                 // No facilities for centralized searches in CTLSA. Run each search individually:
                 for (auto i = 0; i < k; ++i) {
@@ -71,7 +72,7 @@ namespace trafficassignment {
                         const auto e = inputGraph.uniqueEdgeBetween(tail, head);
                         KASSERT(e != -1);
 //                        paths[i].push_back(e);
-                        ++localFlow[e];
+                        localFlow[e] += weights[i];
                         recomputedDist += inputGraph.template get<WeightT>(e);
 
                         tail = head;
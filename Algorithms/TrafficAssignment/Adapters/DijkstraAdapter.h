@@ -38,8 +38,10 @@ class DijkstraAdapter {
       assert(inputGraph.numEdges() == flowsOnForwardEdges.size());
     }
 
-    // Computes shortest paths from each source to its target simultaneously.
-    void run(std::array<int, K>& sources, std::array<int, K>& targets, const int k) {
+    // Computes shortest paths from each source to its target simultaneously, and assigns the
+    // specified number of flow units to each path.
+    void run(std::array<int, K>& sources, std::array<int, K>& targets, const std::array<int, K>& weights,
+             const int k) {
       // Run a centralized Dijkstra search.
       search.run(sources, targets);
 
@@ -47,7 +49,7 @@ class DijkstraAdapter {
       for (auto i = 0; i < k; ++i) {
         for (const auto e : search.getReverseEdgePath(targets[i], i)) {
           assert(e >= 0); assert(e < localFlowsOnForwardEdges.size());
-          ++localFlowsOnForwardEdges[e];
+          localFlowsOnForwardEdges[e] += weights[i];
         }
       }
     }
@@ -9,28 +9,38 @@
 #include <ostream>
 #include <vector>
 
+#include "Algorithms/CCH/CCH.h"
+#include "DataStructures/Partitioning/SeparatorDecomposition.h"
 #include "DataStructures/Utilities/OriginDestination.h"
 #include "AllOrNothingAssignmentStats.h"
 #include "Tools/CommandLine/ProgressBar.h"
+#include "Tools/PerfCounters.h"
 #include "Tools/Simd/AlignedVector.h"
 #include "Tools/Timer.h"
 #include "Algorithms/TrafficAssignment/Adapters/CCHAdapter.h"
 
 // Implementation of an iterative all-or-nothing traffic assignment. Each OD pair is processed in
-// turn and the corresponding OD flow (in our case always a single flow unit) is assigned to each
-// edge on the shortest path between O and D. Other O-D paths are not assigned any flow. The
-// procedure can be used with different shortest-path algorithms.
+// turn and the corresponding OD flow (the number of trips represented by the pair) is assigned to
+// each edge on the shortest path between O and D. Other O-D paths are not assigned any flow. The
+// procedure can be used with different shortest-path algorithms. If the shortest-path algorithm
+// provides one-to-many queries, all OD pairs sharing an origin are processed by a single query.
 template<typename ShortestPathAlgoT>
 class AllOrNothingAssignment {
 private:
     using InputGraph = typename ShortestPathAlgoT::InputGraph;
 
 public:
-    // Constructs an all-or-nothing assignment instance.
+    // Constructs an all-or-nothing assignment instance. If a separator decomposition is specified and
+    // the shortest-path algorithm accepts one, it is used instead of computing a new one. Otherwise,
+    // such an algorithm computes one by inertial flow with the specified balance parameters and number
+    // of rotations. The OD pairs may be reordered up until the first call to run().
     AllOrNothingAssignment(const InputGraph &graph,
                            const std::vector<ClusteredOriginDestination> &odPairs,
                            const bool verbose = true,
-                           const bool veryVerbose = false)
+                           const bool veryVerbose = false,
+                           const SeparatorDecomposition *sepDecomp = nullptr,
+                           const std::vector<int> &balances = {30},
+                           const int numRotations = 1)
             : stats(odPairs.size()),
               shortestPathAlgo(graph),
               inputGraph(graph),
@@ -38,80 +48,58 @@ public:
               verbose(verbose),
               veryVerbose(veryVerbose) {
         Timer timer;
-        shortestPathAlgo.preprocess();
+        PerfMeter perfMeter;
+        if constexpr (AcceptsSeparatorDecomposition) {
+            if (sepDecomp != nullptr)
+                shortestPathAlgo.preprocess(*sepDecomp);
+            else
+                shortestPathAlgo.preprocess(balances, numRotations);
+        } else {
+            shortestPathAlgo.preprocess();
+        }
         stats.totalPreprocessingTime = timer.elapsed();
+        stats.totalPreprocessingPerf = perfMeter.elapsed();
         stats.lastRoutingTime = stats.totalPreprocessingTime;
         stats.totalRoutingTime = stats.totalPreprocessingTime;
         if (verbose) std::cout << "  Prepro: " << stats.totalPreprocessingTime << "ms" << std::endl;
+        if constexpr (PERF_COUNTERS_ENABLED)
+            if (verbose) printPerfCounts("prepro", stats.totalPreprocessingPerf);
+        if constexpr (requires { shortestPathAlgo.getReplicas(); }) {
+            const auto &replicas = shortestPathAlgo.getReplicas();
+            if (verbose && replicas.numReplicas() > 0)
+                std::cout << "  Replicas: " << replicas.numReplicas() << " NUMA nodes, "
+                          << replicas.sizeInBytes() / (1 << 20) << "MB" << std::endl;
+        }
     }
 
     // Assigns all OD flows to their currently shortest paths.
     void run(const int skipInterval = 1) {
         Timer timer;
+        PerfMeter perfMeter;
         ++stats.numIterations;
         if (verbose) std::cout << "Iteration " << stats.numIterations << ": " << std::flush;
         shortestPathAlgo.customize();
         stats.lastCustomizationTime = timer.elapsed();
+        stats.lastCustomizationPerf = perfMeter.elapsed();
 
         timer.restart();
-        ProgressBar bar(std::ceil(1.0 * odPairs.size() / (K * skipInterval)), veryVerbose);
+        perfMeter.restart();
         trafficFlows.assign(inputGraph.numEdges(), 0);
         stats.startIteration();
-        auto totalNumPairsSampledBefore = 0;
-#pragma omp parallel
-        {
-            auto queryAlgo = shortestPathAlgo.getQueryAlgoInstance();
-            auto checksum = int64_t{0};
-            auto prevMinPathCost = int64_t{0};
-            auto avgChange = 0.0;
-            auto maxChange = 0.0;
-            auto numPairsSampledBefore = 0;
-
-#pragma omp for schedule(dynamic, 4096 / K) nowait
-            for (auto i = 0; i < odPairs.size(); i += K * skipInterval) {
-                // Run multiple shortest-path computations simultaneously.
-                std::array<int, K> sources;
-                std::array<int, K> targets;
-                sources.fill(odPairs[i].origin);
-                targets.fill(odPairs[i].destination);
-                auto k = 1;
-                for (; k < K && i + k * skipInterval < odPairs.size(); ++k) {
-                    sources[k] = odPairs[i + k * skipInterval].origin;
-                    targets[k] = odPairs[i + k * skipInterval].destination;
-                }
-                queryAlgo.run(sources, targets, k);
-
-                for (auto j = 0; j < k; ++j) {
-                    // Maintain the avg and max change in the OD distances between the last two iterations.
-                    const auto dst = odPairs[i + j * skipInterval].destination;
-                    const auto dist = queryAlgo.getDistance(dst, j);
-                    const auto prevDist = stats.lastDistances[i + j * skipInterval];
-                    const auto change = 1.0 * std::abs(dist - prevDist) / prevDist;
-                    numPairsSampledBefore += prevDist != -1;
-                    checksum += dist;
-                    prevMinPathCost += prevDist != -1 ? dist : 0;
-                    stats.lastDistances[i + j * skipInterval] = dist;
-                    avgChange += std::max(0.0, change);
-                    maxChange = std::max(maxChange, change);
-                }
-                ++bar;
-            }
-
-#pragma omp critical (combineResults)
-            {
-                queryAlgo.addLocalToGlobalFlows();
-                stats.lastChecksum += checksum;
-                stats.prevMinPathCost += prevMinPathCost;
-                stats.avgChangeInDistances += avgChange;
-                stats.maxChangeInDistances = std::max(stats.maxChangeInDistances, maxChange);
-                totalNumPairsSampledBefore += numPairsSampledBefore;
-            }
-        }
-        bar.finish();
+        if constexpr (SupportsOneToMany)
+            if (firstPairOfGroup.empty())
+                groupODPairsByOrigin();
+        int totalNumPairsSampledBefore;
+        if constexpr (SupportsOneToMany)
+            totalNumPairsSampledBefore = assignODPairsGroupedByOrigin(skipInterval);
+        else
+            totalNumPairsSampledBefore = assignODPairsInBatches(skipInterval);
 
         shortestPathAlgo.propagateFlowsToInputEdges(trafficFlows);
         std::for_each(trafficFlows.begin(), trafficFlows.end(), [&](int &f) { f *= skipInterval; });
         stats.lastQueryTime = timer.elapsed();
+        stats.lastQueryPerf = perfMeter.elapsed();
+        stats.lastNumQueries = (odPairs.size() + skipInterval - 1) / skipInterval;
         stats.avgChangeInDistances /= totalNumPairsSampledBefore;
         stats.finishIteration();
 
@@ -121,10 +109,43 @@ public:
             std::cout << "  Custom: " << stats.lastCustomizationTime << "ms";
             std::cout << "  Queries: " << stats.lastQueryTime << "ms";
             std::cout << "  Routing: " << stats.lastRoutingTime << "ms\n";
+            if constexpr (PERF_COUNTERS_ENABLED) {
+                printPerfCounts("custom", stats.lastCustomizationPerf);
+                printPerfCounts("queries", stats.lastQueryPerf);
+                printPerfCounts("per query", stats.lastQueryPerf, stats.lastNumQueries);
+            }
             std::cout << std::flush;
         }
     }
 
+    // Writes the hardware events counted during the specified phase to standard output, each divided
+    // by the specified number (e.g., of queries).
+    static void printPerfCounts(const char *const phase, const PerfCounts &counts, const double divisor = 1) {
+        std::cout << "  Perf " << phase << ": ";
+        counts.print(std::cout, divisor);
+        std::cout << '\n';
+    }
+
+    // Returns the CCH used by the shortest-path algorithm, or nullptr if it does not use one.
+    const CCH *getCCH() const {
+        if constexpr (requires { shortestPathAlgo.getCCH(); })
+            return &shortestPathAlgo.getCCH();
+        else
+            return nullptr;
+    }
+
+    // Returns the number of OD pairs to be assigned onto the graph.
+    int numODPairs() const {
+        return odPairs.size();
+    }
+
+    // Returns the number of trips represented by the i-th OD pair.
+    int odPairWeight(const int i) const {
+        assert(i >= 0);
+        assert(i < odPairs.size());
+        return odPairs[i].weight;
+    }
+
     // Returns the traffic flow on edge e.
     const int &trafficFlowOn(const int e) const {
         assert(e >= 0);
@@ -138,11 +159,188 @@ private:
     // The maximum number of simultaneous shortest-path computations.
     static constexpr int K = ShortestPathAlgoT::K;
 
+    using QueryAlgo = typename ShortestPathAlgoT::QueryAlgo;
     using ODPairs = std::vector<ClusteredOriginDestination>;
 
+    // Indicates whether the shortest-path algorithm can be preprocessed with a given separator
+    // decomposition.
+    static constexpr bool AcceptsSeparatorDecomposition =
+            requires(ShortestPathAlgoT &algo, const SeparatorDecomposition &sepDecomp) {
+                algo.preprocess(sepDecomp);
+            };
+
+    // Indicates whether the query algorithm can answer all OD pairs sharing an origin at once.
+    static constexpr bool SupportsOneToMany = requires(QueryAlgo &algo, const std::vector<int> &targets) {
+        algo.runOneToMany(0, targets);
+    };
+
+    // Statistics about the OD distances, accumulated locally by each thread.
+    struct LocalDistanceStats {
+        int64_t checksum = 0;
+        int64_t prevMinPathCost = 0;
+        double avgChange = 0.0;
+        double maxChange = 0.0;
+        int numPairsSampledBefore = 0;
+    };
+
+    // Groups the OD pairs by origin. Origins appear in the order of their first OD pair, and the OD
+    // pairs sharing an origin keep their relative order.
+    void groupODPairsByOrigin() {
+        std::vector<int> groupOfOrigin(inputGraph.numVertices(), -1);
+        firstPairOfGroup.assign(1, 0);
+        for (const auto &od : odPairs) {
+            if (groupOfOrigin[od.origin] == -1) {
+                groupOfOrigin[od.origin] = firstPairOfGroup.size() - 1;
+                firstPairOfGroup.push_back(0);
+            }
+            ++firstPairOfGroup[groupOfOrigin[od.origin] + 1];
+        }
+        for (auto g = 1; g < firstPairOfGroup.size(); ++g)
+            firstPairOfGroup[g] += firstPairOfGroup[g - 1];
+        pairsByOrigin.resize(odPairs.size());
+        std::vector<int> nextPos(firstPairOfGroup.begin(), firstPairOfGroup.end() - 1);
+        for (auto i = 0; i < odPairs.size(); ++i)
+            pairsByOrigin[nextPos[groupOfOrigin[odPairs[i].origin]]++] = i;
+    }
+
+    // Processes every skipInterval-th OD pair, K pairs at a time. Returns the number of processed
+    // pairs that were sampled in the previous iteration.
+    int assignODPairsInBatches(const int skipInterval) {
+        ProgressBar bar(std::ceil(1.0 * odPairs.size() / (K * skipInterval)), veryVerbose);
+        auto totalNumPairsSampledBefore = 0;
+#pragma omp parallel
+        {
+            auto queryAlgo = shortestPathAlgo.getQueryAlgoInstance();
+            LocalDistanceStats localStats;
+
+#pragma omp for schedule(dynamic, 4096 / K) nowait
+            for (auto i = 0; i < odPairs.size(); i += K * skipInterval) {
+                std::array<int, K> pairs;
+                auto k = 0;
+                for (; k < K && i + k * skipInterval < odPairs.size(); ++k)
+                    pairs[k] = i + k * skipInterval;
+                runBatch(queryAlgo, pairs, k, localStats);
+                ++bar;
+            }
+
+#pragma omp critical (combineResults)
+            {
+                queryAlgo.addLocalToGlobalFlows();
+                totalNumPairsSampledBefore += addToGlobalStats(localStats);
+            }
+        }
+        bar.finish();
+        return totalNumPairsSampledBefore;
+    }
+
+    // Processes every skipInterval-th OD pair, handing all sampled pairs sharing an origin to a
+    // single one-to-many query. Origins with a single sampled pair are batched K at a time. Returns
+    // the number of processed pairs that were sampled in the previous iteration.
+    int assignODPairsGroupedByOrigin(const int skipInterval) {
+        const int numGroups = firstPairOfGroup.size() - 1;
+        ProgressBar bar(numGroups, veryVerbose);
+        auto totalNumPairsSampledBefore = 0;
+#pragma omp parallel
+        {
+            auto queryAlgo = shortestPathAlgo.getQueryAlgoInstance();
+            LocalDistanceStats localStats;
+            std::vector<int> pairs;       // The sampled OD pairs sharing the current origin.
+            std::vector<int> targets;     // The destinations of the sampled OD pairs.
+            std::vector<int> weights;     // The weights of the sampled OD pairs.
+            std::array<int, K> batch;     // OD pairs whose origin has a single sampled pair.
+            auto batchSize = 0;
+
+#pragma omp for schedule(dynamic, 64) nowait
+            for (auto g = 0; g < numGroups; ++g) {
+                pairs.clear();
+                targets.clear();
+                weights.clear();
+                for (auto idx = firstPairOfGroup[g]; idx < firstPairOfGroup[g + 1]; ++idx) {
+                    const auto i = pairsByOrigin[idx];
+                    if (i % skipInterval == 0) {
+                        pairs.push_back(i);
+                        targets.push_back(odPairs[i].destination);
+                        weights.push_back(odPairs[i].weight);
+                    }
+                }
+
+                if (pairs.size() > 1) {
+                    queryAlgo.runOneToMany(odPairs[pairs[0]].origin, targets, weights);
+                    for (auto j = 0; j < pairs.size(); ++j)
+                        recordDistance(pairs[j], queryAlgo.getDistance(targets[j], j), localStats);
+                } else if (pairs.size() == 1) {
+                    batch[batchSize++] = pairs[0];
+                    if (batchSize == K) {
+                        runBatch(queryAlgo, batch, K, localStats);
+                        batchSize = 0;
+                    }
+                }
+                ++bar;
+            }
+            if (batchSize > 0)
+                runBatch(queryAlgo, batch, batchSize, localStats);
+
+#pragma omp critical (combineResults)
+            {
+                queryAlgo.addLocalToGlobalFlows();
+                totalNumPairsSampledBefore += addToGlobalStats(localStats);
+            }
+        }
+        bar.finish();
+        return totalNumPairsSampledBefore;
+    }
+
+    // Runs multiple shortest-path computations simultaneously, one for each of the first k
+    // specified OD pairs.
+    void runBatch(QueryAlgo &queryAlgo, const std::array<int, K> &pairs, const int k,
+                  LocalDistanceStats &localStats) {
+        std::array<int, K> sources;
+        std::array<int, K> targets;
+        std::array<int, K> weights;
+        sources.fill(odPairs[pairs[0]].origin);
+        targets.fill(odPairs[pairs[0]].destination);
+        weights.fill(0);
+        for (auto j = 0; j < k; ++j) {
+            sources[j] = odPairs[pairs[j]].origin;
+            targets[j] = odPairs[pairs[j]].destination;
+            weights[j] = odPairs[pairs[j]].weight;
+        }
+        queryAlgo.run(sources, targets, weights, k);
+
+        for (auto j = 0; j < k; ++j)
+            recordDistance(pairs[j], queryAlgo.getDistance(odPairs[pairs[j]].destination, j), localStats);
+    }
+
+    // Records the new distance for the i-th OD pair. The statistics count the distance once per trip
+    // represented by the pair.
+    void recordDistance(const int i, const int dist, LocalDistanceStats &localStats) {
+        // Maintain the avg and max change in the OD distances between the last two iterations.
+        const auto weight = odPairs[i].weight;
+        const auto prevDist = stats.lastDistances[i];
+        const auto change = 1.0 * std::abs(dist - prevDist) / prevDist;
+        localStats.numPairsSampledBefore += prevDist != -1 ? weight : 0;
+        localStats.checksum += int64_t{weight} * dist;
+        localStats.prevMinPathCost += prevDist != -1 ? int64_t{weight} * dist : 0;
+        stats.lastDistances[i] = dist;
+        localStats.avgChange += weight * std::max(0.0, change);
+        localStats.maxChange = std::max(localStats.maxChange, change);
+    }
+
+    // Adds the local statistics of a thread to the global ones. Must be synchronized externally.
+    // Returns the number of pairs that were sampled in the previous iteration.
+    int addToGlobalStats(const LocalDistanceStats &localStats) {
+        stats.lastChecksum += localStats.checksum;
+        stats.prevMinPathCost += localStats.prevMinPathCost;
+        stats.avgChangeInDistances += localStats.avgChange;
+        stats.maxChangeInDistances = std::max(stats.maxChangeInDistances, localStats.maxChange);
+        return localStats.numPairsSampledBefore;
+    }
+
     ShortestPathAlgoT shortestPathAlgo; // Algorithm computing shortest paths between OD pairs.
     const InputGraph &inputGraph;       // The input graph.
     const ODPairs &odPairs;             // The OD pairs to be assigned onto the graph.
+    std::vector<int> pairsByOrigin;     // The indices of the OD pairs, grouped by origin.
+    std::vector<int> firstPairOfGroup;  // The index in pairsByOrigin of the first pair of each group.
     AlignedVector<int> trafficFlows;    // The traffic flows on the edges.
     const bool verbose;                 // Should informative messages be displayed?
     const bool veryVerbose;                      // Should information on progress of each iteration be displayed?
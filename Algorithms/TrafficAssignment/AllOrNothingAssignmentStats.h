@@ -1,8 +1,12 @@
 #pragma once
 
 #include <cstdint>
+#include <fstream>
 #include <vector>
 
+#include "Tools/BinaryIO.h"
+#include "Tools/PerfCounters.h"
+
 // Statistics about an iterative all-or-nothing assignment, including checksums and running times.
 struct AllOrNothingAssignmentStats {
   // Constructs a struct collecting statistics about an iterative all-or-nothing assignment.
@@ -37,6 +41,31 @@ struct AllOrNothingAssignmentStats {
     totalCustomizationTime += lastCustomizationTime;
     totalQueryTime += lastQueryTime;
     totalRoutingTime += lastRoutingTime;
+    totalCustomizationPerf += lastCustomizationPerf;
+    totalQueryPerf += lastQueryPerf;
+    totalNumQueries += lastNumQueries;
+  }
+
+  // Reads the values carried over between iterations from the specified binary file.
+  void readFrom(std::ifstream& in) {
+    bio::read(in, totalChecksum);
+    bio::read(in, lastDistances);
+    bio::read(in, totalPreprocessingTime);
+    bio::read(in, totalCustomizationTime);
+    bio::read(in, totalQueryTime);
+    bio::read(in, totalRoutingTime);
+    bio::read(in, numIterations);
+  }
+
+  // Writes the values carried over between iterations to the specified binary file.
+  void writeTo(std::ofstream& out) const {
+    bio::write(out, totalChecksum);
+    bio::write(out, lastDistances);
+    bio::write(out, totalPreprocessingTime);
+    bio::write(out, totalCustomizationTime);
+    bio::write(out, totalQueryTime);
+    bio::write(out, totalRoutingTime);
+    bio::write(out, numIterations);
   }
 
   int64_t lastChecksum;    // The sum of the distances computed in the last iteration.
@@ -57,4 +86,14 @@ struct AllOrNothingAssignmentStats {
   int totalRoutingTime;       // The total time spent on routing.
 
   int numIterations; // The number of iterations performed.
+
+  // The hardware events counted in each phase. They are only counted if USE_PERF_COUNTERS is
+  // defined, and are not carried over between runs.
+  PerfCounts lastCustomizationPerf;  // The events during customization in the last iteration.
+  PerfCounts lastQueryPerf;          // The events during queries in the last iteration.
+  PerfCounts totalPreprocessingPerf; // The events during preprocessing.
+  PerfCounts totalCustomizationPerf; // The total events during customization.
+  PerfCounts totalQueryPerf;         // The total events during queries.
+  int64_t lastNumQueries = 0;        // The number of OD pairs processed in the last iteration.
+  int64_t totalNumQueries = 0;       // The total number of OD pairs processed.
 };
@@ -2,19 +2,28 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "Algorithms/CCH/CCH.h"
 #include "Algorithms/TrafficAssignment/ObjectiveFunctions/SystemOptimum.h"
 #include "Algorithms/TrafficAssignment/ObjectiveFunctions/UserEquilibrium.h"
 #include "Algorithms/TrafficAssignment/AllOrNothingAssignment.h"
 #include "Algorithms/TrafficAssignment/UnivariateMinimization.h"
 #include "DataStructures/Graph/Attributes/TraversalCostAttribute.h"
 #include "DataStructures/Graph/Graph.h"
+#include "DataStructures/Partitioning/SeparatorDecomposition.h"
 #include "DataStructures/Utilities/OriginDestination.h"
 #include "FrankWolfeAssignmentStats.h"
+#include "Tools/BinaryIO.h"
+#include "Tools/ColumnarFile.h"
 #include "Tools/Math.h"
+#include "Tools/PerfCounters.h"
 #include "Tools/Timer.h"
 
 // A traffic assignment procedure based on the Frank-Wolfe method (also known as convex combinations
@@ -28,10 +37,15 @@ class FrankWolfeAssignment {
  public:
   using Graph = GraphT;
 
-  // Constructs an assignment procedure based on the Frank-Wolfe method.
+  // Constructs an assignment procedure based on the Frank-Wolfe method. If a separator
+  // decomposition is specified, shortest-path algorithms based on one skip computing their own.
+  // Otherwise, they use the specified balance parameters and number of rotations for inertial flow.
+  // The OD pairs may be reordered up until the first call to run().
   FrankWolfeAssignment(Graph& graph, const std::vector<ClusteredOriginDestination>& odPairs,
-                       const bool verbose = true, const bool veryVerbose = false)
-      : aonAssignment(graph, odPairs, verbose, veryVerbose),
+                       const bool verbose = true, const bool veryVerbose = false,
+                       const SeparatorDecomposition* sepDecomp = nullptr,
+                       const std::vector<int>& balances = {30}, const int numRotations = 1)
+      : aonAssignment(graph, odPairs, verbose, veryVerbose, sepDecomp, balances, numRotations),
         graph(graph),
         trafficFlows(graph.numEdges()),
         pointOfSight(graph.numEdges()),
@@ -43,47 +57,136 @@ class FrankWolfeAssignment {
     stats.totalRunningTime = aonAssignment.stats.totalRoutingTime;
   }
 
-  // Assigns all OD flows onto the graph.
+  // Returns the CCH used by the shortest-path algorithm, or nullptr if it does not use one.
+  const CCH* getCCH() const {
+    return aonAssignment.getCCH();
+  }
+
+  // Writes the flow patterns and OD distances in binary columnar format to the specified writers
+  // instead of the CSV files passed to run(). Either writer may be null.
+  void setBinaryOutput(columnar::AsyncWriter* flowOut, columnar::AsyncWriter* distOut) {
+    flowWriter = flowOut;
+    distWriter = distOut;
+  }
+
+  // Seeds the assignment with the specified edge flows, e.g., the equilibrium flows of a previous
+  // scenario on the same network. The initial all-or-nothing assignment is skipped.
+  void warmStart(const std::vector<double>& flows) {
+    assert(flows.size() == graph.numEdges());
+    assert(aonAssignment.stats.numIterations == 0);
+    trafficFlows = flows;
+    hasInitialSolution = true;
+  }
+
+  // The magic number and the version identifying checkpoint files.
+  static constexpr uint32_t CHECKPOINT_MAGIC_NUMBER = 0x46574331;
+  static constexpr int32_t CHECKPOINT_VERSION = 1;
+
+  // The sizes in bytes of the flow, distance and statistics output when a checkpoint was written,
+  // or -1 for each output that was not written. A resumed assignment truncates its outputs to these
+  // sizes, so that the iterations after the checkpoint are not written twice.
+  struct OutputSizes {
+    int64_t flow = -1;
+    int64_t dist = -1;
+    int64_t stat = -1;
+  };
+
+  // Restores the state of an interrupted assignment from the specified checkpoint file. Returns the
+  // sizes of the outputs when the checkpoint was written.
+  OutputSizes readCheckpointFrom(std::ifstream& in) {
+    uint32_t magic = 0;
+    int32_t version = 0;
+    in.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!in.good() || magic != CHECKPOINT_MAGIC_NUMBER)
+      throw std::invalid_argument("not a checkpoint file");
+    if (version != CHECKPOINT_VERSION)
+      throw std::invalid_argument("unsupported checkpoint version -- '" + std::to_string(version) + "'");
+    int numEdges;
+    bio::read(in, numEdges);
+    if (!in.good() || numEdges != graph.numEdges())
+      throw std::invalid_argument("checkpoint does not match the network");
+    OutputSizes sizes;
+    bio::read(in, sizes.flow);
+    bio::read(in, sizes.dist);
+    bio::read(in, sizes.stat);
+    bio::read(in, prevSkipInterval);
+    bio::read(in, hasPointOfSight);
+    stats.readFrom(in);
+    aonAssignment.stats.readFrom(in);
+    bio::read(in, trafficFlows);
+    bio::read(in, pointOfSight);
+    if (!in.good() || in.peek() != std::ifstream::traits_type::eof())
+      throw std::invalid_argument("truncated or corrupt checkpoint");
+    if (trafficFlows.size() != graph.numEdges() || pointOfSight.size() != graph.numEdges())
+      throw std::invalid_argument("checkpoint does not match the network");
+    if (aonAssignment.stats.lastDistances.size() != aonAssignment.numODPairs())
+      throw std::invalid_argument("checkpoint does not match the OD pairs");
+    hasInitialSolution = true;
+    return sizes;
+  }
+
+  // Writes the state of the assignment after the last iteration to the specified checkpoint file,
+  // together with the current sizes of the outputs.
+  void writeCheckpointTo(std::ofstream& out, const OutputSizes& sizes) const {
+    bio::write(out, CHECKPOINT_MAGIC_NUMBER);
+    bio::write(out, CHECKPOINT_VERSION);
+    bio::write(out, graph.numEdges());
+    bio::write(out, sizes.flow);
+    bio::write(out, sizes.dist);
+    bio::write(out, sizes.stat);
+    bio::write(out, prevSkipInterval);
+    bio::write(out, hasPointOfSight);
+    stats.writeTo(out);
+    aonAssignment.stats.writeTo(out);
+    bio::write(out, trafficFlows);
+    bio::write(out, pointOfSight);
+  }
+
+  // Assigns all OD flows onto the graph. If a checkpoint file is given, the state of the assignment
+  // is written to it every checkpointInterval iterations.
   void run(
       std::ofstream& flowFile, std::ofstream& distFile, std::ofstream& statFile,
-      const int numIterations = 0, const bool outputIntermediates = false) {
+      const int numIterations = 0, const bool outputIntermediates = false,
+      const std::string& checkpointFileName = "", const int checkpointInterval = 0) {
     assert(numIterations >= 0);
-    Timer timer;
-    auto prevSkipInterval = 1u;
-    determineInitialSolution(prevSkipInterval);
-    stats.lastRunningTime = timer.elapsed();
-    stats.lastLineSearchTime = stats.lastRunningTime - aonAssignment.stats.lastRoutingTime;
-    stats.finishIteration();
-
-    if (flowFile.is_open())
-      FORALL_EDGES(graph, e) {
-        const auto vol = trafficFlows[e];
-        const auto sat = vol / graph.capacity(e);
-        flowFile << aonAssignment.stats.numIterations << ',' << vol << ',' << sat << '\n';
-      }
+    assert(checkpointInterval >= 0);
+    if (!hasInitialSolution) {
+      Timer timer;
+      PerfMeter perfMeter;
+      determineInitialSolution(prevSkipInterval);
+      stats.lastRunningTime = timer.elapsed();
+      stats.lastLineSearchTime = stats.lastRunningTime - aonAssignment.stats.lastRoutingTime;
+      stats.lastLineSearchPerf = perfMeter.elapsed() - aonAssignment.stats.lastCustomizationPerf -
+          aonAssignment.stats.lastQueryPerf;
+      stats.finishIteration();
+      hasInitialSolution = true;
 
-    if (distFile.is_open())
-      for (const auto dist : aonAssignment.stats.lastDistances)
-        distFile << aonAssignment.stats.numIterations << ',' << dist << '\n';
+      writeFlowPattern(flowFile);
+      writeDistances(distFile);
 
-    if (statFile.is_open()) {
-      statFile << aonAssignment.stats.numIterations << ",";
-      statFile << aonAssignment.stats.lastCustomizationTime << ",";
-      statFile << aonAssignment.stats.lastQueryTime << ",";
-      statFile << stats.lastLineSearchTime << "," << stats.lastRunningTime << ",nan,nan,";
-      statFile << aonAssignment.stats.lastChecksum << std::endl;
-    }
+      if (statFile.is_open()) {
+        statFile << aonAssignment.stats.numIterations << ",";
+        statFile << aonAssignment.stats.lastCustomizationTime << ",";
+        statFile << aonAssignment.stats.lastQueryTime << ",";
+        statFile << stats.lastLineSearchTime << "," << stats.lastRunningTime << ",nan,nan,";
+        statFile << aonAssignment.stats.lastChecksum << std::endl;
+      }
 
-    if (verbose) {
-      std::cout << "  Line search: " << stats.lastLineSearchTime << "ms";
-      std::cout << "  Total: " << stats.lastRunningTime << "ms\n";
-      std::cout << std::flush;
+      if (verbose) {
+        std::cout << "  Line search: " << stats.lastLineSearchTime << "ms";
+        std::cout << "  Total: " << stats.lastRunningTime << "ms\n";
+        if constexpr (PERF_COUNTERS_ENABLED)
+          AonAssignment::printPerfCounts("line search", stats.lastLineSearchPerf);
+        std::cout << std::flush;
+      }
     }
 
     while ((numIterations != 0 || stats.prevRelGap > 1e-4 || prevSkipInterval > 1) &&
            (numIterations == 0 || aonAssignment.stats.numIterations < numIterations)) {
       stats.startIteration();
       Timer timer;
+      PerfMeter perfMeter;
       const unsigned int skip = std::min(std::max(stats.prevRelGap / 1e-4, 1.0), double{-1u});
       const auto skipInterval = std::min(roundDownToPowerOfTwo(skip), prevSkipInterval);
       updateTraversalCosts();
@@ -95,19 +198,15 @@ class FrankWolfeAssignment {
       prevSkipInterval = skipInterval;
       stats.lastRunningTime = timer.elapsed();
       stats.lastLineSearchTime = stats.lastRunningTime - aonAssignment.stats.lastRoutingTime;
+      stats.lastLineSearchPerf = perfMeter.elapsed() - aonAssignment.stats.lastCustomizationPerf -
+          aonAssignment.stats.lastQueryPerf;
       stats.prevRelGap = 1 - prevMinPathCost / stats.prevTotalPathCost;
       stats.finishIteration();
 
-      if (flowFile.is_open() && outputIntermediates)
-        FORALL_EDGES(graph, e) {
-          const auto vol = trafficFlows[e];
-          const auto sat = vol / graph.capacity(e);
-          flowFile << aonAssignment.stats.numIterations << ',' << vol << ',' << sat << '\n';
-        }
-
-      if (distFile.is_open() && outputIntermediates)
-        for (const auto dist : aonAssignment.stats.lastDistances)
-          distFile << aonAssignment.stats.numIterations << ',' << dist << '\n';
+      if (outputIntermediates) {
+        writeFlowPattern(flowFile);
+        writeDistances(distFile);
+      }
 
       if (statFile.is_open()) {
         statFile << aonAssignment.stats.numIterations << ",";
@@ -123,20 +222,20 @@ class FrankWolfeAssignment {
         std::cout << "  Total: " << stats.lastRunningTime << "ms\n";
         std::cout << "  Prev total traversal cost: " << stats.prevTotalTraversalCost << "\n";
         std::cout << "  Prev relative gap: " << stats.prevRelGap << "\n";
+        if constexpr (PERF_COUNTERS_ENABLED)
+          AonAssignment::printPerfCounts("line search", stats.lastLineSearchPerf);
         std::cout << std::flush;
       }
-    }
 
-    if (flowFile.is_open() && !outputIntermediates)
-      FORALL_EDGES(graph, e) {
-        const auto vol = trafficFlows[e];
-        const auto sat = vol / graph.capacity(e);
-        flowFile << aonAssignment.stats.numIterations << ',' << vol << ',' << sat << '\n';
-      }
+      if (!checkpointFileName.empty() && checkpointInterval > 0 &&
+          aonAssignment.stats.numIterations % checkpointInterval == 0)
+        writeCheckpoint(checkpointFileName, currentOutputSizes(flowFile, distFile, statFile));
+    }
 
-    if (distFile.is_open() && !outputIntermediates)
-      for (const auto dist : aonAssignment.stats.lastDistances)
-        distFile << aonAssignment.stats.numIterations << ',' << dist << '\n';
+    if (!outputIntermediates) {
+      writeFlowPattern(flowFile);
+      writeDistances(distFile);
+    }
 
     if (verbose) {
       std::cout << "Total:\n";
@@ -147,6 +246,14 @@ class FrankWolfeAssignment {
       std::cout << "  Routing: " << aonAssignment.stats.totalRoutingTime << "ms\n";
       std::cout << "  Line search: " << stats.totalLineSearchTime << "ms";
       std::cout << "  Total: " << stats.totalRunningTime << "ms\n";
+      if constexpr (PERF_COUNTERS_ENABLED) {
+        const auto& aonStats = aonAssignment.stats;
+        AonAssignment::printPerfCounts("prepro", aonStats.totalPreprocessingPerf);
+        AonAssignment::printPerfCounts("custom", aonStats.totalCustomizationPerf);
+        AonAssignment::printPerfCounts("queries", aonStats.totalQueryPerf);
+        AonAssignment::printPerfCounts("per query", aonStats.totalQueryPerf, aonStats.totalNumQueries);
+        AonAssignment::printPerfCounts("line search", stats.totalLineSearchPerf);
+      }
       std::cout << std::flush;
     }
   }
@@ -171,6 +278,80 @@ class FrankWolfeAssignment {
       trafficFlows[e] = aonAssignment.trafficFlowOn(e);
   }
 
+  // Writes a checkpoint to the specified file. The checkpoint is first written to a temporary file
+  // that then replaces the old checkpoint, so that an interruption never leaves a truncated file.
+  void writeCheckpoint(const std::string& fileName, const OutputSizes& sizes) const {
+    const auto tmpFileName = fileName + ".tmp";
+    std::ofstream out(tmpFileName, std::ios::binary);
+    if (!out.good())
+      throw std::invalid_argument("file cannot be opened -- '" + tmpFileName + "'");
+    writeCheckpointTo(out, sizes);
+    out.close();
+    if (!out.good()) {
+      std::remove(tmpFileName.c_str());
+      throw std::invalid_argument("file cannot be written -- '" + tmpFileName + "'");
+    }
+    if (std::rename(tmpFileName.c_str(), fileName.c_str()) != 0)
+      throw std::invalid_argument("file cannot be renamed -- '" + tmpFileName + "'");
+  }
+
+  // Returns the current sizes of the outputs, after everything buffered has been written.
+  OutputSizes currentOutputSizes(std::ofstream& flowFile, std::ofstream& distFile, std::ofstream& statFile) {
+    const auto sizeOf = [](std::ofstream& file) -> int64_t {
+      if (!file.is_open())
+        return -1;
+      file.flush();
+      return file.tellp();
+    };
+    OutputSizes sizes;
+    sizes.flow = flowWriter != nullptr ? flowWriter->size() : sizeOf(flowFile);
+    sizes.dist = distWriter != nullptr ? distWriter->size() : sizeOf(distFile);
+    sizes.stat = sizeOf(statFile);
+    return sizes;
+  }
+
+  // Writes the current flow pattern to the binary flow writer if one is set, and to the specified
+  // file if it is open otherwise.
+  void writeFlowPattern(std::ofstream& flowFile) {
+    if (flowWriter != nullptr) {
+      auto& block = flowWriter->nextBlock(aonAssignment.stats.numIterations, graph.numEdges());
+      float* const vol = block.floatColumn(0);
+      float* const sat = block.floatColumn(1);
+      #pragma omp parallel for schedule(static)
+      FORALL_EDGES(graph, e) {
+        vol[e] = trafficFlows[e];
+        sat[e] = trafficFlows[e] / graph.capacity(e);
+      }
+      flowWriter->submit();
+    } else if (flowFile.is_open()) {
+      FORALL_EDGES(graph, e) {
+        const auto vol = trafficFlows[e];
+        const auto sat = vol / graph.capacity(e);
+        flowFile << aonAssignment.stats.numIterations << ',' << vol << ',' << sat << '\n';
+      }
+    }
+  }
+
+  // Writes the OD distances from the last iteration to the binary distance writer if one is set,
+  // and to the specified file if it is open otherwise. There is one row per trip.
+  void writeDistances(std::ofstream& distFile) {
+    const auto& lastDistances = aonAssignment.stats.lastDistances;
+    if (distWriter != nullptr) {
+      auto numTrips = 0;
+      for (auto i = 0; i < lastDistances.size(); ++i)
+        numTrips += aonAssignment.odPairWeight(i);
+      auto& block = distWriter->nextBlock(aonAssignment.stats.numIterations, numTrips);
+      int32_t* dist = block.intColumn(0);
+      for (auto i = 0; i < lastDistances.size(); ++i)
+        dist = std::fill_n(dist, aonAssignment.odPairWeight(i), lastDistances[i]);
+      distWriter->submit();
+    } else if (distFile.is_open()) {
+      for (auto i = 0; i < lastDistances.size(); ++i)
+        for (auto j = 0; j < aonAssignment.odPairWeight(i); ++j)
+          distFile << aonAssignment.stats.numIterations << ',' << lastDistances[i] << '\n';
+    }
+  }
+
   // Updates traversal costs.
   void updateTraversalCosts() {
     auto totalTraversalCost = 0.0, totalPathCost = 0.0;
@@ -188,9 +369,10 @@ class FrankWolfeAssignment {
   void findDescentDirection(const int skipInterval) {
     aonAssignment.run(skipInterval);
 #ifndef TA_NO_CFW
-    if (aonAssignment.stats.numIterations == 2) {
+    if (!hasPointOfSight) {
       FORALL_EDGES(graph, e)
         pointOfSight[e] = aonAssignment.trafficFlowOn(e);
+      hasPointOfSight = true;
       return;
     }
 
@@ -249,6 +431,11 @@ class FrankWolfeAssignment {
   std::vector<double> pointOfSight;            // The point defining the descent direction d = s - x
   TraversalCostFunction traversalCostFunction; // A functor returning the traversal cost of an edge.
   ObjFunction objFunction;                     // The objective function to be minimized (UE or SO).
+  unsigned int prevSkipInterval = 1;           // The skip interval used in the previous iteration.
+  bool hasInitialSolution = false;             // Is there an initial solution (e.g., a warm start)?
+  bool hasPointOfSight = false;                // Has the point of sight been initialized?
+  columnar::AsyncWriter* flowWriter = nullptr; // The binary writer for the flow patterns, if any.
+  columnar::AsyncWriter* distWriter = nullptr; // The binary writer for the OD distances, if any.
   const bool verbose;                          // Should informative messages be displayed?
   const bool veryVerbose;                      // Should information on progress of each iteration be displayed?
 };
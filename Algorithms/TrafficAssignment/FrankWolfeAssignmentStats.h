@@ -1,7 +1,11 @@
 #pragma once
 
+#include <fstream>
 #include <limits>
 
+#include "Tools/BinaryIO.h"
+#include "Tools/PerfCounters.h"
+
 // Statistics about a Frank-Wolfe assignment, including times and measures of solution quality.
 struct FrankWolfeAssignmentStats {
   // Constructs a struct collecting statistics about a Frank-Wolfe assignment.
@@ -24,6 +28,21 @@ struct FrankWolfeAssignmentStats {
   void finishIteration() {
     totalLineSearchTime += lastLineSearchTime;
     totalRunningTime += lastRunningTime;
+    totalLineSearchPerf += lastLineSearchPerf;
+  }
+
+  // Reads the values carried over between iterations from the specified binary file.
+  void readFrom(std::ifstream& in) {
+    bio::read(in, prevRelGap);
+    bio::read(in, totalLineSearchTime);
+    bio::read(in, totalRunningTime);
+  }
+
+  // Writes the values carried over between iterations to the specified binary file.
+  void writeTo(std::ofstream& out) const {
+    bio::write(out, prevRelGap);
+    bio::write(out, totalLineSearchTime);
+    bio::write(out, totalRunningTime);
   }
 
   double prevTotalTraversalCost; // The total traversal cost after the previous iteration.
@@ -35,4 +54,9 @@ struct FrankWolfeAssignmentStats {
 
   int totalLineSearchTime; // The total time spent on the line search.
   int totalRunningTime;    // The total running time.
+
+  // The hardware events counted during the line search. They are only counted if USE_PERF_COUNTERS
+  // is defined, and are not carried over between runs.
+  PerfCounts lastLineSearchPerf;  // The events during the line search in the last iteration.
+  PerfCounts totalLineSearchPerf; // The total events during the line search.
 };
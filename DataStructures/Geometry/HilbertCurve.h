@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+#include "DataStructures/Geometry/LatLng.h"
+
+// Returns the index of the cell (x, y) along a Hilbert curve through a 2^32 x 2^32 grid.
+inline uint64_t hilbertCurveIndex(uint32_t x, uint32_t y) {
+  uint64_t idx = 0;
+  for (uint64_t s = uint64_t{1} << 31; s > 0; s >>= 1) {
+    const uint32_t rx = (x & s) > 0;
+    const uint32_t ry = (y & s) > 0;
+    idx += s * s * ((3 * rx) ^ ry);
+    // Rotate the quadrant so that the curve is continuous.
+    if (ry == 0) {
+      if (rx == 1) {
+        x = ~x;
+        y = ~y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return idx;
+}
+
+// Returns the index of the specified coordinate along a Hilbert curve through the whole globe.
+// Nearby coordinates tend to have close indices.
+inline uint64_t hilbertCurveIndex(const LatLng& latLng) {
+  // Shift the coordinates into the nonnegative range, and scale them to fill most of the grid.
+  const uint32_t x = latLng.longitude() + LatLng::DEG_180;
+  const uint32_t y = latLng.latitude() + LatLng::DEG_90;
+  return hilbertCurveIndex(x << 2, y << 2);
+}
@@ -5,13 +5,18 @@
 #include <cstdint>
 #include <iterator>
 #include <limits>
+#include <utility>
 #include <vector>
 
 #include "DataStructures/Geometry/Point.h"
 #include "DataStructures/Geometry/Rectangle.h"
 #include "Tools/Constants.h"
 
-// A kd-tree for the problem of finding nearest neighbors.
+// A kd-tree for the problem of finding nearest neighbors. The points in each leaf are stored as a
+// block of x-coordinates followed by a block of y-coordinates, so that the distances from the query
+// point to all points in a leaf can be computed by SIMD instructions. The tree is traversed without
+// recursion, and the traversal state is local to each query, so multiple threads can query the
+// tree concurrently.
 class KDTree {
  public:
   // Constructs a kd-tree that stores the specified set of points.
@@ -20,17 +25,89 @@ class KDTree {
   }
 
   // Returns the point that is closest to the query point while being no farther than maxDist.
-  int findClosestPoint(const Point& query, int32_t maxDist = std::numeric_limits<int32_t>::max()) {
+  int findClosestPoint(
+      const Point& query, int32_t maxDist = std::numeric_limits<int32_t>::max()) const {
     assert(maxDist >= 0);
-    queryPoint = query;
-    boundingBox = {{-INFTY, -INFTY}, {INFTY, INFTY}};
-    closestPoint = INVALID_ID;
-    distToClosestPoint = int64_t{maxDist} * maxDist + 1;
-    findClosestPoint(tree.front());
-    assert(boundingBox == Rectangle(Point(-INFTY, -INFTY), Point(INFTY, INFTY)));
+    auto closestPoint = INVALID_ID;
+    auto distToClosestPoint = int64_t{maxDist} * maxDist + 1;
+    traverse(query, [&](const Node& leaf, const int64_t* const dists) {
+      // Padding repeats the last record, so we can take the minimum over the whole block.
+      auto minDist = dists[0];
+      for (auto i = 1; i < BUCKET_SIZE; ++i)
+        minDist = std::min(minDist, dists[i]);
+      if (minDist < distToClosestPoint) {
+        auto i = 0;
+        while (dists[i] != minDist) ++i;
+        closestPoint = ids[leaf.firstRecord + i];
+        distToClosestPoint = minDist;
+      }
+      return distToClosestPoint;
+    }, distToClosestPoint);
     return closestPoint;
   }
 
+  // Returns the same point as findClosestPoint, but searches the tree recursively and maintains
+  // the bounding box of the current node explicitly. Serves as a baseline in benchmarks.
+  int findClosestPointRecursively(
+      const Point& query, int32_t maxDist = std::numeric_limits<int32_t>::max()) const {
+    assert(maxDist >= 0);
+    QueryState state;
+    state.queryPoint = query;
+    state.boundingBox = {{-INFTY, -INFTY}, {INFTY, INFTY}};
+    state.closestPoint = INVALID_ID;
+    state.distToClosestPoint = int64_t{maxDist} * maxDist + 1;
+    findClosestPointRecursively(tree.front(), state);
+    assert(state.boundingBox == Rectangle(Point(-INFTY, -INFTY), Point(INFTY, INFTY)));
+    return state.closestPoint;
+  }
+
+  // Returns the k points that are closest to the query point while being no farther than maxDist,
+  // ordered by increasing distance. Returns fewer points if there are not enough such points.
+  std::vector<int> findKClosestPoints(
+      const Point& query, const int k,
+      int32_t maxDist = std::numeric_limits<int32_t>::max()) const {
+    assert(k >= 0); assert(maxDist >= 0);
+    std::vector<std::pair<int64_t, int>> heap; // A max-heap of the k closest points so far.
+    heap.reserve(k + 1);
+    auto bound = int64_t{maxDist} * maxDist + 1;
+    if (k > 0) {
+      traverse(query, [&](const Node& leaf, const int64_t* const dists) {
+        for (auto i = 0; i < leaf.lastRecord - leaf.firstRecord; ++i) {
+          if (dists[i] < bound) {
+            heap.emplace_back(dists[i], ids[leaf.firstRecord + i]);
+            std::push_heap(heap.begin(), heap.end());
+            if (heap.size() > k) {
+              std::pop_heap(heap.begin(), heap.end());
+              heap.pop_back();
+            }
+            if (heap.size() == k)
+              bound = heap.front().first;
+          }
+        }
+        return bound;
+      }, bound);
+    }
+    std::sort_heap(heap.begin(), heap.end());
+    std::vector<int> closestPoints(heap.size());
+    for (auto i = 0; i < heap.size(); ++i)
+      closestPoints[i] = heap[i].second;
+    return closestPoints;
+  }
+
+  // Returns all points that are no farther than radius from the query point, in arbitrary order.
+  std::vector<int> findPointsWithinRadius(const Point& query, const int32_t radius) const {
+    assert(radius >= 0);
+    std::vector<int> points;
+    const auto bound = int64_t{radius} * radius + 1;
+    traverse(query, [&](const Node& leaf, const int64_t* const dists) {
+      for (auto i = 0; i < leaf.lastRecord - leaf.firstRecord; ++i)
+        if (dists[i] < bound)
+          points.push_back(ids[leaf.firstRecord + i]);
+      return bound;
+    }, bound);
+    return points;
+  }
+
  private:
   // A (leaf or interior) node in the kd-tree.
   struct Node {
@@ -47,13 +124,30 @@ class KDTree {
     };
   };
 
+  // An entry on the traversal stack, i.e., a node together with the distance from the query point
+  // to its record space. The distance is maintained incrementally, as proposed by Arya and Mount.
+  struct StackEntry {
+    int32_t node;       // The index of the node.
+    int64_t offsets[2]; // The distance from the query point to the record space in each dimension.
+    int64_t dist;       // The squared distance from the query point to the record space.
+  };
+
+  // The state of a recursive nearest-neighbor query.
+  struct QueryState {
+    Point queryPoint;           // The query point for which we search the nearest neighbor.
+    Rectangle boundingBox;      // The bounds of the record space represented by the current node.
+    int closestPoint;           // The closest point so far encountered.
+    int64_t distToClosestPoint; // The distance to the closest point.
+  };
+
   // A record in the kd-tree, i.e., a point together with its ID.
   struct Record {
     int32_t id;
     Point coordinates;
   };
 
-  static constexpr int BUCKET_SIZE = 16; // The number of records per bucket.
+  static constexpr int BUCKET_SIZE = 16;          // The number of records per bucket.
+  static constexpr int MAX_LOCAL_STACK_SIZE = 64; // The maximum height with a fixed-size stack.
 
   // Builds a kd-tree that stores the specified set of points.
   void buildKDTree(const std::vector<Point>& points) {
@@ -73,19 +167,50 @@ class KDTree {
       return a.coordinates.y() < b.coordinates.y();
     });
 
-    buildKDTree(0, recordsByX.size() - 1, 0);
-    recordsByX.swap(buckets);
+    height = 0;
+    buildKDTree(0, recordsByX.size() - 1, 0, 1);
     recordsByY = std::vector<Record>();
     tmpStorage = std::vector<Record>();
-    buckets.pop_back();
+    storeLeavesAsBlocks();
+    recordsByX = std::vector<Record>();
+  }
+
+  // Stores the records in each leaf as a block of BUCKET_SIZE x-coordinates, followed by a block of
+  // BUCKET_SIZE y-coordinates. Leaves with fewer records are padded with copies of the last record.
+  void storeLeavesAsBlocks() {
+    auto numLeaves = 0;
+    for (const auto& node : tree)
+      numLeaves += node.isLeaf;
+    coordinates.resize(2 * BUCKET_SIZE * numLeaves);
+    ids.resize(BUCKET_SIZE * numLeaves);
+    auto leaf = 0;
+    for (auto& node : tree) {
+      if (!node.isLeaf)
+        continue;
+      assert(node.firstRecord < node.lastRecord);
+      assert(node.lastRecord - node.firstRecord <= BUCKET_SIZE);
+      const auto x = coordinates.data() + 2 * BUCKET_SIZE * leaf;
+      const auto y = x + BUCKET_SIZE;
+      for (auto i = 0; i < BUCKET_SIZE; ++i) {
+        const auto& record = recordsByX[std::min(node.firstRecord + i, node.lastRecord - 1)];
+        x[i] = record.coordinates.x();
+        y[i] = record.coordinates.y();
+        ids[BUCKET_SIZE * leaf + i] = record.id;
+      }
+      const auto numRecords = node.lastRecord - node.firstRecord;
+      node.firstRecord = BUCKET_SIZE * leaf;
+      node.lastRecord = node.firstRecord + numRecords;
+      ++leaf;
+    }
   }
 
   // Builds a kd-tree for the records in the range [first, last).
-  void buildKDTree(const int first, const int last, const int splitDim) {
+  void buildKDTree(const int first, const int last, const int splitDim, const int depth) {
     assert(0 <= first); assert(first < last); assert(last < recordsByX.size());
     assert(splitDim == 0 || splitDim == 1);
     const auto root = tree.size();
     tree.emplace_back();
+    height = std::max(height, depth);
 
     if (last - first <= BUCKET_SIZE) {
       tree[root].isLeaf = true;
@@ -120,9 +245,9 @@ class KDTree {
 
       // Recurse on the two subproblems.
       tree[root].leftChild = tree.size();
-      buildKDTree(first, middle, !splitDim);
+      buildKDTree(first, middle, !splitDim, depth + 1);
       tree[root].rightChild = tree.size();
-      buildKDTree(middle, last, !splitDim);
+      buildKDTree(middle, last, !splitDim, depth + 1);
     } else {
       // Determine the split value.
       auto middle = (first + last) / 2;
@@ -144,67 +269,119 @@ class KDTree {
 
       // Recurse on the two subproblems.
       tree[root].leftChild = tree.size();
-      buildKDTree(first, middle, !splitDim);
+      buildKDTree(first, middle, !splitDim, depth + 1);
       tree[root].rightChild = tree.size();
-      buildKDTree(middle, last, !splitDim);
+      buildKDTree(middle, last, !splitDim, depth + 1);
     }
   }
 
-  // Searches for the closest point in the subtree rooted at the specified node.
-  void findClosestPoint(const Node& node) {
+  // Traverses the kd-tree in the same order as a recursive search that always descends into the
+  // child containing the query point first. Whenever a leaf is reached, visitLeaf is called with
+  // the leaf and the squared distances from the query point to the records in the leaf, and returns
+  // the new bound. A subtree is pruned if its record space is not closer to the query point than
+  // the current bound.
+  template <typename VisitLeafT>
+  void traverse(const Point& query, VisitLeafT visitLeaf, int64_t bound) const {
+    // The stack holds at most one entry per level. Use a fixed-size array unless the tree is deep.
+    StackEntry localStack[MAX_LOCAL_STACK_SIZE];
+    std::vector<StackEntry> heapStack;
+    auto stack = localStack;
+    if (height > MAX_LOCAL_STACK_SIZE) {
+      heapStack.resize(height);
+      stack = heapStack.data();
+    }
+    auto stackSize = 0;
+    stack[stackSize++] = {0, {0, 0}, 0};
+    alignas(64) int64_t dists[BUCKET_SIZE];
+    while (stackSize > 0) {
+      auto entry = stack[--stackSize];
+      if (entry.dist >= bound)
+        continue;
+
+      // Descend into the child containing the query point, and push the other child onto the stack
+      // unless it can be pruned already. The distance to the record space of the closer child is
+      // equal to the distance to the record space of the parent.
+      auto node = &tree[entry.node];
+      while (!node->isLeaf) {
+        const auto dim = node->splitDim;
+        const auto offset = int64_t{query[dim]} - node->splitVal;
+        const auto farDist = entry.dist - entry.offsets[dim] * entry.offsets[dim] + offset * offset;
+        const auto isLeftCloser = offset <= 0;
+        if (farDist < bound) {
+          assert(stackSize < height);
+          auto& farEntry = stack[stackSize++];
+          farEntry = entry;
+          farEntry.node = isLeftCloser ? node->rightChild : node->leftChild;
+          farEntry.offsets[dim] = offset;
+          farEntry.dist = farDist;
+        }
+        node = &tree[isLeftCloser ? node->leftChild : node->rightChild];
+      }
+
+      computeSquaredDistances(query, *node, dists);
+      bound = visitLeaf(*node, dists);
+    }
+  }
+
+  // Searches recursively for the closest point in the subtree rooted at the specified node.
+  void findClosestPointRecursively(const Node& node, QueryState& state) const {
     if (node.isLeaf) {
-      handleBaseCase(node);
+      handleBaseCase(node, state);
       return;
     }
 
-    if (queryPoint[node.splitDim] <= node.splitVal) {
+    if (state.queryPoint[node.splitDim] <= node.splitVal) {
       // Recursive call on the closer child.
-      auto& upperBound = boundingBox.northEast()[node.splitDim];
+      auto& upperBound = state.boundingBox.northEast()[node.splitDim];
       auto tmp = upperBound;
       upperBound = node.splitVal;
-      findClosestPoint(tree[node.leftChild]);
+      findClosestPointRecursively(tree[node.leftChild], state);
       upperBound = tmp;
 
       // Recursive call on the farther child.
-      auto& lowerBound = boundingBox.southWest()[node.splitDim];
+      auto& lowerBound = state.boundingBox.southWest()[node.splitDim];
       tmp = lowerBound;
       lowerBound = node.splitVal;
-      if (boundsIntersectBall())
-        findClosestPoint(tree[node.rightChild]);
+      if (boundsIntersectBall(state))
+        findClosestPointRecursively(tree[node.rightChild], state);
       lowerBound = tmp;
     } else {
       // Recursive call on the closer child.
-      auto& lowerBound = boundingBox.southWest()[node.splitDim];
+      auto& lowerBound = state.boundingBox.southWest()[node.splitDim];
       auto tmp = lowerBound;
       lowerBound = node.splitVal;
-      findClosestPoint(tree[node.rightChild]);
+      findClosestPointRecursively(tree[node.rightChild], state);
       lowerBound = tmp;
 
       // Recursive call on the farther child.
-      auto& upperBound = boundingBox.northEast()[node.splitDim];
+      auto& upperBound = state.boundingBox.northEast()[node.splitDim];
       tmp = upperBound;
       upperBound = node.splitVal;
-      if (boundsIntersectBall())
-        findClosestPoint(tree[node.leftChild]);
+      if (boundsIntersectBall(state))
+        findClosestPointRecursively(tree[node.leftChild], state);
       upperBound = tmp;
     }
   }
 
-  // Checks for each point in the record space represented by the specified node if it improves the
+  // Checks for each point in the record space represented by the specified leaf if it improves the
   // closest point so far encountered.
-  void handleBaseCase(const Node& node) {
-    for (auto i = node.firstRecord; i < node.lastRecord; ++i) {
-      const auto dist = queryPoint.getSquaredEuclideanDistanceTo(buckets[i].coordinates);
-      if (dist < distToClosestPoint) {
-        closestPoint = buckets[i].id;
-        distToClosestPoint = dist;
+  void handleBaseCase(const Node& leaf, QueryState& state) const {
+    const auto x = coordinates.data() + 2 * leaf.firstRecord;
+    const auto y = x + BUCKET_SIZE;
+    for (auto i = 0; i < leaf.lastRecord - leaf.firstRecord; ++i) {
+      const auto dist = state.queryPoint.getSquaredEuclideanDistanceTo(Point(x[i], y[i]));
+      if (dist < state.distToClosestPoint) {
+        state.closestPoint = ids[leaf.firstRecord + i];
+        state.distToClosestPoint = dist;
       }
     }
   }
 
   // Returns true if the current bounding box intersects the ball centered at the query point whose
   // radius is equal to the distance to the closest point so far encountered.
-  bool boundsIntersectBall() const noexcept {
+  static bool boundsIntersectBall(const QueryState& state) noexcept {
+    const auto& queryPoint = state.queryPoint;
+    const auto& boundingBox = state.boundingBox;
     int64_t distToBox = 0;
     if (queryPoint.x() < boundingBox.southWest().x()) {
       const int64_t diff = queryPoint.x() - boundingBox.southWest().x();
@@ -220,16 +397,27 @@ class KDTree {
       const int64_t diff = queryPoint.y() - boundingBox.northEast().y();
       distToBox += diff * diff;
     }
-    return distToBox < distToClosestPoint;
+    return distToBox < state.distToClosestPoint;
   }
 
-  std::vector<Node> tree;      // The nodes in the kd-tree.
-  std::vector<Record> buckets; // The buckets of the leaves concatenated.
+  // Computes the squared distances from the query point to all records in the block of the
+  // specified leaf, including padding. The loop has a fixed trip count and is vectorized.
+  void computeSquaredDistances(const Point& query, const Node& leaf, int64_t* const dists) const {
+    const auto x = coordinates.data() + 2 * leaf.firstRecord;
+    const auto y = x + BUCKET_SIZE;
+    const int64_t queryX = query.x();
+    const int64_t queryY = query.y();
+    for (auto i = 0; i < BUCKET_SIZE; ++i) {
+      const auto dx = x[i] - queryX;
+      const auto dy = y[i] - queryY;
+      dists[i] = dx * dx + dy * dy;
+    }
+  }
 
-  Point queryPoint;           // The query point for which we search the nearest neighbor.
-  Rectangle boundingBox;      // The bounds of the record space represented by the current node.
-  int closestPoint;           // The closest point so far encountered.
-  int64_t distToClosestPoint; // The distance to the closest point.
+  std::vector<Node> tree;           // The nodes in the kd-tree.
+  std::vector<int32_t> coordinates; // The blocks of x- and y-coordinates of the leaves.
+  std::vector<int32_t> ids;         // The IDs of the records in the leaves.
+  int height;                       // The number of nodes on the longest root-to-leaf path.
 
   std::vector<Record> recordsByX; // During construction: records ordered by the x-coordinate.
   std::vector<Record> recordsByY; // During construction: records ordered by the y-coordinate.
@@ -17,8 +17,10 @@
 #include "DataStructures/Utilities/Permutation.h"
 #include "Tools/Simd/AlignedVector.h"
 #include "Tools/BinaryIO.h"
+#include "Tools/CompressedBinaryIO.h"
 #include "Tools/Constants.h"
 #include "Tools/ContainerHelpers.h"
+#include "Tools/MemoryMappedFile.h"
 #include "Tools/TemplateProgramming.h"
 #include "Tools/Workarounds.h"
 
@@ -130,6 +132,11 @@ public:
         readFrom(in);
     }
 
+    // Constructs a graph from a memory-mapped binary file.
+    explicit Graph(MemoryMappedFile &in) {
+        readFrom(in);
+    }
+
     // Converts an arbitrary source graph into in arbitrary destination graph. Attributes associated
     // with both the source and the destination graph are copied or, if possible, moved. Attributes
     // associated only with the destination graph are defaulted.
@@ -735,42 +742,58 @@ public:
     template<typename ExporterT = DefaultExporter>
     void exportTo(const std::string & /*filename*/, ExporterT /*ex*/ = ExporterT()) const {}
 
-    // Reads a graph from a binary file. Attributes that are present in the file, but not associated
+    // Reads a graph from a binary file, given either as an std::ifstream or as a MemoryMappedFile.
+    // Both the plain format written by writeTo and the compressed format written by
+    // writeCompressedTo are recognized. Attributes that are present in the file, but not associated
     // with the graph are ignored. Attributes that are associated with the graph, but not present in
     // the file are defaulted.
-    void readFrom(std::ifstream &in) {
+    template<typename InputStreamT>
+    void readFrom(InputStreamT &in) {
         clear();
 
         int numVertices;
         bio::read(in, numVertices);
+        const auto compressed = numVertices == COMPRESSED_FORMAT;
+        if (compressed)
+            bio::read(in, numVertices);
         bio::read(in, edgeCount);
         assert(numVertices >= 0);
         assert(edgeCount >= 0);
         outEdges.resize(numVertices + !dynamic);
 
-        // Read the out-edge ranges and edge heads.
+        // Read the out-edge ranges and edge heads. In a static graph, the out-edge ranges are stored
+        // exactly as on disk, so we can read them in one go.
         outEdges[0].first() = 0;
-        for (int v = 1; v < numVertices; ++v) {
-            bio::read(in, outEdges[v].first());
-            outEdges[v - dynamic].last() = outEdges[v].first();
+        if (compressed) {
+            readCompressedAdjacency(in);
+        } else if constexpr (!dynamic && sizeof(OutEdgeRange) == sizeof(int)) {
+            if (numVertices > 1)
+                bio::read(in, &outEdges[1].first(), numVertices - 1);
+        } else {
+            for (int v = 1; v < numVertices; ++v) {
+                bio::read(in, outEdges[v].first());
+                outEdges[v - dynamic].last() = outEdges[v].first();
+            }
         }
         outEdges.back().last() = edgeCount;
-        bio::read(in, edgeHeads);
+        if (!compressed)
+            bio::read(in, edgeHeads);
 
         // Fill the values of the vertex attributes.
         int numVertexAttrs;
         bio::read(in, numVertexAttrs);
         for (int i = 0; i < numVertexAttrs; ++i) {
             std::string name;
-            int size;
+            uint32_t size; // Unsigned, so that attributes of 2GiB or more can be skipped.
             bio::read(in, name);
             bio::read(in, size);
             if (hasAttribute(name))
                 // Read the attribute's values into the corresponding vertex array.
-                RUN_IF(VertexAttributes::NAME == name, bio::read(in, VertexAttributes::values));
+                RUN_IF(VertexAttributes::NAME == name, compressed ?
+                        cbio::read(in, VertexAttributes::values) : bio::read(in, VertexAttributes::values));
             else
                 // Skip the attribute's values, since the attribute is not associated with the graph.
-                in.seekg(size, std::ios::cur);
+                bio::skip(in, size);
         }
         RUN_FORALL(VertexAttributes::values.resize(numVertices, VertexAttributes::defaultValue()));
 
@@ -779,15 +802,16 @@ public:
         bio::read(in, numEdgeAttrs);
         for (int i = 0; i < numEdgeAttrs; ++i) {
             std::string name;
-            int size;
+            uint32_t size; // Unsigned, so that attributes of 2GiB or more can be skipped.
             bio::read(in, name);
             bio::read(in, size);
             if (hasAttribute(name))
                 // Read the attribute's values into the corresponding edge array.
-                RUN_IF(EdgeAttributes::NAME == name, bio::read(in, EdgeAttributes::values));
+                RUN_IF(EdgeAttributes::NAME == name, compressed ?
+                        cbio::read(in, EdgeAttributes::values) : bio::read(in, EdgeAttributes::values));
             else
                 // Skip the attribute's values, since the attribute is not associated with the graph.
-                in.seekg(size, std::ios::cur);
+                bio::skip(in, size);
         }
         RUN_FORALL(EdgeAttributes::values.resize(edgeCount, EdgeAttributes::defaultValue()));
 
@@ -833,6 +857,66 @@ public:
         ));
     }
 
+    // Writes a graph to a compressed binary file, which readFrom recognizes automatically. The heads
+    // of the edges out of each vertex v are stored as varint-encoded differences to v, which are
+    // small if the vertex order is locality-friendly. The vertices are grouped into blocks that are
+    // encoded and decoded in parallel. The attribute arrays are block-compressed. The second
+    // parameter is a list of attributes that should not be written to the file.
+    // CAUTION: THE GRAPH HAS TO BE DEFRAGMENTED.
+    void writeCompressedTo(std::ofstream &out, const std::vector<std::string> &attrsToIgnore = {}) const {
+        assert(validate());
+        assert(isDefrag());
+        bio::write(out, COMPRESSED_FORMAT);
+        bio::write(out, numVertices());
+        bio::write(out, numEdges());
+
+        // Encode the out-degrees and edge heads, one block of vertices at a time.
+        const int numBlocks = (numVertices() + VERTICES_PER_BLOCK - 1) / VERTICES_PER_BLOCK;
+        std::vector<std::vector<uint8_t>> blocks(numBlocks);
+        #pragma omp parallel for schedule(dynamic)
+        for (int b = 0; b < numBlocks; ++b) {
+            const int lastVertex = std::min(numVertices(), (b + 1) * VERTICES_PER_BLOCK);
+            for (int v = b * VERTICES_PER_BLOCK; v < lastVertex; ++v) {
+                cbio::appendVarint(blocks[b], degree(v));
+                for (int e = firstEdge(v); e != lastEdge(v); ++e)
+                    cbio::appendVarint(blocks[b], cbio::zigzagEncode(edgeHeads[e] - v));
+            }
+        }
+        std::vector<int> firstEdgeOfBlock(numBlocks + 1);
+        std::vector<int64_t> firstByteOfBlock(numBlocks + 1);
+        for (int b = 0; b < numBlocks; ++b) {
+            firstEdgeOfBlock[b] = firstEdge(b * VERTICES_PER_BLOCK);
+            firstByteOfBlock[b + 1] = firstByteOfBlock[b] + blocks[b].size();
+        }
+        firstEdgeOfBlock.back() = numEdges();
+        bio::write(out, firstEdgeOfBlock);
+        bio::write(out, firstByteOfBlock);
+        for (const auto &block : blocks)
+            out.write(reinterpret_cast<const char *>(block.data()), block.size());
+
+        // Write the vertex attributes.
+        int numVertexAttrs = 0;
+        RUN_IF(
+                !contains(attrsToIgnore.begin(), attrsToIgnore.end(), use(VertexAttributes::NAME)),
+                ++numVertexAttrs);
+        bio::write(out, numVertexAttrs);
+        RUN_IF(!contains(attrsToIgnore.begin(), attrsToIgnore.end(), use(VertexAttributes::NAME)), (
+                bio::write(out, VertexAttributes::NAME),
+                        cbio::write(out, VertexAttributes::values)
+        ));
+
+        // Write the edge attributes.
+        int numEdgeAttrs = 0;
+        RUN_IF(
+                !contains(attrsToIgnore.begin(), attrsToIgnore.end(), use(EdgeAttributes::NAME)),
+                ++numEdgeAttrs);
+        bio::write(out, numEdgeAttrs);
+        RUN_IF(!contains(attrsToIgnore.begin(), attrsToIgnore.end(), use(EdgeAttributes::NAME)), (
+                bio::write(out, EdgeAttributes::NAME),
+                        cbio::write(out, EdgeAttributes::values)
+        ));
+    }
+
     // Checks if the graph is consistent.
     bool validate() const {
         boost::dynamic_bitset<> visited(edgeHeads.size());
@@ -877,6 +961,42 @@ private:
     // and not an actual edge, we store this value as its head.
     static constexpr int INVALID_EDGE = -1;
 
+    // A compressed binary file starts with this value in place of the number of vertices.
+    static constexpr int COMPRESSED_FORMAT = -0x43475242;
+
+    // The number of vertices per block of the adjacency structure in a compressed binary file.
+    static constexpr int VERTICES_PER_BLOCK = 1 << 14;
+
+    // Reads the out-degrees and edge heads from a compressed binary file, one block of vertices at a
+    // time in parallel. The number of vertices and edges must already be known.
+    template<typename InputStreamT>
+    void readCompressedAdjacency(InputStreamT &in) {
+        std::vector<int> firstEdgeOfBlock;
+        std::vector<int64_t> firstByteOfBlock;
+        bio::read(in, firstEdgeOfBlock);
+        bio::read(in, firstByteOfBlock);
+        std::vector<char> buf;
+        const auto bytes = reinterpret_cast<const uint8_t *>(cbio::fetch(in, firstByteOfBlock.back(), buf));
+        edgeHeads.resize(edgeCount);
+
+        const int numBlocks = firstEdgeOfBlock.size() - 1;
+        #pragma omp parallel for schedule(dynamic)
+        for (int b = 0; b < numBlocks; ++b) {
+            const uint8_t *pos = bytes + firstByteOfBlock[b];
+            int e = firstEdgeOfBlock[b];
+            const int lastVertex = std::min(numVertices(), (b + 1) * VERTICES_PER_BLOCK);
+            for (int v = b * VERTICES_PER_BLOCK; v < lastVertex; ++v) {
+                const int deg = cbio::decodeVarint(pos);
+                outEdges[v].first() = e;
+                if constexpr (dynamic)
+                    outEdges[v].last() = e + deg;
+                for (const int last = e + deg; e != last; ++e)
+                    edgeHeads[e] = v + cbio::zigzagDecode(cbio::decodeVarint(pos));
+            }
+            assert(e == firstEdgeOfBlock[b + 1]);
+        }
+    }
+
     // Initializes an empty graph.
     void init() {
         edgeCount = 0;
@@ -1,22 +1,32 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <charconv>
 #include <cmath>
 #include <cstring>
-#include <fstream>
-#include <ios>
-#include <limits>
+#include <future>
 #include <string>
+#include <system_error>
+#include <vector>
 
 #include "DataStructures/Geometry/LatLng.h"
 #include "DataStructures/Graph/Attributes/LatLngAttribute.h"
 #include "DataStructures/Graph/Attributes/LengthAttribute.h"
 #include "DataStructures/Graph/Attributes/TravelTimeAttribute.h"
 #include "Tools/Constants.h"
+#include "Tools/OpenMP.h"
+#include "Tools/TextFile.h"
 
 // An importer for reading graphs in DIMACS file format. First, the Graph class repeatedly calls
 // nextVertex to read the next vertex from disk and fetches various vertex attributes. Then it
 // repeatedly calls nextEdge to read the next edge from disk and fetches various edge attributes.
+//
+// The input files are parsed up front in init. Each file is split into chunks at line boundaries,
+// which are parsed in parallel. Input files may be gzip-compressed (with the additional extension
+// .gz). All files are loaded concurrently, so that decompressing one file overlaps with parsing
+// another one.
 class DimacsImporter {
  public:
   // Constructs an importer to read graphs in DIMACS file format.
@@ -41,36 +51,45 @@ class DimacsImporter {
     return edgeCount;
   }
 
-  // Opens the input file(s) and reads the header line(s).
+  // Opens and parses the input file(s).
   void init(const std::string& filename) {
-    distGrFile.open(filename + ".dist.gr");
-    if (distGrFile.is_open()) {
-      while (distGrFile.peek() == std::char_traits<char>::to_int_type('c'))
-        distGrFile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-      char header[4];
-      distGrFile.read(header, 4) >> vertexCount >> edgeCount;
-      distGrFile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-      assert(!distGrFile.fail());
-      assert(std::memcmp(header, "p sp", 4) == 0);
+    TextFile distGrFile, timeGrFile, coFile;
+    auto distGrFileOpened = std::async(std::launch::async, [&] {
+      return distGrFile.open(filename + ".dist.gr");
+    });
+    auto timeGrFileOpened = std::async(std::launch::async, [&] {
+      return timeGrFile.open(filename + ".time.gr");
+    });
+    auto coFileOpened = std::async(std::launch::async, [&] {
+      return coFile.open(filename + ".co");
+    });
+
+    hasDists = distGrFileOpened.get();
+    if (hasDists) {
+      const char* pos = skipHeader(distGrFile.begin(), distGrFile.end(), "p sp");
+      vertexCount = parseInt(pos, distGrFile.end());
+      edgeCount = parseInt(pos, distGrFile.end());
       assert(vertexCount >= 0);
       assert(edgeCount >= 0);
+      distRecords = parseRecords(distGrFile.begin(), distGrFile.end(), 'a');
+      assert(distRecords.size() == edgeCount);
+      distGrFile.close();
     } else {
       currentEdge.dist = LengthAttribute::defaultValue();
     }
 
-    timeGrFile.open(filename + ".time.gr");
-    if (timeGrFile.is_open()) {
-      while (timeGrFile.peek() == std::char_traits<char>::to_int_type('c'))
-        timeGrFile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-      char header[4]; int vertexCount, edgeCount;
-      timeGrFile.read(header, 4) >> vertexCount >> edgeCount;
-      timeGrFile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-      assert(!timeGrFile.fail());
-      assert(std::memcmp(header, "p sp", 4) == 0);
+    hasTimes = timeGrFileOpened.get();
+    if (hasTimes) {
+      const char* pos = skipHeader(timeGrFile.begin(), timeGrFile.end(), "p sp");
+      const auto vertexCount = parseInt(pos, timeGrFile.end());
+      const auto edgeCount = parseInt(pos, timeGrFile.end());
       assert(vertexCount >= 0);
       assert(edgeCount >= 0);
+      timeRecords = parseRecords(timeGrFile.begin(), timeGrFile.end(), 'a');
+      assert(timeRecords.size() == edgeCount);
+      timeGrFile.close();
 
-      if (distGrFile.is_open()) {
+      if (hasDists) {
         assert(this->vertexCount == vertexCount);
         assert(this->edgeCount == edgeCount);
       } else {
@@ -78,43 +97,37 @@ class DimacsImporter {
         this->edgeCount = edgeCount;
       }
     } else {
-      assert(distGrFile.is_open());
+      assert(hasDists);
       currentEdge.time = TravelTimeAttribute::defaultValue();
     }
 
-    coFile.open(filename + ".co");
-    if (coFile.is_open()) {
-      while (coFile.peek() == std::char_traits<char>::to_int_type('c'))
-        coFile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-      char header[11]; int vertexCount;
-      coFile.read(header, 11) >> vertexCount;
-      coFile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-      assert(!coFile.fail());
-      assert(std::memcmp(header, "p aux sp co", 11) == 0);
+    hasCoordinates = coFileOpened.get();
+    if (hasCoordinates) {
+      const char* pos = skipHeader(coFile.begin(), coFile.end(), "p aux sp co");
+      [[maybe_unused]] const auto vertexCount = parseInt(pos, coFile.end());
       assert(this->vertexCount == vertexCount);
+      vertexRecords = parseRecords(coFile.begin(), coFile.end(), 'v');
+      coFile.close();
     } else {
       currentVertex.id = 0;
       currentVertex.latLng = LatLngAttribute::defaultValue();
     }
+
+    nextVertexIdx = 0;
+    nextEdgeIdx = 0;
   }
 
   // Reads the next vertex from disk. Returns false if there are no more vertices.
   bool nextVertex() {
-    if (coFile.is_open()) {
-      while (coFile.peek() == std::char_traits<char>::to_int_type('c'))
-        coFile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-      char type; int lng, lat;
-      coFile >> type >> currentVertex.id >> lng >> lat;
-      coFile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-      if (!coFile.eof()) {
-        assert(!coFile.fail());
-        assert(type == 'v');
-        assert(currentVertex.id > 0); assert(currentVertex.id <= vertexCount);
-      }
-//        const auto conversionFactor = static_cast<double>(LatLng::PRECISION) / coordinatePrecision;
-        const auto conversionFactor = 1.0 / coordinatePrecision;
-      currentVertex.latLng = {conversionFactor * lat, conversionFactor * lng};
-      return !coFile.eof();
+    if (hasCoordinates) {
+      if (nextVertexIdx == vertexRecords.size())
+        return false;
+      const auto& record = vertexRecords[nextVertexIdx++];
+      currentVertex.id = record[0];
+      assert(currentVertex.id > 0); assert(currentVertex.id <= vertexCount);
+      const auto conversionFactor = 1.0 / coordinatePrecision;
+      currentVertex.latLng = {conversionFactor * record[2], conversionFactor * record[1]};
+      return true;
     } else {
       return ++currentVertex.id <= vertexCount;
     }
@@ -127,51 +140,35 @@ class DimacsImporter {
 
   // Reads the next edge from disk. Returns false if there are no more edges.
   bool nextEdge() {
-    if (distGrFile.is_open()) {
-      while (distGrFile.peek() == std::char_traits<char>::to_int_type('c'))
-        distGrFile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-      char type;
-      distGrFile >> type >> currentEdge.tail >> currentEdge.head >> currentEdge.dist;
-      distGrFile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-      if (!distGrFile.eof()) {
-        assert(!distGrFile.fail());
-        assert(type == 'a');
-      }
-      currentEdge.dist = std::round(1.0 / distPrecision * currentEdge.dist);
+    if (nextEdgeIdx == (hasDists ? distRecords.size() : timeRecords.size()))
+      return false;
+
+    if (hasDists) {
+      const auto& record = distRecords[nextEdgeIdx];
+      currentEdge.tail = record[0];
+      currentEdge.head = record[1];
+      currentEdge.dist = std::round(1.0 / distPrecision * record[2]);
       assert(currentEdge.dist >= 0); assert(currentEdge.dist < INFTY);
     }
 
-    if (timeGrFile.is_open()) {
-      while (timeGrFile.peek() == std::char_traits<char>::to_int_type('c'))
-        timeGrFile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-      char type; int tail, head;
-      timeGrFile >> type >> tail >> head >> currentEdge.time;
-      timeGrFile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-      if (!timeGrFile.eof()) {
-        assert(!timeGrFile.fail());
-        assert(type == 'a');
-      }
-      currentEdge.time = std::round(10.0 / timePrecision * currentEdge.time);
+    if (hasTimes) {
+      const auto& record = timeRecords[nextEdgeIdx];
+      currentEdge.time = std::round(10.0 / timePrecision * record[2]);
       assert(currentEdge.time >= 0); assert(currentEdge.time < INFTY);
 
-      if (distGrFile.is_open()) {
-        assert(distGrFile.eof() == timeGrFile.eof());
-        if (!distGrFile.eof()) {
-          assert(currentEdge.tail == tail);
-          assert(currentEdge.head == head);
-        }
+      if (hasDists) {
+        assert(currentEdge.tail == record[0]);
+        assert(currentEdge.head == record[1]);
       } else {
-        currentEdge.tail = tail;
-        currentEdge.head = head;
+        currentEdge.tail = record[0];
+        currentEdge.head = record[1];
       }
     }
 
-    if (!(distGrFile.eof() || timeGrFile.eof())) {
-      assert(currentEdge.tail > 0); assert(currentEdge.tail <= vertexCount);
-      assert(currentEdge.head > 0); assert(currentEdge.head <= vertexCount);
-      return true;
-	}
-    return false;
+    ++nextEdgeIdx;
+    assert(currentEdge.tail > 0); assert(currentEdge.tail <= vertexCount);
+    assert(currentEdge.head > 0); assert(currentEdge.head <= vertexCount);
+    return true;
   }
 
   // Returns the tail vertex of the current edge.
@@ -191,11 +188,11 @@ class DimacsImporter {
     return Attr::defaultValue();
   }
 
-  // Closes the input file(s).
+  // Releases the parsed records.
   void close() {
-    distGrFile.close();
-    timeGrFile.close();
-    coFile.close();
+    distRecords = {};
+    timeRecords = {};
+    vertexRecords = {};
   }
 
  private:
@@ -213,13 +210,99 @@ class DimacsImporter {
     int time;
   };
 
+  // A line in DIMACS file format holding three integers, such as an arc or a coordinate line.
+  using Line = std::array<int, 3>;
+
+  // Skips the comment lines at the beginning of the specified text, checks that the next line is
+  // the specified problem line, and returns a pointer to the first field after the line prefix.
+  static const char* skipHeader(const char* first, const char* last, const char* problemLine) {
+    while (first != last && *first == 'c')
+      first = nextLine(first, last);
+    const auto len = std::strlen(problemLine);
+    assert(last - first >= len && std::memcmp(first, problemLine, len) == 0);
+    return first + len;
+  }
+
+  // Returns a pointer to the beginning of the line following the one containing pos.
+  static const char* nextLine(const char* pos, const char* last) {
+    const auto eol = static_cast<const char*>(std::memchr(pos, '\n', last - pos));
+    return eol != nullptr ? eol + 1 : last;
+  }
+
+  // Parses the next integer after pos, skipping leading blanks, and advances pos past it.
+  static int parseInt(const char*& pos, const char* last) {
+    while (pos != last && (*pos == ' ' || *pos == '\t'))
+      ++pos;
+    int val = 0;
+    [[maybe_unused]] const auto res = std::from_chars(pos, last, val);
+    assert(res.ec == std::errc());
+    pos = res.ptr;
+    return val;
+  }
+
+  // Parses all lines of the specified text that start with the specified line type, and returns
+  // their integer fields in the order in which the lines appear. The text is split into one chunk
+  // per thread at line boundaries, and the chunks are parsed in parallel.
+  static std::vector<Line> parseRecords(const char* first, const char* last, const char lineType) {
+    std::vector<std::vector<Line>> linesByChunk;
+    #pragma omp parallel
+    {
+      #pragma omp single
+      linesByChunk.resize(omp_get_num_threads());
+
+      // Determine the chunk of the current thread, aligned to line boundaries.
+      const auto numChunks = omp_get_num_threads();
+      const auto chunk = omp_get_thread_num();
+      const auto size = last - first;
+      const auto chunkBegin = alignToLine(first, last, first + size * chunk / numChunks);
+      const auto chunkEnd = alignToLine(first, last, first + size * (chunk + 1) / numChunks);
+
+      auto& lines = linesByChunk[chunk];
+      lines.reserve((chunkEnd - chunkBegin) / 16);
+      for (auto pos = chunkBegin; pos < chunkEnd;) {
+        const auto eol = nextLine(pos, chunkEnd);
+        if (*pos == lineType) {
+          ++pos;
+          Line& line = lines.emplace_back();
+          line[0] = parseInt(pos, eol);
+          line[1] = parseInt(pos, eol);
+          line[2] = parseInt(pos, eol);
+        }
+        pos = eol;
+      }
+    }
+
+    // Concatenate the lines from all chunks, preserving their order.
+    std::vector<int> firstLineOfChunk(linesByChunk.size() + 1);
+    for (auto i = 0; i < linesByChunk.size(); ++i)
+      firstLineOfChunk[i + 1] = firstLineOfChunk[i] + linesByChunk[i].size();
+    std::vector<Line> lines(firstLineOfChunk.back());
+    #pragma omp parallel for schedule(static, 1)
+    for (auto i = 0; i < linesByChunk.size(); ++i) {
+      std::copy(linesByChunk[i].begin(), linesByChunk[i].end(), lines.begin() + firstLineOfChunk[i]);
+      linesByChunk[i] = {};
+    }
+    return lines;
+  }
+
+  // Returns the beginning of the first line that starts at or after pos.
+  static const char* alignToLine(const char* first, const char* last, const char* pos) {
+    return pos == first ? first : nextLine(pos - 1, last);
+  }
+
   int distPrecision;       // Travel distances are given in 1/distPrecision meters.
   int timePrecision;       // Travel times are given in 1/timePrecision seconds.
   int coordinatePrecision; // Coordinates are given in 1/coordinatePrecision degrees.
 
-  std::ifstream distGrFile; // The graph file that contains the travel distance metric.
-  std::ifstream timeGrFile; // The graph file that contains the travel time metric.
-  std::ifstream coFile;     // The auxiliary file that contains the coordinates.
+  bool hasDists;       // Indicates whether there is a graph file with the travel distance metric.
+  bool hasTimes;       // Indicates whether there is a graph file with the travel time metric.
+  bool hasCoordinates; // Indicates whether there is an auxiliary file with the coordinates.
+
+  std::vector<Line> distRecords;   // The arc lines of the travel distance graph file.
+  std::vector<Line> timeRecords;   // The arc lines of the travel time graph file.
+  std::vector<Line> vertexRecords; // The coordinate lines of the auxiliary file.
+  int nextVertexIdx;               // The index of the next coordinate line to be returned.
+  int nextEdgeIdx;                 // The index of the next arc line to be returned.
 
   int vertexCount; // The number of vertices in the graph.
   int edgeCount;   // The number of edges in the graph.
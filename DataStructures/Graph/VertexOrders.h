@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Algorithms/GraphTraversal/DfsNumbering.h"
+#include "DataStructures/Geometry/HilbertCurve.h"
+#include "DataStructures/Graph/Attributes/LatLngAttribute.h"
+#include "DataStructures/Graph/Graph.h"
+#include "DataStructures/Partitioning/SeparatorDecomposition.h"
+#include "DataStructures/Utilities/Permutation.h"
+#include "Tools/Constants.h"
+
+// Functions computing vertex orders that improve spatial locality, i.e., that assign nearby IDs to
+// vertices that are likely to be accessed together. Each function returns a permutation mapping
+// each vertex to its new ID, which can be passed to Graph::permuteVertices.
+
+// Returns a permutation that orders the vertices along a Hilbert curve through their coordinates.
+template <typename GraphT>
+inline Permutation computeHilbertOrder(const GraphT& graph) {
+  static_assert(GraphT::template has<LatLngAttribute>());
+  std::vector<uint64_t> keys(graph.numVertices());
+  FORALL_VERTICES(graph, v) {
+    const auto& latLng = graph.latLng(v);
+    if (!latLng.isValid())
+      throw std::invalid_argument("Hilbert order requires the coordinates of all vertices");
+    keys[v] = hilbertCurveIndex(latLng);
+  }
+  std::vector<int> verticesByKey(graph.numVertices());
+  std::iota(verticesByKey.begin(), verticesByKey.end(), 0);
+  std::stable_sort(verticesByKey.begin(), verticesByKey.end(), [&](const int u, const int v) {
+    return keys[u] < keys[v];
+  });
+  Permutation perm(graph.numVertices());
+  for (auto i = 0; i < graph.numVertices(); ++i)
+    perm[verticesByKey[i]] = i;
+  return perm;
+}
+
+// Returns a permutation that orders the vertices as they are reached during a DFS.
+template <typename GraphT>
+inline Permutation computeDfsOrder(const GraphT& graph) {
+  const auto dfsNumbers = DfsNumbering().run(graph);
+  return Permutation(dfsNumbers.begin(), dfsNumbers.end());
+}
+
+// Returns a permutation that orders the vertices as they are reached during a BFS. Each vertex not
+// reached from previous roots becomes the root of a new BFS, in order of increasing ID.
+template <typename GraphT>
+inline Permutation computeBfsOrder(const GraphT& graph) {
+  Permutation perm(graph.numVertices());
+  std::vector<int> queue(graph.numVertices());
+  std::vector<bool> reached(graph.numVertices());
+  auto queueEnd = 0;
+  FORALL_VERTICES(graph, s) {
+    if (reached[s])
+      continue;
+    auto queueBegin = queueEnd;
+    reached[s] = true;
+    queue[queueEnd++] = s;
+    while (queueBegin != queueEnd) {
+      const auto u = queue[queueBegin++];
+      FORALL_INCIDENT_EDGES(graph, u, e) {
+        const auto v = graph.edgeHead(e);
+        if (!reached[v]) {
+          reached[v] = true;
+          queue[queueEnd++] = v;
+        }
+      }
+    }
+  }
+  assert(queueEnd == graph.numVertices());
+  for (auto i = 0; i < graph.numVertices(); ++i)
+    perm[queue[i]] = i;
+  return perm;
+}
+
+// Returns a permutation that orders the vertices by the nested dissection order associated with
+// the specified separator decomposition.
+inline Permutation computeNestedDissectionOrder(const SeparatorDecomposition& sepDecomp) {
+  return sepDecomp.order.getInversePermutation();
+}
+
+// Returns a permutation that orders the vertices by the specified order, given by its name.
+// Possible names are hilbert, dfs, bfs, and nd. The last one requires a separator decomposition.
+template <typename GraphT>
+inline Permutation computeVertexOrder(
+    const GraphT& graph, const std::string& name, const SeparatorDecomposition* sepDecomp = nullptr) {
+  if (name == "hilbert") {
+    return computeHilbertOrder(graph);
+  } else if (name == "dfs") {
+    return computeDfsOrder(graph);
+  } else if (name == "bfs") {
+    return computeBfsOrder(graph);
+  } else if (name == "nd") {
+    if (sepDecomp == nullptr)
+      throw std::invalid_argument("nested dissection order requires a separator decomposition");
+    if (sepDecomp->order.size() != graph.numVertices())
+      throw std::invalid_argument("separator decomposition does not match the graph");
+    return computeNestedDissectionOrder(*sepDecomp);
+  } else {
+    throw std::invalid_argument("unrecognized vertex order -- '" + name + "'");
+  }
+}
+
+// Translates the specified separator decomposition to a graph whose vertices were permuted by the
+// specified permutation.
+inline void permuteSeparatorDecomposition(SeparatorDecomposition& sepDecomp, const Permutation& perm) {
+  assert(sepDecomp.order.size() == perm.size());
+  std::vector<int> order(sepDecomp.order.begin(), sepDecomp.order.end());
+  for (auto& v : order)
+    v = perm[v];
+  sepDecomp.order.assign(order.begin(), order.end());
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <routingkit/nested_dissection.h>
+
+#include "Tools/OpenMP.h"
+
+// A cut routine for nested dissection that runs inertial flow several times and returns the best
+// cut found. RoutingKit's inertial flow projects the vertices onto four fixed directions, 45 degrees
+// apart. Rotating the coordinates by multiples of 45 / numRotations degrees yields further
+// directions. Each combination of a rotation and a balance parameter is a candidate, and the
+// candidates are evaluated in parallel. The candidate with the smallest expansion, i.e., the ratio
+// of the cut size to the number of vertices on the smaller side, wins. Ties are broken in favor of
+// the earlier candidate, so the result does not depend on the number of threads.
+class InertialFlowSeparator {
+ public:
+  // Constructs a cut routine for a graph with the specified vertex coordinates in degrees.
+  InertialFlowSeparator(
+      const std::vector<float>& lats, const std::vector<float>& lngs,
+      const std::vector<int>& balances = {30}, const int numRotations = 1)
+      : balances(balances) {
+    assert(lats.size() == lngs.size());
+    if (balances.empty())
+      throw std::invalid_argument("no balance parameter given");
+    for (const auto b : balances)
+      if (b < 0 || b > 50)
+        throw std::invalid_argument("invalid balance -- '" + std::to_string(b) + "'");
+    if (numRotations < 1)
+      throw std::invalid_argument("invalid number of rotations -- '" +
+                                  std::to_string(numRotations) + "'");
+
+    rotatedLats.push_back(lats);
+    rotatedLngs.push_back(lngs);
+    for (auto r = 1; r < numRotations; ++r) {
+      const auto angle = r * std::atan(1.0) / numRotations;
+      const auto cosAngle = std::cos(angle);
+      const auto sinAngle = std::sin(angle);
+      rotatedLats.emplace_back(lats.size());
+      rotatedLngs.emplace_back(lngs.size());
+      for (auto v = 0; v < lats.size(); ++v) {
+        rotatedLats.back()[v] = cosAngle * lats[v] - sinAngle * lngs[v];
+        rotatedLngs.back()[v] = sinAngle * lats[v] + cosAngle * lngs[v];
+      }
+    }
+  }
+
+  // Returns the number of candidate cuts evaluated for each graph fragment.
+  int numCandidates() const noexcept {
+    return rotatedLats.size() * balances.size();
+  }
+
+  // Returns the best cut of the specified graph fragment. If this member function is called in a
+  // parallel region, the candidates are evaluated by separate tasks. Otherwise, it starts its own
+  // parallel region.
+  RoutingKit::CutSide operator()(const RoutingKit::GraphFragment& fragment) const {
+    std::vector<RoutingKit::CutSide> cuts(numCandidates());
+    if (cuts.size() == 1) {
+      computeCandidate(fragment, cuts, 0);
+    } else if (omp_in_parallel()) {
+      computeCandidates(fragment, cuts);
+    } else {
+      #pragma omp parallel
+      #pragma omp single
+      computeCandidates(fragment, cuts);
+    }
+
+    auto best = 0;
+    for (auto i = 1; i < cuts.size(); ++i)
+      if (hasSmallerExpansion(cuts[i], cuts[best], fragment.node_count()))
+        best = i;
+    return std::move(cuts[best]);
+  }
+
+ private:
+  // Evaluates all candidates, one task per candidate.
+  void computeCandidates(
+      const RoutingKit::GraphFragment& fragment, std::vector<RoutingKit::CutSide>& cuts) const {
+    #pragma omp taskloop grainsize(1) default(shared)
+    for (auto i = 0; i < cuts.size(); ++i)
+      computeCandidate(fragment, cuts, i);
+  }
+
+  // Evaluates the i-th candidate.
+  void computeCandidate(
+      const RoutingKit::GraphFragment& fragment, std::vector<RoutingKit::CutSide>& cuts,
+      const int i) const {
+    const auto rotation = i / balances.size();
+    const auto balance = balances[i % balances.size()];
+    cuts[i] = inertial_flow(fragment, balance, rotatedLats[rotation], rotatedLngs[rotation]);
+  }
+
+  // Returns true if the first cut has a smaller expansion than the second one.
+  static bool hasSmallerExpansion(
+      const RoutingKit::CutSide& a, const RoutingKit::CutSide& b, const uint64_t numNodes) {
+    const uint64_t smallerSideOfA = std::min<uint64_t>(a.node_on_side_count,
+                                                       numNodes - a.node_on_side_count);
+    const uint64_t smallerSideOfB = std::min<uint64_t>(b.node_on_side_count,
+                                                       numNodes - b.node_on_side_count);
+    return a.cut_size * std::max<uint64_t>(smallerSideOfB, 1) <
+        b.cut_size * std::max<uint64_t>(smallerSideOfA, 1);
+  }
+
+  std::vector<int> balances;                   // The balance parameters in percent.
+  std::vector<std::vector<float>> rotatedLats; // The latitudes, for each rotation.
+  std::vector<std::vector<float>> rotatedLngs; // The longitudes, for each rotation.
+};
@@ -100,21 +100,100 @@ namespace RoutingKit {
         return res;
     }
 
+    SeparatorDecomposition compute_separator_decomposition_with_strict_dissection(
+            GraphFragment&& fragment,
+            const std::function<CutSide(const GraphFragment &)> &compute_cut,
+            BitVector&& prev_is_separator_node,
+            BitVector&& prev_cut_side,
+            const std::function<void(const std::string &)> &log_message = [](const std::string &) {},
+            unsigned min_parallel_node_count = 10000);
+
+    // Computes a cut of the given non-trivial part, removes the arcs incident to separator nodes, and recursively
+    // computes the separator decomposition of the part.
+    SeparatorDecomposition compute_separator_decomposition_of_part(
+            GraphFragment&& part,
+            const std::function<CutSide(const GraphFragment &)> &compute_cut,
+            const std::function<void(const std::string &)> &log_message,
+            const unsigned min_parallel_node_count
+    ) {
+        long long timer = 0;
+        const bool log = log_message && part.node_count() > 1000;
+
+        if (log) {
+            #pragma omp critical (log_strict_dissection)
+            {
+                log_message("Computing decomposition for top level component with " +
+                            std::to_string(part.node_count()) + " nodes");
+                log_message("Start computing top level separator");
+            }
+            timer = -get_micro_time();
+        }
+        auto cut = compute_cut(part);
+        auto is_separator_node = derive_separator_from_cut(part, cut.is_node_on_side);
+        if (log) {
+            timer += get_micro_time();
+            #pragma omp critical (log_strict_dissection)
+            log_message("Finished computing top level separator, its size is " +
+                        std::to_string(is_separator_node.population_count()) + " nodes needed " +
+                        std::to_string(timer) + "musec");
+        }
+
+        BitVector keep_arc = make_bit_vector(
+                part.arc_count(),
+                [&](unsigned a) {
+                    return !is_separator_node.is_set(part.tail[a]) &&
+                           !is_separator_node.is_set(part.head[a]);
+                }
+        );
+
+        inplace_keep_element_of_vector_if(keep_arc, part.tail);
+        inplace_keep_element_of_vector_if(keep_arc, part.head);
+        inplace_keep_element_of_vector_if(keep_arc, part.back_arc);
+
+        {
+            LocalIDMapper map(keep_arc);
+            for (auto &x: part.back_arc)
+                x = map.to_local(x);
+        }
+
+        part.first_out = invert_vector(part.tail, part.node_count());
+        assert_fragment_is_valid(part);
+
+        if (log) {
+            #pragma omp critical (log_strict_dissection)
+            log_message("Start computing remaining separator decomposition using recursion");
+            timer = -get_micro_time();
+        }
+        auto sub_decomp = compute_separator_decomposition_with_strict_dissection(
+                std::move(part), compute_cut, std::move(is_separator_node), std::move(cut.is_node_on_side),
+                [](const std::string &) {}, min_parallel_node_count);
+        if (log) {
+            timer += get_micro_time();
+            #pragma omp critical (log_strict_dissection)
+            log_message("Finished recursion, needed " + std::to_string(timer) + "musec");
+        }
+        return sub_decomp;
+    }
+
     // Modification of compute_separator_decomposition from RoutingKit/include/routingkit/nested_dissection.h.
     // Computes separator decomposition using strict dissection, i.e., each separator has exactly two children in the
     // nested decomposition. Sub-graphs may not be connected (unlike in general separator decomposition) but the
     // balance of the decomposition is improved.
+    //
+    // If this function is called in a parallel region, the two sub-graphs remaining after each cut are decomposed
+    // by separate tasks, unless they have fewer than min_parallel_node_count nodes. The sub-decompositions are
+    // merged in a fixed order, so the result does not depend on the number of threads as long as compute_cut is
+    // deterministic. compute_cut may be called concurrently.
     SeparatorDecomposition compute_separator_decomposition_with_strict_dissection(
             GraphFragment&& fragment,
             const std::function<CutSide(const GraphFragment &)> &compute_cut,
             BitVector&& prev_is_separator_node,
             BitVector&& prev_cut_side,
-            const std::function<void(const std::string &)> &log_message = [](const std::string &) {}
+            const std::function<void(const std::string &)> &log_message,
+            unsigned min_parallel_node_count
     ) {
         assert_fragment_is_valid(fragment);
 
-        long long timer = 0;
-
         SeparatorDecomposition decomp;
         decomp.order.resize(fragment.node_count());
 
@@ -136,59 +215,31 @@ namespace RoutingKit {
 
             // Decompose graph into two subgraphs
             auto parts = decompose_into_at_most_two_subgraphs_along_separator(std::move(fragment), ~prev_cut_side & ~prev_is_separator_node, prev_cut_side & ~prev_is_separator_node);
-            for (auto &part: parts) {
-                assert(part.node_count() != 0);
-                if (part.node_count() == 1) {
-                    decomp.order[--order_end] = part.global_node_id[0];
-                } else {
-                    if (log_message && part.node_count() > 1000) {
-                        log_message("Computing decomposition for top level component with " +
-                                    std::to_string(part.node_count()) + " nodes");
-                        timer = -get_micro_time();
-                        log_message("Start computing top level separator");
-                    }
-                    auto cut = compute_cut(part);
-                    auto is_separator_node = derive_separator_from_cut(part, cut.is_node_on_side);
-                    if (log_message && part.node_count() > 1000) {
-                        timer += get_micro_time();
-                        log_message("Finished computing top level separator, its size is " +
-                                    std::to_string(is_separator_node.population_count()) + " nodes needed " +
-                                    std::to_string(timer) + "musec");
-                    }
-
-                    BitVector keep_arc = make_bit_vector(
-                            part.arc_count(),
-                            [&](unsigned a) {
-                                return !is_separator_node.is_set(part.tail[a]) &&
-                                       !is_separator_node.is_set(part.head[a]);
-                            }
-                    );
-
-                    inplace_keep_element_of_vector_if(keep_arc, part.tail);
-                    inplace_keep_element_of_vector_if(keep_arc, part.head);
-                    inplace_keep_element_of_vector_if(keep_arc, part.back_arc);
-
-                    {
-                        LocalIDMapper map(keep_arc);
-                        for (auto &x: part.back_arc)
-                            x = map.to_local(x);
-                    }
-
-                    part.first_out = invert_vector(part.tail, part.node_count());
-                    assert_fragment_is_valid(part);
-
 
-                    if (log_message && part.node_count() > 1000) {
-                        timer = -get_micro_time();
-                        log_message("Start computing remaining separator decomposition using recursion");
-                    }
-
-                    auto sub_decomp = compute_separator_decomposition_with_strict_dissection(std::move(part), compute_cut, std::move(is_separator_node), std::move(cut.is_node_on_side));
-                    if (log_message && part.node_count() > 1000) {
-                        timer += get_micro_time();
-                        log_message("Finished recursion, needed " + std::to_string(timer) + "musec");
-                    }
+            // Decompose the non-trivial subgraphs, in parallel if both are large enough.
+            std::vector<unsigned> part_node_count(parts.size());
+            for (unsigned i = 0; i < parts.size(); ++i)
+                part_node_count[i] = parts[i].node_count();
+            std::vector<SeparatorDecomposition> sub_decomps(parts.size());
+            for (unsigned i = 0; i < parts.size(); ++i) {
+                assert(part_node_count[i] != 0);
+                if (part_node_count[i] == 1)
+                    continue;
+                const bool spawn_task = parts.size() == 2 && i == 0 &&
+                                        part_node_count[0] >= min_parallel_node_count &&
+                                        part_node_count[1] >= min_parallel_node_count;
+                #pragma omp task default(shared) firstprivate(i) if(spawn_task)
+                sub_decomps[i] = compute_separator_decomposition_of_part(
+                        std::move(parts[i]), compute_cut, log_message, min_parallel_node_count);
+            }
+            #pragma omp taskwait
 
+            // Merge the sub-decompositions in the order of the subgraphs.
+            for (unsigned i = 0; i < parts.size(); ++i) {
+                if (part_node_count[i] == 1) {
+                    decomp.order[--order_end] = parts[i].global_node_id[0];
+                } else {
+                    auto &sub_decomp = sub_decomps[i];
                     for (auto &node: sub_decomp.tree) {
                         if (node.left_child != 0)
                             node.left_child += decomp.tree.size();
@@ -213,4 +264,4 @@ namespace RoutingKit {
         return decomp; // NVRO
     }
 
-}
\ No newline at end of file
+}
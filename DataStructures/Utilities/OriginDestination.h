@@ -1,12 +1,21 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
 #include <csv.h>
 
+#include "Tools/BinaryIO.h"
 #include "Tools/Constants.h"
+#include "Tools/MemoryMappedFile.h"
+#include "Tools/StringHelpers.h"
 
 // An origin-destination (OD) pair, representing a travel demand or a query.
 struct OriginDestination {
@@ -24,11 +33,13 @@ struct OriginDestination {
 };
 
 // An origin-destination (OD) pair that additionally stores an origin zone and a destination zone.
-// Zones or traffic cells represent for example residential or commercial areas.
+// Zones or traffic cells represent for example residential or commercial areas. The weight is the
+// number of trips represented by the OD pair.
 struct ClusteredOriginDestination : public OriginDestination {
   // Constructs a clustered OD-pair from o to d.
-  ClusteredOriginDestination(const int o, const int d, const int oZone, const int dZone)
-      : OriginDestination(o, d), originZone(oZone), destinationZone(dZone) {}
+  ClusteredOriginDestination(
+      const int o, const int d, const int oZone, const int dZone, const int weight = 1)
+      : OriginDestination(o, d), originZone(oZone), destinationZone(dZone), weight(weight) {}
 
   // Compares this clustered OD-pair with rhs lexicographically.
   bool operator<(const ClusteredOriginDestination& rhs) const {
@@ -50,11 +61,138 @@ struct ClusteredOriginDestination : public OriginDestination {
 
   int originZone;
   int destinationZone;
+  int weight;
 };
 
-// Reads the specified file into a vector of OD-pairs.
+// A set of OD pairs stored column by column, as held in a binary OD file. A binary OD file starts
+// with a header consisting of a magic number, the number of OD pairs, the number of columns, and
+// the name of each column. The header is followed by the values of each column, one column after
+// another, with one 32-bit integer per OD pair. The first two columns are always origin and
+// destination. Further columns are optional, e.g., origin_zone, destination_zone, or dijkstra_rank.
+class ODPairColumns {
+ public:
+  // The magic number identifying binary OD files.
+  static constexpr uint32_t MAGIC_NUMBER = 0x4f445031;
+
+  // Constructs an empty set of OD pairs with only the columns origin and destination.
+  ODPairColumns() : names({"origin", "destination"}), values(2) {}
+
+  // Returns the number of OD pairs.
+  int numPairs() const {
+    return values[0].size();
+  }
+
+  // Returns the number of columns.
+  int numColumns() const {
+    return values.size();
+  }
+
+  // Returns the name of the i-th column.
+  const std::string& columnName(const int i) const {
+    assert(i >= 0); assert(i < numColumns());
+    return names[i];
+  }
+
+  // Returns the index of the column with the specified name, or -1 if there is no such column.
+  int findColumn(const std::string& name) const {
+    const auto it = std::find(names.begin(), names.end(), name);
+    return it != names.end() ? it - names.begin() : -1;
+  }
+
+  // Adds a column with the specified name, and returns its index.
+  int addColumn(const std::string& name) {
+    if (findColumn(name) != -1)
+      throw std::invalid_argument("duplicate column -- '" + name + "'");
+    names.push_back(name);
+    values.emplace_back(numPairs());
+    return numColumns() - 1;
+  }
+
+  // Returns the values in the i-th column.
+  std::vector<int32_t>& column(const int i) {
+    assert(i >= 0); assert(i < numColumns());
+    return values[i];
+  }
+
+  // Returns the values in the i-th column.
+  const std::vector<int32_t>& column(const int i) const {
+    assert(i >= 0); assert(i < numColumns());
+    return values[i];
+  }
+
+  // Returns the origins of the OD pairs.
+  const std::vector<int32_t>& origins() const {
+    return values[0];
+  }
+
+  // Returns the destinations of the OD pairs.
+  const std::vector<int32_t>& destinations() const {
+    return values[1];
+  }
+
+  // Writes the OD pairs to the specified binary OD file.
+  void writeTo(const std::string& outfile) const {
+    for (const auto& col : values)
+      if (col.size() != numPairs())
+        throw std::invalid_argument("columns of OD pairs differ in length");
+    std::ofstream out(outfile, std::ios::binary);
+    if (!out.good())
+      throw std::invalid_argument("file cannot be opened -- '" + outfile + "'");
+    bio::write(out, MAGIC_NUMBER);
+    bio::write(out, numPairs());
+    bio::write(out, numColumns());
+    for (const auto& name : names)
+      bio::write(out, name);
+    for (const auto& col : values)
+      bio::write(out, col.data(), col.size());
+    out.close();
+    if (!out.good())
+      throw std::invalid_argument("file cannot be written -- '" + outfile + "'");
+  }
+
+  // Reads the OD pairs from the specified binary OD file. The file is memory-mapped, and the
+  // columns are copied out of the mapping in parallel.
+  void readFrom(const std::string& infile) {
+    MemoryMappedFile in(infile);
+    uint32_t magicNumber;
+    int numPairs, numColumns;
+    bio::read(in, magicNumber);
+    if (magicNumber != MAGIC_NUMBER)
+      throw std::invalid_argument("not a binary OD file -- '" + infile + "'");
+    bio::read(in, numPairs);
+    bio::read(in, numColumns);
+    if (numPairs < 0 || numColumns < 2)
+      throw std::invalid_argument("corrupt binary OD file -- '" + infile + "'");
+    names.resize(numColumns);
+    for (auto& name : names)
+      bio::read(in, name);
+    if (names[0] != "origin" || names[1] != "destination")
+      throw std::invalid_argument("corrupt binary OD file -- '" + infile + "'");
+    values.assign(numColumns, std::vector<int32_t>(numPairs));
+    const auto numBytesPerColumn = static_cast<int64_t>(numPairs) * sizeof(int32_t);
+    const auto firstByte = in.consume(numColumns * numBytesPerColumn);
+    #pragma omp parallel for schedule(static)
+    for (auto i = 0; i < numColumns; ++i)
+      std::memcpy(values[i].data(), firstByte + i * numBytesPerColumn, numBytesPerColumn);
+  }
+
+ private:
+  std::vector<std::string> names;           // The name of each column.
+  std::vector<std::vector<int32_t>> values; // The values in each column.
+};
+
+// Reads the specified file into a vector of OD-pairs. Files ending in .bin are binary OD files.
 std::vector<OriginDestination> importODPairsFrom(const std::string& infile) {
   std::vector<OriginDestination> pairs;
+  if (endsWith(infile, ".bin")) {
+    ODPairColumns columns;
+    columns.readFrom(infile);
+    pairs.reserve(columns.numPairs());
+    for (auto i = 0; i < columns.numPairs(); ++i)
+      pairs.emplace_back(columns.origins()[i], columns.destinations()[i]);
+    return pairs;
+  }
+
   int origin, destination;
   using TrimPolicy = io::trim_chars<>;
   using QuotePolicy = io::no_quote_escape<','>;
@@ -70,9 +208,24 @@ std::vector<OriginDestination> importODPairsFrom(const std::string& infile) {
   return pairs;
 }
 
-// Reads the specified file into a vector of clustered OD-pairs.
+// Reads the specified file into a vector of clustered OD-pairs. Files ending in .bin are binary OD
+// files.
 std::vector<ClusteredOriginDestination> importClusteredODPairsFrom(const std::string& infile) {
   std::vector<ClusteredOriginDestination> pairs;
+  if (endsWith(infile, ".bin")) {
+    ODPairColumns columns;
+    columns.readFrom(infile);
+    const auto oZoneCol = columns.findColumn("origin_zone");
+    const auto dZoneCol = columns.findColumn("destination_zone");
+    pairs.reserve(columns.numPairs());
+    for (auto i = 0; i < columns.numPairs(); ++i) {
+      const auto oZone = oZoneCol != -1 ? columns.column(oZoneCol)[i] : INVALID_ID;
+      const auto dZone = dZoneCol != -1 ? columns.column(dZoneCol)[i] : INVALID_ID;
+      pairs.emplace_back(columns.origins()[i], columns.destinations()[i], oZone, dZone);
+    }
+    return pairs;
+  }
+
   int origin, destination, originZone = INVALID_ID, destinationZone = INVALID_ID;
   using TrimPolicy = io::trim_chars<>;
   using QuotePolicy = io::no_quote_escape<','>;
@@ -88,3 +241,64 @@ std::vector<ClusteredOriginDestination> importClusteredODPairsFrom(const std::st
   }
   return pairs;
 }
+
+// Reads the specified file into a set of OD pairs stored column by column, as used for point-to-point
+// queries. Binary OD files (ending in .bin) are read with all their columns. From CSV files, the
+// columns origin, destination, and dijkstra_rank (if present) are read. Throws if a vertex ID is
+// not in the range [0, numVertices).
+inline ODPairColumns importODPairColumnsFrom(const std::string& infile, const int numVertices) {
+  ODPairColumns pairs;
+  if (endsWith(infile, ".bin")) {
+    pairs.readFrom(infile);
+  } else {
+    int origin, destination, rank;
+    using TrimPolicy = io::trim_chars<>;
+    using QuotePolicy = io::no_quote_escape<','>;
+    using OverflowPolicy = io::throw_on_overflow;
+    using CommentPolicy = io::single_line_comment<'#'>;
+    io::CSVReader<3, TrimPolicy, QuotePolicy, OverflowPolicy, CommentPolicy> in(infile);
+    const io::ignore_column ignore = io::ignore_extra_column | io::ignore_missing_column;
+    in.read_header(ignore, "origin", "destination", "dijkstra_rank");
+    const auto rankCol = in.has_column("dijkstra_rank") ? pairs.addColumn("dijkstra_rank") : -1;
+    while (in.read_row(origin, destination, rank)) {
+      pairs.column(0).push_back(origin);
+      pairs.column(1).push_back(destination);
+      if (rankCol != -1)
+        pairs.column(rankCol).push_back(rank);
+    }
+  }
+
+  for (auto i = 0; i < pairs.numPairs(); ++i) {
+    const auto origin = pairs.origins()[i];
+    const auto destination = pairs.destinations()[i];
+    if (origin < 0 || origin >= numVertices || destination < 0 || destination >= numVertices)
+      throw std::invalid_argument(
+          "vertex ID out of range in OD pair " + std::to_string(i) + " -- '" + infile + "'");
+  }
+  return pairs;
+}
+
+// Collapses OD-pairs with the same origin and destination into a single pair whose weight is the sum
+// of the weights of the collapsed pairs. The remaining pairs keep the order of their first occurrence.
+inline void aggregateODPairs(std::vector<ClusteredOriginDestination>& pairs) {
+  std::vector<int> perm(pairs.size());
+  std::iota(perm.begin(), perm.end(), 0);
+  std::stable_sort(perm.begin(), perm.end(), [&](const int i, const int j) {
+    return pairs[i].OriginDestination::operator<(pairs[j]);
+  });
+
+  // Add the weight of each duplicate to its first occurrence, and mark the duplicate as removed.
+  for (auto i = 0, j = 1; j < perm.size(); ++j) {
+    auto& first = pairs[perm[i]];
+    auto& pair = pairs[perm[j]];
+    if (pair.origin == first.origin && pair.destination == first.destination) {
+      first.weight += pair.weight;
+      pair.weight = 0;
+    } else {
+      i = j;
+    }
+  }
+  pairs.erase(std::remove_if(pairs.begin(), pairs.end(), [](const ClusteredOriginDestination& od) {
+    return od.weight == 0;
+  }), pairs.end());
+}
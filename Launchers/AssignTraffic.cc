@@ -1,19 +1,23 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <random>
+#include <sstream>
 #include <stack>
 #include <stdexcept>
 #include <string>
+#include <system_error>
 #include <utility>
 #include <vector>
 
-#include <routingkit/customizable_contraction_hierarchy.h>
-#include <routingkit/nested_dissection.h>
+#include <csv.h>
 
+#include "Algorithms/CCH/CCH.h"
 #include "Algorithms/TrafficAssignment/Adapters/BiDijkstraAdapter.h"
 #include "Algorithms/TrafficAssignment/Adapters/CCHAdapter.h"
 #include "Algorithms/TrafficAssignment/Adapters/CHAdapter.h"
@@ -27,7 +31,6 @@
 #include "Algorithms/TrafficAssignment/TraversalCostFunctions/InverseFunction.h"
 #include "Algorithms/TrafficAssignment/TraversalCostFunctions/ModifiedDavidsonFunction.h"
 #include "Algorithms/TrafficAssignment/FrankWolfeAssignment.h"
-#include "DataStructures/Containers/BitVector.h"
 #include "DataStructures/Graph/Attributes/CapacityAttribute.h"
 #include "DataStructures/Graph/Attributes/EdgeIdAttribute.h"
 #include "DataStructures/Graph/Attributes/LatLngAttribute.h"
@@ -36,9 +39,14 @@
 #include "DataStructures/Graph/Attributes/TravelTimeAttribute.h"
 #include "DataStructures/Graph/Attributes/TraversalCostAttribute.h"
 #include "DataStructures/Graph/Graph.h"
+#include "DataStructures/Partitioning/SeparatorDecomposition.h"
 #include "DataStructures/Utilities/OriginDestination.h"
+#include "Tools/ArenaAllocator.h"
+#include "Tools/ColumnarFile.h"
 #include "Tools/CommandLine/CommandLineParser.h"
 #include "Tools/Constants.h"
+#include "Tools/EnumParser.h"
+#include "Tools/MemoryMappedFile.h"
 #include "Tools/StringHelpers.h"
 #include "Algorithms/TrafficAssignment/Adapters/CTLAdapter.h"
 
@@ -50,6 +58,8 @@ inline void printUsage() {
       "  -so               find the system optimum (default: user equilibrium)\n"
       "  -l                use physical lengths as metric (default: travel time)\n"
       "  -i                output all intermediate flow patterns and OD distances\n"
+      "  -bin              output flow patterns and OD distances in binary columnar format\n"
+      "  -mmap             memory-map the network instead of reading it through a stream\n"
       "  -v                display informative messages\n"
       "  -p <hrs>          period of analysis in hours (default: 1)\n"
       "  -n <num>          number of iterations (0 means to use the stopping criterion)\n"
@@ -57,14 +67,28 @@ inline void printUsage() {
       "                      possible values: BPR (default) Davidson M-Davidson inverse\n"
       "  -a <algo>         shortest-path algorithm\n"
       "                      possible values: Dijkstra Bi-Dijkstra CH CCH (default) CTLSA CTLSACCH CTL\n"
+      "  -no-agg           route duplicate OD pairs separately instead of as one weighted pair\n"
       "  -o <ord>          order in which the OD pairs are processed\n"
       "                      possible values: random input sorted (default)\n"
       "  -U <num>          maximum diameter of a cell (used for ordering OD pairs)\n"
       "  -g <file>         network in binary format\n"
-      "  -d <file>         OD pairs to be assigned onto the network\n"
+      "  -s <file>         separator decomposition of the network in binary format\n"
+      "  -b <balances>     space-separated balance parameters in % for nested dissection\n"
+      "                      (default: 30); each is tried and the best cut is kept\n"
+      "  -rot <num>        try <num> rotations of the inertial-flow directions (default: 1)\n"
+      "  -d <file>         OD pairs to be assigned (binary OD file if <file> ends in .bin)\n"
       "  -flow <file>      place the flow pattern after each iteration in <file>\n"
       "  -dist <file>      place the OD distances after each iteration in <file>\n"
       "  -stat <file>      place statistics about the execution in <file>\n"
+      "  -ckpt <file>      place a checkpoint of the assignment in <file>\n"
+      "  -ckpt-n <num>     write a checkpoint every <num> iterations (default: 1)\n"
+      "  -resume <file>    continue an interrupted assignment from the checkpoint in <file>\n"
+      "  -warm <file>      start from the last flow pattern in <file> (written with -flow)\n"
+      "  -pages <kind>     kind of pages backing the CCH weights and CTL labels\n"
+      "                      possible values: default thp 2mb 1gb\n"
+      "  -interleave       interleave the CCH weights and CTL labels across NUMA nodes\n"
+      "  -replicate        replicate the CTL labels on each NUMA node for the queries (CTL only;\n"
+      "                      bind the threads to cores, e.g., by OMP_PROC_BIND=true)\n"
       "  -help             display this help and exit\n";
 }
 
@@ -78,33 +102,24 @@ struct ActiveVertex {
   int nextUnexploredEdge; // The next unexplored incident edge.
 };
 
+// Parses the specified space-separated list of balance parameters for nested dissection.
+inline std::vector<int> parseBalances(const std::string& str) {
+  std::vector<int> balances;
+  std::istringstream iss(str);
+  int balance;
+  while (iss >> balance)
+    balances.push_back(balance);
+  if (!iss.eof() || balances.empty())
+    throw std::invalid_argument("invalid balance parameters -- '" + str + "'");
+  return balances;
+}
+
 // Assigns origin and destination zones to OD pairs based on a partition of the elimination tree.
-template <typename GraphT>
 inline void assignZonesToODPairs(
-    const GraphT& inputGraph, std::vector<ClusteredOriginDestination>& odPairs, const int maxDiam) {
-  // Convert the input graph to RoutingKit's graph representation.
-  const int numVertices = inputGraph.numVertices();
-  std::vector<float> lats(numVertices);
-  std::vector<float> lngs(numVertices);
-  std::vector<unsigned int> tails(inputGraph.numEdges());
-  std::vector<unsigned int> heads(inputGraph.numEdges());
-  FORALL_VERTICES(inputGraph, u) {
-    lats[u] = inputGraph.latLng(u).latInDeg();
-    lngs[u] = inputGraph.latLng(u).lngInDeg();
-    FORALL_INCIDENT_EDGES(inputGraph, u, e) {
-      tails[e] = u;
-      heads[e] = inputGraph.edgeHead(e);
-    }
-  }
-
-  // Compute the contraction order and the corresponding elimination tree.
-  const auto graph = RoutingKit::make_graph_fragment(numVertices, tails, heads);
-  auto computeSep = [&lats, &lngs](const RoutingKit::GraphFragment& graph) {
-    return derive_separator_from_cut(graph, inertial_flow(graph, 30, lats, lngs).is_node_on_side);
-  };
-  const auto order = compute_nested_node_dissection_order(graph, computeSep);
-  const auto cch = RoutingKit::CustomizableContractionHierarchy(order, tails, heads);
-  std::vector<int> tree(cch.elimination_tree_parent.begin(), cch.elimination_tree_parent.end());
+    const CCH& cch, std::vector<ClusteredOriginDestination>& odPairs, const int maxDiam) {
+  const auto& tree = cch.getEliminationTree(); // tree[r] is the parent of the vertex with rank r.
+  const auto& ranks = cch.getRanks();
+  const int numVertices = tree.size();
 
   // Build the elimination out-tree from the elimination in-tree.
   std::vector<int> firstChild(numVertices + 1);
@@ -122,34 +137,56 @@ inline void assignZonesToODPairs(
     firstChild[v] = firstChild[v - 1];
   firstChild[0] = 0;
 
+  // Group the vertices by the height of their (full) subtree. Vertices in the same group do not
+  // depend on each other in the cell decomposition below.
+  std::vector<int> level(numVertices);
+  for (auto v = 0; v < numVertices - 1; ++v)
+    level[tree[v]] = std::max(level[tree[v]], level[v] + 1);
+  const auto numLevels = level[numVertices - 1] + 1;
+  std::vector<int> firstVertexOfLevel(numLevels + 1);
+  std::vector<int> verticesByLevel(numVertices);
+  for (auto v = 0; v < numVertices; ++v)
+    ++firstVertexOfLevel[level[v] + 1];
+  for (auto l = 1; l <= numLevels; ++l)
+    firstVertexOfLevel[l] += firstVertexOfLevel[l - 1];
+  for (auto v = 0; v < numVertices; ++v)
+    verticesByLevel[firstVertexOfLevel[level[v]]++] = v;
+  for (auto l = numLevels; l > 0; --l)
+    firstVertexOfLevel[l] = firstVertexOfLevel[l - 1];
+  firstVertexOfLevel[0] = 0;
+
   // Decompose the elimination tree into as few cells with bounded diameter as possible.
-  BitVector isRoot(numVertices);
-  std::vector<int> height(numVertices); // height[v] is the height of the subtree rooted at v.
-  for (auto v = 0; v < numVertices; ++v) {
-    const auto first = firstChild[v];
-    const auto last = firstChild[v + 1];
-    std::sort(children.begin() + first, children.begin() + last, [&](const auto u, const auto v) {
-      assert(u >= 0); assert(u < height.size());
-      assert(v >= 0); assert(v < height.size());
-      return height[u] < height[v];
-    });
-    for (auto i = first; i < last; ++i)
-      if (height[v] + 1 + height[children[i]] <= maxDiam)
-        height[v] = 1 + height[children[i]];
-      else
-        isRoot[children[i]] = true;
+  std::vector<char> isRoot(numVertices); // Not a BitVector, since threads set adjacent entries.
+  std::vector<int> height(numVertices);  // height[v] is the height of the subtree rooted at v.
+  for (auto l = 0; l < numLevels; ++l) {
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (auto i = firstVertexOfLevel[l]; i < firstVertexOfLevel[l + 1]; ++i) {
+      const auto v = verticesByLevel[i];
+      const auto first = firstChild[v];
+      const auto last = firstChild[v + 1];
+      std::sort(children.begin() + first, children.begin() + last, [&](const auto u, const auto v) {
+        assert(u >= 0); assert(u < height.size());
+        assert(v >= 0); assert(v < height.size());
+        return height[u] < height[v];
+      });
+      for (auto j = first; j < last; ++j)
+        if (height[v] + 1 + height[children[j]] <= maxDiam)
+          height[v] = 1 + height[children[j]];
+        else
+          isRoot[children[j]] = true;
+    }
   }
 
   // Number the cells in the order in which they are discovered during a DFS from the root.
   int freeCellId = 1; // The next free cell ID.
-  std::vector<int> cellIds(numVertices);
+  std::vector<int> cellIds(numVertices); // cellIds[r] is the cell of the vertex with rank r.
   std::stack<ActiveVertex, std::vector<ActiveVertex>> activeVertices;
   activeVertices.emplace(numVertices - 1, firstChild[numVertices - 1]);
   while (!activeVertices.empty()) {
     auto &v = activeVertices.top();
     const auto head = children[v.nextUnexploredEdge];
     ++v.nextUnexploredEdge;
-    cellIds[order[head]] = isRoot[head] ? freeCellId++ : cellIds[order[v.id]];
+    cellIds[head] = isRoot[head] ? freeCellId++ : cellIds[v.id];
     if (v.nextUnexploredEdge == firstChild[v.id + 1])
       activeVertices.pop();
     if (firstChild[head] != firstChild[head + 1])
@@ -157,10 +194,58 @@ inline void assignZonesToODPairs(
   }
 
   // Assign origin and destination zones to OD pairs.
-  for (auto& od : odPairs) {
-    od.originZone = cellIds[od.origin];
-    od.destinationZone = cellIds[od.destination];
+  #pragma omp parallel for schedule(static)
+  for (auto i = 0; i < odPairs.size(); ++i) {
+    odPairs[i].originZone = cellIds[ranks[odPairs[i].origin]];
+    odPairs[i].destinationZone = cellIds[ranks[odPairs[i].destination]];
+  }
+}
+
+// Reads the flow pattern of the last iteration in the specified flow file, as written by -flow.
+inline std::vector<double> importFlowsFrom(const std::string& infile) {
+  std::vector<double> flows;
+  if (endsWith(infile, ".bin")) {
+    std::ifstream in(infile, std::ios::binary);
+    if (!in.good())
+      throw std::invalid_argument("file not found -- '" + infile + "'");
+    const auto columns = columnar::readHeader(in);
+    columnar::Block block;
+    while (block.readFrom(in, columns)) {
+      const auto vol = block.floatColumn(0);
+      flows.assign(vol, vol + block.numRows());
+    }
+    return flows;
+  }
+
+  int iteration, prevIteration = -1;
+  double vol;
+  using TrimPolicy = io::trim_chars<>;
+  using QuotePolicy = io::no_quote_escape<','>;
+  using OverflowPolicy = io::throw_on_overflow;
+  using CommentPolicy = io::single_line_comment<'#'>;
+  io::CSVReader<2, TrimPolicy, QuotePolicy, OverflowPolicy, CommentPolicy> in(infile);
+  in.read_header(io::ignore_extra_column, "iteration", "vol");
+  while (in.read_row(iteration, vol)) {
+    if (iteration != prevIteration)
+      flows.clear();
+    prevIteration = iteration;
+    flows.push_back(vol);
   }
+  return flows;
+}
+
+// Truncates the specified output file of an interrupted assignment to its size at the checkpoint,
+// so that the iterations after the checkpoint are not written twice.
+inline void truncateOutput(const std::string& fileName, const int64_t size) {
+  if (fileName.empty())
+    return;
+  std::error_code ec;
+  const auto fileSize = std::filesystem::file_size(fileName, ec);
+  if (ec || size < 0 || fileSize < static_cast<uintmax_t>(size))
+    throw std::invalid_argument("output file does not match the checkpoint -- '" + fileName + "'");
+  std::filesystem::resize_file(fileName, size, ec);
+  if (ec)
+    throw std::invalid_argument("file cannot be truncated -- '" + fileName + "'");
 }
 
 // Assigns all OD flows onto the graph.
@@ -170,13 +255,19 @@ inline void assignTraffic(const CommandLineParser& clp) {
   const auto findSO = clp.isSet("so");
   const auto useLengths = clp.isSet("l");
   const auto outputIntermediates = clp.isSet("i");
+  const auto binaryOutput = clp.isSet("bin");
+  const auto useMmap = clp.isSet("mmap");
   auto verbose = clp.isSet("v");
   const auto veryVerbose = clp.isSet("vv");
   if (veryVerbose) verbose = true; // If very verbose, also verbose.
   const auto analysisPeriod = clp.getValue<double>("p", 0);
   const auto traversalCostFunction = clp.getValue<std::string>("f", "BPR");
   const auto shortestPathAlgorithm = clp.getValue<std::string>("a", "CCH");
+  const auto aggregate = !clp.isSet("no-agg");
   const auto ord = clp.getValue<std::string>("o", "sorted");
+  const auto sepFileName = clp.getValue<std::string>("s");
+  const auto balances = parseBalances(clp.getValue<std::string>("b", "30"));
+  const auto numRotations = clp.getValue<int>("rot", 1);
   const auto maxDiam = clp.getValue<int>("U", 32);
   const auto graphFileName = clp.getValue<std::string>("g");
   const auto demandFileName = clp.getValue<std::string>("d");
@@ -184,23 +275,39 @@ inline void assignTraffic(const CommandLineParser& clp) {
   auto flowFileName = clp.getValue<std::string>("flow");
   auto distFileName = clp.getValue<std::string>("dist");
   auto statFileName = clp.getValue<std::string>("stat");
+  const auto checkpointFileName = clp.getValue<std::string>("ckpt");
+  const auto checkpointInterval = clp.getValue<int>("ckpt-n", 1);
+  const auto resumeFileName = clp.getValue<std::string>("resume");
+  const auto warmFileName = clp.getValue<std::string>("warm");
+  if (!resumeFileName.empty() && !warmFileName.empty())
+    throw std::invalid_argument("options -resume and -warm are mutually exclusive");
+  if (ord != "random" && ord != "sorted" && ord != "input")
+    throw std::invalid_argument("unrecognized order -- '" + ord + "'");
+  if (checkpointInterval <= 0)
+    throw std::invalid_argument("invalid checkpoint interval -- '" + std::to_string(checkpointInterval) + "'");
   if (useLengths)
     numIterations = 1;
-  if (!flowFileName.empty() && !endsWith(flowFileName, ".csv"))
-    flowFileName += ".csv";
-  if (!distFileName.empty() && !endsWith(distFileName, ".csv"))
-    distFileName += ".csv";
+  const std::string outputExtension = binaryOutput ? ".bin" : ".csv";
+  if (!flowFileName.empty() && !endsWith(flowFileName, outputExtension))
+    flowFileName += outputExtension;
+  if (!distFileName.empty() && !endsWith(distFileName, outputExtension))
+    distFileName += outputExtension;
   if (!statFileName.empty() && !endsWith(statFileName, ".csv"))
     statFileName += ".csv";
 
 
   // Read the graph from file.
   std::cout << "Reading graph from file..." << std::flush;
-  std::ifstream graphFile(graphFileName, std::ios::binary);
-  if (!graphFile.good())
-    throw std::invalid_argument("file not found -- '" + graphFileName + "'");
-  typename FWAssignmentT::Graph graph(graphFile);
-  graphFile.close();
+  typename FWAssignmentT::Graph graph;
+  if (useMmap) {
+    MemoryMappedFile graphFile(graphFileName);
+    graph.readFrom(graphFile);
+  } else {
+    std::ifstream graphFile(graphFileName, std::ios::binary);
+    if (!graphFile.good())
+      throw std::invalid_argument("file not found -- '" + graphFileName + "'");
+    graph.readFrom(graphFile);
+  }
   FORALL_VALID_EDGES(graph, u, e) {
     graph.capacity(e) = std::max(std::round(analysisPeriod * graph.capacity(e)), 1.0);
     graph.edgeId(e) = e;
@@ -237,58 +344,139 @@ inline void assignTraffic(const CommandLineParser& clp) {
   }
   std::cout << " done." << std::endl;
 
+  if (aggregate) {
+    std::cout << "Aggregating duplicate OD-pairs..." << std::flush;
+    const auto numTrips = odPairs.size();
+    aggregateODPairs(odPairs);
+    std::cout << " done (" << numTrips << " trips, " << odPairs.size() << " pairs)." << std::endl;
+  }
+
+  // Read the separator decomposition from file if one is given.
+  SeparatorDecomposition sepDecomp;
+  if (!sepFileName.empty()) {
+    std::cout << "Reading separator decomposition from file..." << std::flush;
+    std::ifstream sepFile(sepFileName, std::ios::binary);
+    if (!sepFile.good())
+      throw std::invalid_argument("file not found -- '" + sepFileName + "'");
+    sepDecomp.readFrom(sepFile);
+    if (sepDecomp.order.size() != graph.numVertices())
+      throw std::invalid_argument("separator decomposition does not match the network");
+    std::cout << " done." << std::endl;
+  }
+
+  FWAssignmentT fwAssignment(
+      graph, odPairs, verbose, veryVerbose, sepFileName.empty() ? nullptr : &sepDecomp, balances,
+      numRotations);
+
+  // Reorder the OD pairs. Sorting clusters them using the elimination tree of the CCH built by the
+  // shortest-path algorithm, or of a CCH built from the separator decomposition if it uses none.
   std::cout << "Reordering pairs ..." << std::flush;
   if (ord == "random") {
     std::shuffle(odPairs.begin(), odPairs.end(), std::minstd_rand());
   } else if (ord == "sorted") {
-    assignZonesToODPairs(graph, odPairs, maxDiam);
+    if (fwAssignment.getCCH() != nullptr) {
+      assignZonesToODPairs(*fwAssignment.getCCH(), odPairs, maxDiam);
+    } else {
+      using CCHAdapter = trafficassignment::CCHAdapter<typename FWAssignmentT::Graph, TravelTimeAttribute>;
+      if (sepFileName.empty())
+        sepDecomp = CCHAdapter::computeSeparatorDecomposition(graph, balances, numRotations);
+      CCH cch;
+      cch.preprocess(graph, sepDecomp);
+      assignZonesToODPairs(cch, odPairs, maxDiam);
+    }
     std::sort(odPairs.begin(), odPairs.end());
-  } else if (ord != "input") {
-    throw std::invalid_argument("unrecognized order -- '" + ord + "'");
   }
   std::cout << " done." << std::endl;
 
+  const auto resume = !resumeFileName.empty();
+  if (resume) {
+    std::cout << "Reading checkpoint from file..." << std::flush;
+    std::ifstream resumeFile(resumeFileName, std::ios::binary);
+    if (!resumeFile.good())
+      throw std::invalid_argument("file not found -- '" + resumeFileName + "'");
+    const auto outputSizes = fwAssignment.readCheckpointFrom(resumeFile);
+    truncateOutput(flowFileName, outputSizes.flow);
+    truncateOutput(distFileName, outputSizes.dist);
+    truncateOutput(statFileName, outputSizes.stat);
+    std::cout << " done." << std::endl;
+  } else if (!warmFileName.empty()) {
+    std::cout << "Reading initial flow pattern from file..." << std::flush;
+    const auto flows = importFlowsFrom(warmFileName);
+    if (flows.size() != graph.numEdges())
+      throw std::invalid_argument("flow pattern does not match the network -- '" + warmFileName + "'");
+    fwAssignment.warmStart(flows);
+    std::cout << " done." << std::endl;
+  }
+
+  // When resuming an interrupted assignment, append to the output files of the interrupted run,
+  // which have been truncated to their sizes at the checkpoint.
+  const auto mode = resume ? std::ios::out | std::ios::app : std::ios::out;
+
+  // Binary output is written by background threads, so that the assignment never waits for I/O.
+  columnar::AsyncWriter flowWriter;
+  columnar::AsyncWriter distWriter;
+  if (binaryOutput && !flowFileName.empty()) {
+    const std::vector<columnar::Column> columns = {
+        {"vol", columnar::ColumnType::FLOAT32}, {"sat", columnar::ColumnType::FLOAT32}};
+    flowWriter.open(flowFileName, columns, resume);
+  }
+  if (binaryOutput && !distFileName.empty())
+    distWriter.open(distFileName, {{"traversal_cost", columnar::ColumnType::INT32}}, resume);
+
   std::ofstream flowFile;
-  if (!flowFileName.empty()) {
-    flowFile.open(flowFileName);
+  if (!flowFileName.empty() && !binaryOutput) {
+    flowFile.open(flowFileName, mode);
     if (!flowFile.good())
       throw std::invalid_argument("file cannot be opened -- '" + flowFileName + "'");
-    if (!statFileName.empty())
+    if (resume)
+      flowFile.seekp(0, std::ios::end);
+    if (!statFileName.empty() && !resume)
       flowFile << "# Stat file: " << statFileName << "\n";
-    flowFile << "iteration,vol,sat\n";
+    if (!resume)
+      flowFile << "iteration,vol,sat\n";
   }
 
   std::ofstream distFile;
-  if (!distFileName.empty()) {
-    distFile.open(distFileName);
+  if (!distFileName.empty() && !binaryOutput) {
+    distFile.open(distFileName, mode);
     if (!distFile.good())
       throw std::invalid_argument("file cannot be opened -- '" + distFileName + "'");
-    if (!statFileName.empty())
+    if (resume)
+      distFile.seekp(0, std::ios::end);
+    if (!statFileName.empty() && !resume)
       distFile << "# Stat file: " << statFileName << "\n";
-    distFile << "iteration,traversal_cost\n";
+    if (!resume)
+      distFile << "iteration,traversal_cost\n";
   }
 
   std::ofstream statFile;
   if (!statFileName.empty()) {
-    statFile.open(statFileName);
+    statFile.open(statFileName, mode);
     if (!statFile.good())
       throw std::invalid_argument("file cannot be opened -- '" + statFileName + "'");
+    if (resume)
+      statFile.seekp(0, std::ios::end);
+  }
+  if (statFile.is_open() && !resume) {
     statFile << "# Graph: " << graphFileName << "\n";
     statFile << "# Demand: " << demandFileName << "\n";
     statFile << "# Objective function: " << (findSO ? "SO" : "UE") << "\n";
     statFile << "# Traversal cost function: " << traversalCostFunction << "\n";
     statFile << "# Shortest-path algorithm: " << shortestPathAlgorithm << "\n";
     statFile << "# Period of analysis: " << analysisPeriod << "\n";
-    statFile << std::flush;
-  }
-  FWAssignmentT fwAssignment(graph, odPairs, verbose, veryVerbose);
-  if (statFile.is_open()) {
     statFile << "# Preprocessing time: " << fwAssignment.stats.totalRunningTime << "ms\n";
     statFile << "iteration,customization_time,query_time,line_search_time,total_time,";
     statFile << "prev_total_traversal_cost,prev_relative_gap,checksum\n";
     statFile << std::flush;
   }
-  fwAssignment.run(flowFile, distFile, statFile, numIterations, outputIntermediates);
+
+  fwAssignment.setBinaryOutput(
+      flowWriter.isOpen() ? &flowWriter : nullptr, distWriter.isOpen() ? &distWriter : nullptr);
+  fwAssignment.run(
+      flowFile, distFile, statFile, numIterations, outputIntermediates,
+      checkpointFileName, checkpointInterval);
+  flowWriter.close();
+  distWriter.close();
 }
 
 // Picks the shortest-path algorithm according to the command line options.
@@ -365,6 +553,11 @@ int main(int argc, char* argv[]) {
       printUsage();
       return EXIT_SUCCESS;
     }
+    ArenaPolicy::global().pageKind = EnumParser<PageKind>()(clp.getValue<std::string>("pages", "default"));
+    ArenaPolicy::global().interleave = clp.isSet("interleave");
+    ArenaPolicy::global().replicate = clp.isSet("replicate");
+    if (clp.isSet("interleave") && clp.isSet("replicate"))
+      throw std::invalid_argument("options -interleave and -replicate are mutually exclusive");
     chooseObjFunction(clp);
   } catch (std::invalid_argument& e) {
     std::cerr << argv[0] << ": " << e.what() << std::endl;
@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <omp.h>
+
+#include "Algorithms/CCH/CCH.h"
+#include "Algorithms/CCH/CCHMetric.h"
+#include "Algorithms/CTL/BalancedTopologyCentricTreeHierarchy.h"
+#include "Algorithms/CTL/CTLMetric.h"
+#include "Algorithms/CTL/TruncatedTreeLabelling.h"
+#include "DataStructures/Graph/Attributes/LatLngAttribute.h"
+#include "DataStructures/Graph/Attributes/LengthAttribute.h"
+#include "DataStructures/Graph/Attributes/TravelTimeAttribute.h"
+#include "DataStructures/Graph/Graph.h"
+#include "DataStructures/Labels/BasicLabelSet.h"
+#include "DataStructures/Labels/ParentInfo.h"
+#include "DataStructures/Labels/SimdLabelSet.h"
+#include "DataStructures/Partitioning/SeparatorDecomposition.h"
+#include "Tools/ArenaAllocator.h"
+#include "Tools/CommandLine/CommandLineParser.h"
+#include "Tools/EnumParser.h"
+#include "Tools/Timer.h"
+
+inline void printUsage() {
+  std::cout <<
+      "Usage: BenchmarkCustomization -g <file> -s <file> [-t <num>] [-n <num>] [-grain <num>]\n"
+      "Measures how the running times of the CCH and CTL customization scale with the number of\n"
+      "threads. Both customizations are run with 1, 2, 4, ... threads up to the maximum number.\n"
+      "  -g <file>         input graph in binary format\n"
+      "  -s <file>         separator decomposition of the input graph\n"
+      "  -l                use physical lengths as metric (default: travel times)\n"
+      "  -t <num>          use at most <num> threads (default: maximum number of OpenMP threads)\n"
+      "  -n <num>          run each customization <num> times and report the mean (default: 5)\n"
+      "  -grain <num>      process subtrees with at most <num> vertices in a single task\n"
+      "                      (default: 0, i.e., choose depending on the number of threads)\n"
+      "  -pages <kind>     kind of pages backing the CCH weights and CTL labels\n"
+      "                      possible values: default thp 2mb 1gb\n"
+      "  -interleave       interleave the CCH weights and CTL labels across NUMA nodes\n"
+      "  -help             display this help and exit\n";
+}
+
+using VertexAttributes = VertexAttrs<LatLngAttribute>;
+using EdgeAttributes = EdgeAttrs<LengthAttribute, TravelTimeAttribute>;
+using GraphT = StaticGraph<VertexAttributes, EdgeAttributes>;
+using CTLLabelSet = std::conditional_t<CTL_SIMD_LOGK == 0,
+    BasicLabelSet<0, ParentInfo::NO_PARENT_INFO>,
+    SimdLabelSet<CTL_SIMD_LOGK, ParentInfo::NO_PARENT_INFO>>;
+using LabellingT = TruncatedTreeLabelling<CTLLabelSet::K, CTLLabelSet::KEEP_PARENT_EDGES>;
+using CTLMetricT = CTLMetric<LabellingT, CTLLabelSet, CTL_USE_PERFECT_CUSTOMIZATION>;
+
+// Prints a row of the output table.
+inline void printRow(const int numThreads, const double cchTime, const double ctlTime,
+                     const double cchBaseTime, const double ctlBaseTime) {
+  std::cout << std::setw(7) << numThreads << std::fixed << std::setprecision(1);
+  std::cout << std::setw(12) << cchTime << std::setw(10) << std::setprecision(2);
+  std::cout << cchBaseTime / std::max(cchTime, 1e-3);
+  std::cout << std::setw(12) << std::setprecision(1) << ctlTime << std::setw(10) << std::setprecision(2);
+  std::cout << ctlBaseTime / std::max(ctlTime, 1e-3) << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  try {
+    CommandLineParser clp(argc, argv);
+    if (clp.isSet("help")) {
+      printUsage();
+      return EXIT_SUCCESS;
+    }
+
+    const auto graphFileName = clp.getValue<std::string>("g");
+    const auto sepFileName = clp.getValue<std::string>("s");
+    const auto useLengths = clp.isSet("l");
+    const auto maxNumThreads = clp.getValue<int>("t", omp_get_max_threads());
+    const auto numRuns = clp.getValue<int>("n", 5);
+    const auto grainSize = clp.getValue<int>("grain", 0);
+    ArenaPolicy::global().pageKind = EnumParser<PageKind>()(clp.getValue<std::string>("pages", "default"));
+    ArenaPolicy::global().interleave = clp.isSet("interleave");
+    if (maxNumThreads < 1)
+      throw std::invalid_argument("invalid number of threads -- '" + std::to_string(maxNumThreads) + "'");
+    if (numRuns < 1)
+      throw std::invalid_argument("invalid number of runs -- '" + std::to_string(numRuns) + "'");
+    if (grainSize < 0)
+      throw std::invalid_argument("invalid grain size -- '" + std::to_string(grainSize) + "'");
+
+    std::cout << "Reading the input..." << std::flush;
+    std::ifstream graphFile(graphFileName, std::ios::binary);
+    if (!graphFile.good())
+      throw std::invalid_argument("file not found -- '" + graphFileName + "'");
+    GraphT graph(graphFile);
+    graphFile.close();
+    std::ifstream sepFile(sepFileName, std::ios::binary);
+    if (!sepFile.good())
+      throw std::invalid_argument("file not found -- '" + sepFileName + "'");
+    SeparatorDecomposition sepDecomp;
+    sepDecomp.readFrom(sepFile);
+    sepFile.close();
+    std::cout << " done." << std::endl;
+
+    std::cout << "Running the metric-independent preprocessing..." << std::flush;
+    CCH cch;
+    cch.preprocess(graph, sepDecomp);
+    BalancedTopologyCentricTreeHierarchy hierarchy;
+    hierarchy.preprocess(graph, sepDecomp);
+    LabellingT ctl(hierarchy);
+    ctl.init();
+    std::cout << " done." << std::endl;
+
+    const auto inputWeights = useLengths ? &graph.length(0) : &graph.travelTime(0);
+    CCHMetric cchMetric(cch, inputWeights);
+    cchMetric.setParallelGrainSize(grainSize);
+    CTLMetricT ctlMetric(hierarchy, cch, inputWeights);
+    ctlMetric.setParallelGrainSize(grainSize);
+
+    // The times are the mean running times in milliseconds. The speedups are relative to one thread.
+    std::cout << "threads   CCH [ms]   speedup    CTL [ms]   speedup\n";
+    double cchBaseTime = 0;
+    double ctlBaseTime = 0;
+    for (auto numThreads = 1;; numThreads = std::min(2 * numThreads, maxNumThreads)) {
+      omp_set_num_threads(numThreads);
+      Timer timer;
+      for (auto i = 0; i < numRuns; ++i)
+        cchMetric.customize();
+      const auto cchTime = static_cast<double>(timer.elapsed<std::chrono::microseconds>()) / (1000.0 * numRuns);
+      timer.restart();
+      for (auto i = 0; i < numRuns; ++i)
+        ctlMetric.buildCustomizedCTL(ctl);
+      const auto ctlTime = static_cast<double>(timer.elapsed<std::chrono::microseconds>()) / (1000.0 * numRuns);
+      if (numThreads == 1) {
+        cchBaseTime = cchTime;
+        ctlBaseTime = ctlTime;
+      }
+      printRow(numThreads, cchTime, ctlTime, cchBaseTime, ctlBaseTime);
+      if (numThreads == maxNumThreads)
+        break;
+    }
+  } catch (std::invalid_argument& e) {
+    std::cerr << argv[0] << ": " << e.what() << std::endl;
+    std::cerr << "Try '" << argv[0] << " -help' for more information." << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
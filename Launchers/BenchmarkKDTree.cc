@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "DataStructures/Geometry/KDTree.h"
+#include "DataStructures/Geometry/Point.h"
+#include "DataStructures/Graph/Attributes/LatLngAttribute.h"
+#include "DataStructures/Graph/Graph.h"
+#include "Tools/CommandLine/CommandLineParser.h"
+#include "Tools/Timer.h"
+
+inline void printUsage() {
+  std::cout <<
+      "Usage: BenchmarkKDTree [-g <file>] [-p <num>] [-n <num>] [-k <num>] [-r <num>]\n"
+      "Measures the running times of nearest-neighbor, k-nearest-neighbor, and radius queries\n"
+      "on a kd-tree. Nearest-neighbor queries are also run recursively, as a baseline. The\n"
+      "results of the first queries are validated against a linear scan.\n"
+      "  -g <file>         take the points from the coordinates of a graph in binary format\n"
+      "  -p <num>          otherwise, generate <num> uniformly random points (default: 1000000)\n"
+      "  -n <num>          run <num> random queries of each kind (default: 100000)\n"
+      "  -k <num>          find the <num> closest points in k-NN queries (default: 8)\n"
+      "  -r <num>          find all points within radius <num> in radius queries (default: 100)\n"
+      "  -v <num>          validate the first <num> queries of each kind (default: 100)\n"
+      "  -seed <seed>      start the random number generator with <seed> (default: 19900325)\n"
+      "  -help             display this help and exit\n";
+}
+
+// Returns the squared distance between the two specified points.
+inline int64_t getSquaredDistance(const Point& p, const Point& q) {
+  const int64_t dx = int64_t{p.x()} - q.x();
+  const int64_t dy = int64_t{p.y()} - q.y();
+  return dx * dx + dy * dy;
+}
+
+// Returns the squared distances from the query point to all points, ordered increasingly.
+inline std::vector<int64_t> getSortedDistances(const std::vector<Point>& points, const Point& q) {
+  std::vector<int64_t> dists(points.size());
+  for (auto i = 0; i < points.size(); ++i)
+    dists[i] = getSquaredDistance(points[i], q);
+  std::sort(dists.begin(), dists.end());
+  return dists;
+}
+
+// Validates the results of all kinds of queries against the specified sorted distances from the
+// query point to all points. Returns a description of the first wrong result, or an empty string.
+inline std::string validateQuery(
+    const KDTree& tree, const std::vector<Point>& points, const Point& q,
+    const std::vector<int64_t>& dists, const int k, const int radius) {
+  if (getSquaredDistance(points[tree.findClosestPoint(q)], q) != dists[0])
+    return "wrong result of nearest-neighbor query";
+  if (getSquaredDistance(points[tree.findClosestPointRecursively(q)], q) != dists[0])
+    return "wrong result of recursive nearest-neighbor query";
+  const auto closestK = tree.findKClosestPoints(q, k);
+  if (closestK.size() != std::min<size_t>(k, points.size()))
+    return "wrong number of results of k-NN query";
+  for (auto j = 0; j < closestK.size(); ++j)
+    if (getSquaredDistance(points[closestK[j]], q) != dists[j])
+      return "wrong result of k-NN query";
+  const auto bound = int64_t{radius} * radius;
+  const auto numWithinRadius = std::upper_bound(dists.begin(), dists.end(), bound) - dists.begin();
+  if (tree.findPointsWithinRadius(q, radius).size() != numWithinRadius)
+    return "wrong result of radius query";
+  return {};
+}
+
+// Prints a row of the output table.
+inline void printRow(const std::string& kind, const int64_t time, const int n, const int64_t sum) {
+  std::cout << std::setw(9) << std::left << kind << std::right;
+  std::cout << std::setw(15) << std::fixed << std::setprecision(3);
+  std::cout << static_cast<double>(time) / std::max(n, 1);
+  std::cout << std::setw(15) << sum << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  try {
+    CommandLineParser clp(argc, argv);
+    if (clp.isSet("help")) {
+      printUsage();
+      return EXIT_SUCCESS;
+    }
+
+    const auto numPoints = clp.getValue<int>("p", 1000000);
+    const auto numQueries = clp.getValue<int>("n", 100000);
+    const auto k = clp.getValue<int>("k", 8);
+    const auto radius = clp.getValue<int>("r", 100);
+    const auto numValidations = std::min(clp.getValue<int>("v", 100), numQueries);
+    const auto seed = clp.getValue<int>("seed", 19900325);
+    if (numPoints < 1)
+      throw std::invalid_argument("too few points -- '" + std::to_string(numPoints) + "'");
+    if (k < 0)
+      throw std::invalid_argument("invalid number of neighbors -- '" + std::to_string(k) + "'");
+    if (radius < 0)
+      throw std::invalid_argument("invalid radius -- '" + std::to_string(radius) + "'");
+
+    std::minstd_rand rand(seed);
+    std::vector<Point> points;
+    if (clp.isSet("g")) {
+      std::cout << "Reading the input graph..." << std::flush;
+      const auto graphFileName = clp.getValue<std::string>("g");
+      std::ifstream graphFile(graphFileName, std::ios::binary);
+      if (!graphFile.good())
+        throw std::invalid_argument("file not found -- '" + graphFileName + "'");
+      StaticGraph<VertexAttrs<LatLngAttribute>> graph(graphFile);
+      FORALL_VERTICES(graph, v)
+        points.emplace_back(graph.latLng(v).longitude(), graph.latLng(v).latitude());
+      std::cout << " done." << std::endl;
+    } else {
+      std::uniform_int_distribution<> dist(0, 1 << 20);
+      points.resize(numPoints);
+      for (auto& p : points)
+        p = {dist(rand), dist(rand)};
+    }
+    if (points.empty())
+      throw std::invalid_argument("no points to store in the kd-tree");
+
+    // Draw the queries uniformly at random from the bounding box of the points.
+    auto minX = points[0].x(), maxX = points[0].x(), minY = points[0].y(), maxY = points[0].y();
+    for (const auto& p : points) {
+      minX = std::min(minX, p.x());
+      maxX = std::max(maxX, p.x());
+      minY = std::min(minY, p.y());
+      maxY = std::max(maxY, p.y());
+    }
+    std::uniform_int_distribution<> distX(minX, maxX);
+    std::uniform_int_distribution<> distY(minY, maxY);
+    std::vector<Point> queries(numQueries);
+    for (auto& q : queries)
+      q = {distX(rand), distY(rand)};
+
+    std::cout << "Building the kd-tree..." << std::flush;
+    Timer timer;
+    KDTree tree(points);
+    const auto buildTime = timer.elapsed();
+    std::cout << " done (" << buildTime << "ms)." << std::endl;
+
+    std::cout << "Validating the results..." << std::flush;
+    for (auto i = 0; i < numValidations; ++i) {
+      const auto error = validateQuery(
+          tree, points, queries[i], getSortedDistances(points, queries[i]), k, radius);
+      if (!error.empty()) {
+        std::cout << std::endl;
+        std::cerr << argv[0] << ": " << error << " -- query " << i << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    std::cout << " done." << std::endl;
+
+    // The last column holds a checksum, i.e., the sum of the IDs of all returned points.
+    std::cout << "query    time [us/query]       checksum\n";
+    int64_t sum = 0;
+    timer.restart();
+    for (const auto& q : queries)
+      sum += tree.findClosestPointRecursively(q);
+    printRow("nn-rec", timer.elapsed<std::chrono::microseconds>(), numQueries, sum);
+
+    sum = 0;
+    timer.restart();
+    for (const auto& q : queries)
+      sum += tree.findClosestPoint(q);
+    printRow("nn", timer.elapsed<std::chrono::microseconds>(), numQueries, sum);
+
+    sum = 0;
+    timer.restart();
+    for (const auto& q : queries)
+      for (const auto p : tree.findKClosestPoints(q, k))
+        sum += p;
+    printRow("knn", timer.elapsed<std::chrono::microseconds>(), numQueries, sum);
+
+    sum = 0;
+    timer.restart();
+    for (const auto& q : queries)
+      for (const auto p : tree.findPointsWithinRadius(q, radius))
+        sum += p;
+    printRow("radius", timer.elapsed<std::chrono::microseconds>(), numQueries, sum);
+  } catch (std::invalid_argument& e) {
+    std::cerr << argv[0] << ": " << e.what() << std::endl;
+    std::cerr << "Try '" << argv[0] << " -help' for more information." << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
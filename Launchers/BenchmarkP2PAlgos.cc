@@ -0,0 +1,458 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Algorithms/CCH/CCH.h"
+#include "Algorithms/CCH/CCHMetric.h"
+#include "Algorithms/CCH/EliminationTreeQuery.h"
+#include "Algorithms/CH/CH.h"
+#include "Algorithms/CH/CHQuery.h"
+#include "Algorithms/CTL/BalancedTopologyCentricTreeHierarchy.h"
+#include "Algorithms/CTL/CTLMetric.h"
+#include "Algorithms/CTL/CTLQuery.h"
+#include "Algorithms/CTL/TruncatedTreeLabelling.h"
+#include "Algorithms/CTNR/CTNR.h"
+#include "Algorithms/Dijkstra/BiDijkstra.h"
+#include "Algorithms/Dijkstra/Dijkstra.h"
+#include "DataStructures/Graph/Attributes/LatLngAttribute.h"
+#include "DataStructures/Graph/Attributes/LengthAttribute.h"
+#include "DataStructures/Graph/Attributes/TravelTimeAttribute.h"
+#include "DataStructures/Graph/Graph.h"
+#include "DataStructures/Labels/BasicLabelSet.h"
+#include "DataStructures/Labels/ParentInfo.h"
+#include "DataStructures/Labels/SimdLabelSet.h"
+#include "DataStructures/Partitioning/SeparatorDecomposition.h"
+#include "DataStructures/Utilities/OriginDestination.h"
+#include "Tools/CommandLine/CommandLineParser.h"
+#include "Tools/MemoryMappedFile.h"
+#include "Tools/PerfCounters.h"
+#include "Tools/StringHelpers.h"
+#include "Tools/Timer.h"
+
+inline void printUsage() {
+  std::cout <<
+      "Usage: BenchmarkP2PAlgos -g <file> -s <file> -d <file> -o <file> [-a <algos>] [-check <num>]\n"
+      "       BenchmarkP2PAlgos -g <file> -s <file> -n <num> -o <file> [-a <algos>] [-check <num>]\n"
+      "Runs several point-to-point shortest-path algorithms on the same graph and the same OD pairs,\n"
+      "verifies the distances they compute against Dijkstra's algorithm on a sample of the OD pairs,\n"
+      "and writes the preprocessing, customization and query statistics to a JSON report, which can\n"
+      "be compared between builds (e.g., with different CTL_THETA or CTL_SIMD_LOGK). The program\n"
+      "exits with a nonzero status if any algorithm computes a wrong distance.\n"
+      "  -g <file>         input graph in binary format\n"
+      "  -s <file>         separator decomposition of the input graph\n"
+      "  -d <file>         OD pairs (queries), binary OD file if <file> ends in .bin\n"
+      "  -n <num>          run <num> queries with OD pairs picked uniformly at random\n"
+      "  -seed <seed>      start random number generator with <seed> (default: 0)\n"
+      "  -l                use physical lengths as metric (default: travel times)\n"
+      "  -mmap             memory-map the input graph instead of reading it through a stream\n"
+      "  -a <algos>        space-separated list of algorithms to run\n"
+      "                      possible values: Dij Bi-Dij CH CCH-Dij CCH-tree CTL CTNR\n"
+      "                      (default: all but CTNR, which is known to compute wrong distances)\n"
+      "  -check <num>      verify <num> evenly spaced queries against Dijkstra (default: 1000)\n"
+      "  -o <file>         place the JSON report in <file>\n"
+      "  -help             display this help and exit\n";
+}
+
+using VertexAttributes = VertexAttrs<LatLngAttribute>;
+using EdgeAttributes = EdgeAttrs<LengthAttribute, TravelTimeAttribute>;
+using GraphT = StaticGraph<VertexAttributes, EdgeAttributes>;
+using LabelSet = BasicLabelSet<0, ParentInfo::NO_PARENT_INFO>;
+using CTLLabelSet = std::conditional_t<CTL_SIMD_LOGK == 0,
+    BasicLabelSet<0, ParentInfo::NO_PARENT_INFO>,
+    SimdLabelSet<CTL_SIMD_LOGK, ParentInfo::NO_PARENT_INFO>>;
+using LabellingT = TruncatedTreeLabelling<CTLLabelSet::K, CTLLabelSet::KEEP_PARENT_EDGES>;
+using CTLMetricT = CTLMetric<LabellingT, CTLLabelSet, CTL_USE_PERFECT_CUSTOMIZATION>;
+using CTLQueryT = CTLQuery<typename CTLMetricT::SearchGraph, LabellingT, CTLLabelSet>;
+
+// The query algorithms.
+using Dij = Dijkstra<GraphT, TravelTimeAttribute, LabelSet>;
+using BiDij = BiDijkstra<Dij>;
+using CHDij = CHQuery<LabelSet, true>;
+using CCHTree = EliminationTreeQuery<LabelSet>;
+
+// The number of top levels of the separator decomposition whose vertices are transit nodes in CTNR.
+static constexpr int CTNR_TRANSIT_NODE_LEVELS = 5;
+
+// The maximum number of wrong distances that are printed for each algorithm.
+static constexpr int MAX_PRINTED_MISMATCHES = 10;
+
+// The statistics collected for a single algorithm.
+struct AlgorithmReport {
+  std::string name;                // The name of the algorithm.
+  int64_t preprocessingTime = 0;   // The time for the metric-independent preprocessing in us.
+  int64_t customizationTime = 0;   // The time for the customization in us.
+  PerfCounts preprocessingPerf;    // The hardware events during the preprocessing.
+  PerfCounts customizationPerf;    // The hardware events during the customization.
+  PerfCounts queryPerf;            // The hardware events during all queries.
+  std::vector<int64_t> queryTimes; // The running time of each query in ns.
+  uint64_t distanceChecksum = 0;   // A hash of the distances computed for all queries.
+  int numMismatches = 0;           // The number of sampled queries with a wrong distance.
+};
+
+// The OD pairs and the sample of them that is verified against Dijkstra's algorithm.
+struct QuerySet {
+  ODPairColumns pairs;         // The OD pairs, with vertex IDs in the input graph.
+  std::vector<int> sample;     // The indices of the OD pairs that are verified.
+  std::vector<int> distances;  // The correct distance for each verified OD pair.
+};
+
+// Reads the input graph from the specified binary file, optionally through a memory mapping.
+inline GraphT readGraph(const std::string& graphFileName, const bool useMmap) {
+  GraphT graph;
+  if (useMmap) {
+    MemoryMappedFile graphFile(graphFileName);
+    graph.readFrom(graphFile);
+  } else {
+    std::ifstream graphFile(graphFileName, std::ios::binary);
+    if (!graphFile.good())
+      throw std::invalid_argument("file not found -- '" + graphFileName + "'");
+    graph.readFrom(graphFile);
+  }
+  return graph;
+}
+
+// Returns the specified number of OD pairs, with origin and destination picked uniformly at random.
+inline ODPairColumns generateODPairs(const int numVertices, const int numPairs, const int seed) {
+  ODPairColumns pairs;
+  std::minstd_rand rand(seed + 1);
+  std::uniform_int_distribution<> dist(0, numVertices - 1);
+  for (auto i = 0; i < numPairs; ++i) {
+    pairs.column(0).push_back(dist(rand));
+    pairs.column(1).push_back(dist(rand));
+  }
+  return pairs;
+}
+
+// Runs the specified phase (e.g., the customization) and records its running time in us and the
+// hardware events that occurred.
+template <typename PhaseT>
+inline void runPhase(PhaseT phase, int64_t& time, PerfCounts& perf) {
+  PerfMeter perfMeter;
+  Timer timer;
+  phase();
+  time = timer.elapsed<std::chrono::microseconds>();
+  perf = perfMeter.elapsed();
+}
+
+// Runs the specified algorithm on all OD pairs and checks the distances of the sampled OD pairs.
+// The translate function maps vertex IDs in the input graph to those used by the algorithm, and
+// getDistance returns the distance computed by the last query.
+template <typename AlgoT, typename TranslateT, typename GetDistanceT>
+inline void runQueries(
+    AlgoT& algo, const QuerySet& queries, TranslateT translate, GetDistanceT getDistance,
+    AlgorithmReport& report) {
+  const auto& pairs = queries.pairs;
+  std::vector<int> distances(pairs.numPairs());
+  report.queryTimes.assign(pairs.numPairs(), 0);
+  Timer timer;
+  PerfMeter perfMeter(PerfScope::THREAD);
+  for (auto i = 0; i < pairs.numPairs(); ++i) {
+    const auto dst = translate(pairs.destinations()[i]);
+    const auto src = translate(pairs.origins()[i]);
+    perfMeter.restart();
+    timer.restart();
+    algo.run(src, dst);
+    report.queryTimes[i] = timer.elapsed<std::chrono::nanoseconds>();
+    report.queryPerf += perfMeter.elapsed();
+    distances[i] = getDistance(algo, dst);
+  }
+
+  // Hash the distances with FNV-1a, so that reports from different builds can be compared.
+  report.distanceChecksum = 14695981039346656037ull;
+  for (const auto dist : distances) {
+    report.distanceChecksum ^= static_cast<uint32_t>(dist);
+    report.distanceChecksum *= 1099511628211ull;
+  }
+
+  for (auto i = 0; i < queries.sample.size(); ++i) {
+    const auto q = queries.sample[i];
+    if (distances[q] == queries.distances[i])
+      continue;
+    if (report.numMismatches++ < MAX_PRINTED_MISMATCHES)
+      std::cerr << report.name << ": wrong distance for OD pair " << q << " ("
+                << pairs.origins()[q] << " -> " << pairs.destinations()[q] << "): "
+                << distances[q] << " instead of " << queries.distances[i] << std::endl;
+  }
+}
+
+// Reads the separator decomposition from the specified file.
+inline SeparatorDecomposition readSepDecomp(const std::string& sepFileName) {
+  std::ifstream sepFile(sepFileName, std::ios::binary);
+  if (!sepFile.good())
+    throw std::invalid_argument("file not found -- '" + sepFileName + "'");
+  SeparatorDecomposition sepDecomp;
+  sepDecomp.readFrom(sepFile);
+  return sepDecomp;
+}
+
+// Runs the preprocessing, customization and query phase of the specified algorithm.
+inline AlgorithmReport benchmark(
+    const std::string& algoName, const GraphT& graph, const SeparatorDecomposition& sepDecomp,
+    const QuerySet& queries) {
+  AlgorithmReport report;
+  report.name = algoName;
+  const auto identity = [](const int v) { return v; };
+  const auto getDistance = [](auto& algo, int) { return algo.getDistance(); };
+  const auto inputWeights = &graph.travelTime(0);
+
+  if (algoName == "Dij") {
+
+    Dij algo(graph);
+    runQueries(algo, queries, identity, [](Dij& algo, const int t) {
+      return algo.getDistance(t);
+    }, report);
+
+  } else if (algoName == "Bi-Dij") {
+
+    GraphT reverseGraph;
+    runPhase([&] { reverseGraph = graph.getReverseGraph(); },
+             report.preprocessingTime, report.preprocessingPerf);
+    BiDij algo(graph, reverseGraph);
+    runQueries(algo, queries, identity, getDistance, report);
+
+  } else if (algoName == "CH") {
+
+    // A CH has no metric-independent preprocessing, so we report its construction as customization.
+    CH ch;
+    runPhase([&] { ch.preprocess<TravelTimeAttribute>(graph); },
+             report.customizationTime, report.customizationPerf);
+    CHDij algo(ch);
+    runQueries(algo, queries, [&](const int v) { return ch.rank(v); }, getDistance, report);
+
+  } else if (algoName == "CCH-Dij" || algoName == "CCH-tree") {
+
+    CCH cch;
+    runPhase([&] { cch.preprocess(graph, sepDecomp); },
+             report.preprocessingTime, report.preprocessingPerf);
+    CH minCH;
+    runPhase([&] { minCH = CCHMetric(cch, inputWeights).buildMinimumWeightedCH(); },
+             report.customizationTime, report.customizationPerf);
+    const auto translate = [&](const int v) { return minCH.rank(v); };
+    if (algoName == "CCH-Dij") {
+      CHDij algo(minCH);
+      runQueries(algo, queries, translate, getDistance, report);
+    } else {
+      CCHTree algo(minCH, cch.getEliminationTree());
+      runQueries(algo, queries, translate, getDistance, report);
+    }
+
+  } else if (algoName == "CTL") {
+
+    CCH cch;
+    BalancedTopologyCentricTreeHierarchy hierarchy;
+    LabellingT ctl(hierarchy);
+    runPhase([&] {
+      cch.preprocess(graph, sepDecomp);
+      hierarchy.preprocess(graph, sepDecomp);
+      ctl.init();
+    }, report.preprocessingTime, report.preprocessingPerf);
+    CTLMetricT metric(hierarchy, cch, inputWeights);
+    runPhase([&] { metric.buildCustomizedCTL(ctl); },
+             report.customizationTime, report.customizationPerf);
+    CTLQueryT algo(
+        hierarchy, metric.upwardGraph(), metric.downwardGraph(),
+        metric.upwardWeights(), metric.downwardWeights(), ctl);
+    runQueries(algo, queries, [&](const int v) { return cch.getRanks()[v]; }, getDistance, report);
+
+  } else if (algoName == "CTNR") {
+
+    CTNR<GraphT> ctnr(sepDecomp, CTNR_TRANSIT_NODE_LEVELS);
+    runPhase([&] { ctnr.preprocess(graph); }, report.preprocessingTime, report.preprocessingPerf);
+    runPhase([&] { ctnr.customize(inputWeights); },
+             report.customizationTime, report.customizationPerf);
+    CTNRQuery<GraphT> algo(ctnr.getMetric());
+    const auto& ranks = ctnr.getCCH().getRanks();
+    runQueries(algo, queries, [&](const int v) { return ranks[v]; }, getDistance, report);
+
+  } else {
+    throw std::invalid_argument("invalid P2P algorithm -- '" + algoName + "'");
+  }
+  return report;
+}
+
+// Returns the specified string as a JSON string literal.
+inline std::string toJsonString(const std::string& str) {
+  std::ostringstream literal;
+  literal << '"';
+  for (const auto c : str) {
+    if (c == '"' || c == '\\')
+      literal << '\\' << c;
+    else if (static_cast<unsigned char>(c) < 0x20)
+      literal << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c);
+    else
+      literal << c;
+  }
+  literal << '"';
+  return literal.str();
+}
+
+// Writes the specified hardware event counts, each divided by the specified number, as a JSON object.
+inline void writePerfCounts(std::ostream& out, const PerfCounts& counts, const double divisor = 1) {
+  static constexpr const char* NAMES[] = {
+    "cycles", "instructions", "llc_misses", "dtlb_misses", "branch_misses"
+  };
+  out << '{';
+  for (auto e = 0; e < PerfCounts::NUM_EVENTS; ++e)
+    out << (e > 0 ? ", " : "") << '"' << NAMES[e] << "\": " << counts.values[e] / divisor;
+  out << '}';
+}
+
+// Writes the statistics collected for the specified algorithm as a JSON object.
+inline void writeReport(std::ostream& out, const AlgorithmReport& report) {
+  auto times = report.queryTimes;
+  std::sort(times.begin(), times.end());
+  const auto numQueries = std::max<int>(times.size(), 1);
+  const auto percentile = [&](const int p) {
+    return times.empty() ? 0 : times[std::min<int>(times.size() - 1, int64_t{p} * times.size() / 100)];
+  };
+  int64_t totalTime = 0;
+  for (const auto time : times)
+    totalTime += time;
+
+  out << "    {\n";
+  out << "      \"name\": " << toJsonString(report.name) << ",\n";
+  out << "      \"preprocessing_us\": " << report.preprocessingTime << ",\n";
+  out << "      \"customization_us\": " << report.customizationTime << ",\n";
+  out << "      \"query_ns\": {";
+  out << "\"mean\": " << static_cast<double>(totalTime) / numQueries << ", ";
+  out << "\"p50\": " << percentile(50) << ", ";
+  out << "\"p90\": " << percentile(90) << ", ";
+  out << "\"p99\": " << percentile(99) << ", ";
+  out << "\"max\": " << (times.empty() ? 0 : times.back()) << "},\n";
+  if constexpr (PERF_COUNTERS_ENABLED) {
+    out << "      \"perf\": {\n";
+    out << "        \"preprocessing\": ";
+    writePerfCounts(out, report.preprocessingPerf);
+    out << ",\n        \"customization\": ";
+    writePerfCounts(out, report.customizationPerf);
+    out << ",\n        \"per_query\": ";
+    writePerfCounts(out, report.queryPerf, numQueries);
+    out << "\n      },\n";
+  }
+  out << "      \"distance_checksum\": \"" << std::hex << std::setw(16) << std::setfill('0');
+  out << report.distanceChecksum << std::dec << std::setfill(' ') << "\",\n";
+  out << "      \"num_mismatches\": " << report.numMismatches << '\n';
+  out << "    }";
+}
+
+int main(int argc, char* argv[]) {
+  try {
+    CommandLineParser clp(argc, argv);
+    if (clp.isSet("help")) {
+      printUsage();
+      return EXIT_SUCCESS;
+    }
+
+    const auto graphFileName = clp.getValue<std::string>("g");
+    const auto sepFileName = clp.getValue<std::string>("s");
+    const auto odFileName = clp.getValue<std::string>("d");
+    const auto numRandomPairs = clp.getValue<int>("n", 0);
+    const auto seed = clp.getValue<int>("seed", 0);
+    const auto useLengths = clp.isSet("l");
+    const auto useMmap = clp.isSet("mmap");
+    const auto algoNames = clp.getValue<std::string>("a", "Dij Bi-Dij CH CCH-Dij CCH-tree CTL");
+    const auto maxNumChecks = clp.getValue<int>("check", 1000);
+    auto outputFileName = clp.getValue<std::string>("o");
+    if (odFileName.empty() && numRandomPairs <= 0)
+      throw std::invalid_argument("either -d <file> or -n <num> must be specified");
+    if (maxNumChecks < 0)
+      throw std::invalid_argument("invalid number of checks -- '" + std::to_string(maxNumChecks) + "'");
+    if (outputFileName.empty())
+      throw std::invalid_argument("no output file specified");
+    if (!endsWith(outputFileName, ".json"))
+      outputFileName += ".json";
+    std::ofstream outputFile(outputFileName);
+    if (!outputFile.good())
+      throw std::invalid_argument("file cannot be opened -- '" + outputFileName + "'");
+
+    std::cout << "Reading the input..." << std::flush;
+    auto graph = readGraph(graphFileName, useMmap);
+    if (useLengths)
+      FORALL_EDGES(graph, e)
+        graph.travelTime(e) = graph.length(e);
+    SeparatorDecomposition sepDecomp;
+    if (!sepFileName.empty())
+      sepDecomp = readSepDecomp(sepFileName);
+    QuerySet queries;
+    if (!odFileName.empty())
+      queries.pairs = importODPairColumnsFrom(odFileName, graph.numVertices());
+    else
+      queries.pairs = generateODPairs(graph.numVertices(), numRandomPairs, seed);
+    std::cout << " done." << std::endl;
+
+    // Compute the correct distances for an evenly spaced sample of the OD pairs.
+    std::cout << "Computing reference distances with Dijkstra..." << std::flush;
+    const auto numPairs = queries.pairs.numPairs();
+    const auto numChecks = std::min(maxNumChecks, numPairs);
+    Dij dij(graph);
+    for (auto i = 0; i < numChecks; ++i) {
+      const auto q = static_cast<int>(int64_t{i} * numPairs / numChecks);
+      dij.run(queries.pairs.origins()[q], queries.pairs.destinations()[q]);
+      queries.sample.push_back(q);
+      queries.distances.push_back(dij.getDistance(queries.pairs.destinations()[q]));
+    }
+    std::cout << " done." << std::endl;
+
+    std::vector<AlgorithmReport> reports;
+    auto numMismatches = 0;
+    std::istringstream algoNameStream(algoNames);
+    std::string algoName;
+    while (algoNameStream >> algoName) {
+      const auto needsSepDecomp = algoName != "Dij" && algoName != "Bi-Dij" && algoName != "CH";
+      if (needsSepDecomp && sepFileName.empty())
+        throw std::invalid_argument("algorithm '" + algoName + "' requires a separator decomposition");
+      std::cout << "Running " << algoName << "..." << std::flush;
+      reports.push_back(benchmark(algoName, graph, sepDecomp, queries));
+      numMismatches += reports.back().numMismatches;
+      std::cout << " done (" << reports.back().numMismatches << " wrong distances)." << std::endl;
+    }
+
+    outputFile << std::fixed << std::setprecision(1);
+    outputFile << "{\n";
+    outputFile << "  \"build\": {\n";
+    outputFile << "    \"ctl_theta\": " << CTL_THETA << ",\n";
+    outputFile << "    \"ctl_simd_logk\": " << CTL_SIMD_LOGK << ",\n";
+    outputFile << "    \"ctl_use_perfect_customization\": " << std::boolalpha;
+    outputFile << CTL_USE_PERFECT_CUSTOMIZATION << std::noboolalpha << ",\n";
+    outputFile << "    \"compiler\": " << toJsonString(__VERSION__) << '\n';
+    outputFile << "  },\n";
+    outputFile << "  \"input\": {\n";
+    outputFile << "    \"graph\": " << toJsonString(graphFileName) << ",\n";
+    outputFile << "    \"separator\": " << toJsonString(sepFileName) << ",\n";
+    outputFile << "    \"od_pairs\": " << toJsonString(odFileName) << ",\n";
+    outputFile << "    \"seed\": " << seed << ",\n";
+    outputFile << "    \"metric\": \"" << (useLengths ? "length" : "travel_time") << "\",\n";
+    outputFile << "    \"num_vertices\": " << graph.numVertices() << ",\n";
+    outputFile << "    \"num_edges\": " << graph.numEdges() << ",\n";
+    outputFile << "    \"num_queries\": " << numPairs << ",\n";
+    outputFile << "    \"num_checked\": " << numChecks << '\n';
+    outputFile << "  },\n";
+    outputFile << "  \"algorithms\": [\n";
+    for (auto i = 0; i < reports.size(); ++i) {
+      writeReport(outputFile, reports[i]);
+      outputFile << (i + 1 < reports.size() ? ",\n" : "\n");
+    }
+    outputFile << "  ]\n";
+    outputFile << "}\n";
+
+    if (numMismatches > 0) {
+      std::cerr << argv[0] << ": " << numMismatches << " wrong distances in total" << std::endl;
+      return EXIT_FAILURE;
+    }
+  } catch (std::invalid_argument& e) {
+    std::cerr << argv[0] << ": " << e.what() << std::endl;
+    std::cerr << "Try '" << argv[0] << " -help' for more information." << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Algorithms/Dijkstra/Dijkstra.h"
+#include "DataStructures/Graph/Attributes/CapacityAttribute.h"
+#include "DataStructures/Graph/Attributes/LatLngAttribute.h"
+#include "DataStructures/Graph/Attributes/TravelTimeAttribute.h"
+#include "DataStructures/Graph/Graph.h"
+#include "DataStructures/Graph/VertexOrders.h"
+#include "DataStructures/Labels/BasicLabelSet.h"
+#include "DataStructures/Labels/ParentInfo.h"
+#include "DataStructures/Partitioning/SeparatorDecomposition.h"
+#include "DataStructures/Utilities/Permutation.h"
+#include "Tools/CommandLine/CommandLineParser.h"
+#include "Tools/Constants.h"
+#include "Tools/MemoryMappedFile.h"
+#include "Tools/Timer.h"
+
+inline void printUsage() {
+  std::cout <<
+      "Usage: BenchmarkVertexOrders -g <file> [-s <file>] [-ord <ords>] [-n <num>] [-i <num>]\n"
+      "Measures how the order of the vertices in a graph affects the running times of Dijkstra's\n"
+      "algorithm and of the edge sweeps in each Frank-Wolfe iteration. The same queries are run on\n"
+      "the graph in its input order and after reordering it by each of the specified orders.\n"
+      "  -mmap             memory-map the input graph instead of reading it through a stream\n"
+      "  -g <file>         input graph in binary format\n"
+      "  -s <file>         separator decomposition of the input graph (enables order nd)\n"
+      "  -ord <ords>       space-separated list of vertex orders (default: hilbert dfs bfs)\n"
+      "                      possible values: hilbert dfs bfs nd\n"
+      "  -n <num>          run <num> random queries (default: 1000)\n"
+      "  -i <num>          run <num> Frank-Wolfe edge sweeps (default: 10)\n"
+      "  -seed <seed>      start the random number generator with <seed> (default: 19900325)\n"
+      "  -help             display this help and exit\n";
+}
+
+using VertexAttributes = VertexAttrs<LatLngAttribute>;
+using EdgeAttributes = EdgeAttrs<CapacityAttribute, TravelTimeAttribute>;
+using GraphT = StaticGraph<VertexAttributes, EdgeAttributes>;
+using LabelSet = BasicLabelSet<0, ParentInfo::FULL_PARENT_INFO>;
+using DijkstraT = Dijkstra<GraphT, TravelTimeAttribute, LabelSet>;
+
+// The running times and results obtained for a single vertex order.
+struct BenchmarkResult {
+  int64_t queryTime;    // The total time in microseconds spent on the queries.
+  int64_t sweepTime;    // The total time in microseconds spent on the edge sweeps.
+  int64_t sumOfDists;   // The sum of all shortest-path distances, which must be equal for all orders.
+  double sumOfCosts;    // The sum of all edge costs, which must be equal for all orders.
+};
+
+// Runs the specified queries and edge sweeps on the specified graph.
+inline BenchmarkResult runBenchmark(
+    const GraphT& graph, const std::vector<std::pair<int, int>>& queries, const int numSweeps) {
+  BenchmarkResult result = {};
+  DijkstraT dij(graph);
+  std::vector<std::vector<int32_t>> paths(queries.size());
+
+  // Run the queries, as done by the centralized shortest-path search in each FW iteration.
+  Timer timer;
+  for (auto i = 0; i < queries.size(); ++i) {
+    dij.run(queries[i].first, queries[i].second);
+    const auto dist = dij.getDistance(queries[i].second);
+    if (dist != INFTY) {
+      result.sumOfDists += dist;
+      paths[i] = dij.getReverseEdgePath(queries[i].second);
+    }
+  }
+  result.queryTime = timer.elapsed<std::chrono::microseconds>();
+
+  // Run the edge sweeps, i.e., load the flows onto the edges and evaluate the BPR function.
+  std::vector<double> flows(graph.numEdges());
+  std::vector<double> costs(graph.numEdges());
+  timer.restart();
+  for (auto i = 0; i < numSweeps; ++i) {
+    std::fill(flows.begin(), flows.end(), 0);
+    for (const auto& path : paths)
+      for (const auto e : path)
+        ++flows[e];
+    FORALL_EDGES(graph, e) {
+      const double tmp = flows[e] / std::max(graph.capacity(e), 1);
+      costs[e] = graph.travelTime(e) * (1 + 0.15 * tmp * tmp * tmp * tmp);
+    }
+  }
+  result.sweepTime = timer.elapsed<std::chrono::microseconds>();
+  FORALL_EDGES(graph, e)
+    result.sumOfCosts += costs[e];
+  return result;
+}
+
+// Prints the specified result in a row of the output table.
+inline void printResult(const std::string& order, const BenchmarkResult& result, const int n) {
+  std::cout << std::setw(9) << std::left << order << std::right;
+  std::cout << std::setw(15) << std::fixed << std::setprecision(2);
+  std::cout << static_cast<double>(result.queryTime) / std::max(n, 1);
+  std::cout << std::setw(15) << result.sweepTime / 1000;
+  std::cout << std::setw(17) << result.sumOfDists;
+  std::cout << std::setw(17) << std::setprecision(0) << result.sumOfCosts << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  try {
+    CommandLineParser clp(argc, argv);
+    if (clp.isSet("help")) {
+      printUsage();
+      return EXIT_SUCCESS;
+    }
+
+    const auto numQueries = clp.getValue<int>("n", 1000);
+    const auto numSweeps = clp.getValue<int>("i", 10);
+    const auto seed = clp.getValue<int>("seed", 19900325);
+    const auto orders = clp.getValue<std::string>("ord", "hilbert dfs bfs");
+
+    std::cout << "Reading the input graph..." << std::flush;
+    const auto graphFileName = clp.getValue<std::string>("g");
+    GraphT graph;
+    if (clp.isSet("mmap")) {
+      MemoryMappedFile graphFile(graphFileName);
+      graph.readFrom(graphFile);
+    } else {
+      std::ifstream graphFile(graphFileName, std::ios::binary);
+      if (!graphFile.good())
+        throw std::invalid_argument("file not found -- '" + graphFileName + "'");
+      graph.readFrom(graphFile);
+    }
+    SeparatorDecomposition sepDecomp;
+    if (clp.isSet("s")) {
+      const auto sepFileName = clp.getValue<std::string>("s");
+      std::ifstream sepFile(sepFileName, std::ios::binary);
+      if (!sepFile.good())
+        throw std::invalid_argument("file not found -- '" + sepFileName + "'");
+      sepDecomp.readFrom(sepFile);
+    }
+    std::cout << " done." << std::endl;
+
+    std::vector<std::pair<int, int>> queries(numQueries);
+    std::minstd_rand rand(seed);
+    std::uniform_int_distribution<> dist(0, graph.numVertices() - 1);
+    for (auto& query : queries)
+      query = {dist(rand), dist(rand)};
+
+    std::cout << "order    query [us/query]    sweeps [ms]   sum of dists   sum of costs\n";
+    printResult("input", runBenchmark(graph, queries, numSweeps), numQueries);
+
+    std::istringstream iss(orders);
+    std::string order;
+    while (iss >> order) {
+      const auto sepDecompPtr = clp.isSet("s") ? &sepDecomp : nullptr;
+      const auto perm = computeVertexOrder(graph, order, sepDecompPtr);
+      auto reorderedGraph = graph;
+      reorderedGraph.permuteVertices(perm);
+      auto reorderedQueries = queries;
+      for (auto& query : reorderedQueries)
+        query = {perm[query.first], perm[query.second]};
+      printResult(order, runBenchmark(reorderedGraph, reorderedQueries, numSweeps), numQueries);
+    }
+  } catch (std::invalid_argument& e) {
+    std::cerr << argv[0] << ": " << e.what() << std::endl;
+    std::cerr << "Try '" << argv[0] << " -help' for more information." << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,677 @@
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <csv.h>
+
+#include "Algorithms/CCH/CCH.h"
+#include "Algorithms/CCH/CCHMetric.h"
+#include "Algorithms/CCH/EliminationTreeQuery.h"
+#include "Algorithms/CH/CH.h"
+#include "Algorithms/CTL/BalancedTopologyCentricTreeHierarchy.h"
+#include "Algorithms/CTL/CTLMetric.h"
+#include "Algorithms/CTL/CTLQuery.h"
+#include "Algorithms/CTL/TruncatedTreeLabelling.h"
+#include "DataStructures/Graph/Attributes/LatLngAttribute.h"
+#include "DataStructures/Graph/Attributes/LengthAttribute.h"
+#include "DataStructures/Graph/Attributes/TravelTimeAttribute.h"
+#include "DataStructures/Graph/Graph.h"
+#include "DataStructures/Labels/BasicLabelSet.h"
+#include "DataStructures/Labels/ParentInfo.h"
+#include "DataStructures/Labels/SimdLabelSet.h"
+#include "DataStructures/Partitioning/SeparatorDecomposition.h"
+#include "Tools/BinaryIO.h"
+#include "Tools/CommandLine/CommandLineParser.h"
+#include "Tools/Constants.h"
+#include "Tools/MemoryMappedFile.h"
+#include "Tools/StringHelpers.h"
+#include "Tools/Timer.h"
+
+inline void printUsage() {
+  std::cout <<
+      "Usage: QueryDaemon -g <file> -s <file> -socket <file> [-a <algo>] [-t <num>] [-c <num>]\n"
+      "Loads a graph and its separator decomposition once, customizes the index, and then answers\n"
+      "point-to-point distance queries over a Unix domain socket until it is shut down.\n"
+      "  -a <algo>         serve queries with <algo>\n"
+      "                      possible values: CTL (default) CCH\n"
+      "  -g <file>         input graph in binary format\n"
+      "  -s <file>         separator decomposition of the input graph\n"
+      "  -socket <file>    listen on the Unix domain socket <file>\n"
+      "  -l                use physical lengths as initial metric (default: travel times)\n"
+      "  -t <num>          answer queries with <num> worker threads (default: number of cores)\n"
+      "  -c <num>          keep up to <num> connections open; clients connecting beyond that are\n"
+      "                      turned away with 'ERROR too many connections' (default: 1024)\n"
+      "  -mmap             memory-map the input graph instead of reading it through a stream\n"
+      "  -help             display this help and exit\n"
+      "\n"
+      "The protocol is line-oriented. Vertices are identified by their IDs in the input graph.\n"
+      "  QUERY <s> <t>     reply with the distance from s to t, or INF if t is unreachable\n"
+      "  BATCH <n>         followed by <n> lines '<s> <t>'; reply with <n> distances, one per line,\n"
+      "                      which are answered by all workers in parallel and sent in chunks\n"
+      "  CUSTOMIZE <file>  swap in the metric in <file> without interrupting other connections,\n"
+      "                      where <file> is a binary weight vector if it ends in .bin and a CSV\n"
+      "                      file with a column 'weight' otherwise; reply with OK <time in ms>\n"
+      "  QUIT              close the connection\n"
+      "  SHUTDOWN          stop the daemon; requests already received on open connections are\n"
+      "                      still answered, then all connections are closed\n"
+      "Malformed requests are answered with a line starting with ERROR. On shutdown, clients whose\n"
+      "connections are closed, or whose batches are cut short, receive 'ERROR shutting down'.\n";
+}
+
+using VertexAttributes = VertexAttrs<LatLngAttribute>;
+using EdgeAttributes = EdgeAttrs<LengthAttribute, TravelTimeAttribute>;
+using GraphT = StaticGraph<VertexAttributes, EdgeAttributes>;
+
+// The metric-independent part of the index, which is built once and shared by all customizations.
+struct StaticIndex {
+  GraphT graph;                                    // The input graph.
+  CCH cch;                                         // The CCH of the input graph.
+  BalancedTopologyCentricTreeHierarchy hierarchy;  // The tree hierarchy, only built for CTL.
+};
+
+// A CTL customized with a particular metric. It is immutable after construction, so any number of
+// query instances may run on it concurrently.
+class CTLCustomization {
+ public:
+  using LabelSet = std::conditional_t<CTL_SIMD_LOGK == 0,
+      BasicLabelSet<0, ParentInfo::NO_PARENT_INFO>,
+      SimdLabelSet<CTL_SIMD_LOGK, ParentInfo::NO_PARENT_INFO>>;
+  using Labelling = TruncatedTreeLabelling<LabelSet::K, LabelSet::KEEP_PARENT_EDGES>;
+  using Metric = CTLMetric<Labelling, LabelSet, CTL_USE_PERFECT_CUSTOMIZATION>;
+  using Query = CTLQuery<Metric::SearchGraph, Labelling, LabelSet>;
+
+  // Customizes a CTL with the specified edge weights.
+  CTLCustomization(const StaticIndex& index, std::vector<int32_t> edgeWeights)
+      : index(index), weights(std::move(edgeWeights)), ctl(index.hierarchy),
+        metric(index.hierarchy, index.cch, weights.data()) {
+    ctl.init();
+    metric.buildCustomizedCTL(ctl);
+  }
+
+  // Returns a new query instance running on this customization.
+  std::unique_ptr<Query> newQuery() const {
+    return std::make_unique<Query>(
+        index.hierarchy, metric.upwardGraph(), metric.downwardGraph(),
+        metric.upwardWeights(), metric.downwardWeights(), ctl);
+  }
+
+  // Returns the distance between the specified vertices in the input graph.
+  int32_t computeDistance(Query& query, const int s, const int t) const {
+    const auto& ranks = index.cch.getRanks();
+    query.run(ranks[s], ranks[t]);
+    return query.getDistance();
+  }
+
+ private:
+  const StaticIndex& index;      // The metric-independent part of the index.
+  std::vector<int32_t> weights;  // The weights of the input edges.
+  Labelling ctl;                 // The customized labelling.
+  Metric metric;                 // The customized search graphs.
+};
+
+// A CCH customized with a particular metric, answering queries by elimination tree searches. It is
+// immutable after construction, so any number of query instances may run on it concurrently.
+class CCHCustomization {
+ public:
+  using Query = EliminationTreeQuery<BasicLabelSet<0, ParentInfo::NO_PARENT_INFO>>;
+
+  // Customizes a CCH with the specified edge weights.
+  CCHCustomization(const StaticIndex& index, const std::vector<int32_t>& edgeWeights)
+      : index(index),
+        minimumWeightedCH(CCHMetric(index.cch, edgeWeights.data()).buildMinimumWeightedCH()) {}
+
+  // Returns a new query instance running on this customization.
+  std::unique_ptr<Query> newQuery() const {
+    return std::make_unique<Query>(minimumWeightedCH, index.cch.getEliminationTree());
+  }
+
+  // Returns the distance between the specified vertices in the input graph.
+  int32_t computeDistance(Query& query, const int s, const int t) const {
+    query.run(minimumWeightedCH.rank(s), minimumWeightedCH.rank(t));
+    return query.getDistance();
+  }
+
+ private:
+  const StaticIndex& index;  // The metric-independent part of the index.
+  CH minimumWeightedCH;      // The CH obtained by perfect customization.
+};
+
+// Reads a weight for each edge of the input graph from the specified file. The file is either a
+// binary file containing a single vector, or a CSV file with a column 'weight'.
+inline std::vector<int32_t> readWeights(const std::string& fileName, const int numEdges) {
+  std::vector<int32_t> weights;
+  if (endsWith(fileName, ".bin")) {
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in.good())
+      throw std::invalid_argument("file not found -- '" + fileName + "'");
+    bio::read(in, weights);
+    if (!in.good())
+      throw std::invalid_argument("invalid weight file -- '" + fileName + "'");
+  } else {
+    int32_t weight;
+    using TrimPolicy = io::trim_chars<>;
+    using QuotePolicy = io::no_quote_escape<','>;
+    using OverflowPolicy = io::throw_on_overflow;
+    using CommentPolicy = io::single_line_comment<'#'>;
+    io::CSVReader<1, TrimPolicy, QuotePolicy, OverflowPolicy, CommentPolicy> in(fileName);
+    in.read_header(io::ignore_extra_column, "weight");
+    while (in.read_row(weight))
+      weights.push_back(weight);
+  }
+  if (weights.size() != numEdges)
+    throw std::invalid_argument(
+        "weight file has " + std::to_string(weights.size()) + " weights but graph has " +
+        std::to_string(numEdges) + " edges -- '" + fileName + "'");
+  for (const auto weight : weights)
+    if (weight < 0 || weight >= INFTY)
+      throw std::invalid_argument("invalid weight " + std::to_string(weight) + " -- '" + fileName + "'");
+  return weights;
+}
+
+// A connection to a client, from which requests are read line by line.
+class Connection {
+ public:
+  // Lines longer than this number of bytes are considered a protocol error.
+  static constexpr int MAX_LINE_LENGTH = 1 << 16;
+
+  // Constructs a connection on the specified socket.
+  explicit Connection(const int fd) : fd(fd) {}
+
+  // Reads the next line, without its trailing newline. Returns false if the client closed the
+  // connection or sent a line that is too long.
+  bool readLine(std::string& line) {
+    auto newline = buffer.find('\n', pos);
+    while (newline == std::string::npos) {
+      if (buffer.size() - pos > MAX_LINE_LENGTH)
+        return false;
+      buffer.erase(0, pos);
+      pos = 0;
+      char chunk[4096];
+      const auto bytesRead = recv(fd, chunk, sizeof(chunk), 0);
+      if (bytesRead == -1 && errno == EINTR)
+        continue;
+      if (bytesRead <= 0)
+        return false;
+      buffer.append(chunk, bytesRead);
+      newline = buffer.find('\n');
+    }
+    line.assign(buffer, pos, newline - pos);
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    pos = newline + 1;
+    return true;
+  }
+
+  // Writes the specified data. Returns false if the client closed the connection.
+  bool write(const std::string& data) {
+    for (std::size_t written = 0; written < data.size();) {
+      const auto bytesSent = send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+      if (bytesSent == -1 && errno == EINTR)
+        continue;
+      if (bytesSent <= 0)
+        return false;
+      written += bytesSent;
+    }
+    return true;
+  }
+
+ private:
+  int fd;                // The socket of the connection.
+  std::string buffer;    // The bytes received but not yet consumed.
+  std::size_t pos = 0;   // The position of the first unconsumed byte in the buffer.
+};
+
+// Skips leading blanks in [first, last) and parses an integer. Returns false on failure.
+inline bool parseInt(const char*& first, const char* const last, int& value) {
+  while (first != last && (*first == ' ' || *first == '\t'))
+    ++first;
+  const auto result = std::from_chars(first, last, value);
+  if (result.ec != std::errc())
+    return false;
+  first = result.ptr;
+  return true;
+}
+
+// Serves distance queries on an index over a Unix domain socket. Each connection is read by its own
+// thread, which hands the queries it receives to a fixed pool of worker threads, each owning a
+// query instance. Hence idle connections do not tie up workers, and the queries of a batch are split
+// into tasks that are answered by all workers in parallel. The customization is double-buffered:
+// CUSTOMIZE builds a new customization while the current one keeps answering queries, and swaps it
+// in once it is complete. Each request runs on the customization that is current when it arrives,
+// and the old one is freed as soon as no request or worker uses it anymore.
+template <typename CustomizationT>
+class QueryServer {
+  using Query = typename CustomizationT::Query;
+
+  // The number of queries in a batch that are read, answered and replied to at a time.
+  static constexpr int BATCH_CHUNK_SIZE = 4096;
+
+  // The number of queries in a batch that are answered by a single task.
+  static constexpr int TASK_SIZE = 256;
+
+  // The reply to clients whose requests are cut short by a shutdown.
+  static constexpr const char* SHUTDOWN_REPLY = "ERROR shutting down\n";
+
+  // The reply to clients that connect while the maximum number of connections is open.
+  static constexpr const char* BUSY_REPLY = "ERROR too many connections\n";
+
+  // The tasks into which a request is split, and the number of those not yet answered.
+  struct TaskGroup {
+    int numPendingTasks = 0;            // The number of tasks not yet answered.
+    std::condition_variable tasksDone;  // Signals that all tasks have been answered.
+  };
+
+  // A range of queries that is answered by a single worker.
+  struct Task {
+    std::shared_ptr<const CustomizationT> customization;  // The customization to run the queries on.
+    const std::string* firstQuery;                        // The first query in the range.
+    const std::string* lastQuery;                         // One past the last query in the range.
+    TaskGroup* group;                                     // The group this task belongs to.
+    std::string reply;                                    // The replies to the queries.
+  };
+
+ public:
+  // Constructs a server answering queries with the specified initial edge weights.
+  QueryServer(const StaticIndex& index, std::vector<int32_t> weights)
+      : index(index), current(std::make_shared<const CustomizationT>(index, std::move(weights))) {}
+
+  // Listens on the specified socket and answers queries with the specified number of workers, until
+  // a client sends SHUTDOWN. Clients connecting while the specified maximum number of connections
+  // is open are turned away.
+  void run(const std::string& socketPath, const int numWorkers, const int maxConnections) {
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path))
+      throw std::invalid_argument("socket path too long -- '" + socketPath + "'");
+    std::strcpy(addr.sun_path, socketPath.c_str());
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd == -1)
+      throw std::system_error(errno, std::generic_category(), "socket");
+    unlink(socketPath.c_str());
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1 ||
+        listen(listenFd, SOMAXCONN) == -1) {
+      const auto error = errno;
+      close(listenFd);
+      throw std::system_error(error, std::generic_category(), "cannot listen on '" + socketPath + "'");
+    }
+
+    std::vector<std::thread> workers;
+    for (auto i = 0; i < numWorkers; ++i)
+      workers.emplace_back(&QueryServer::answerTasks, this);
+
+    auto acceptError = 0;
+    while (true) {
+      const auto fd = accept(listenFd, nullptr, nullptr);
+      if (fd == -1) {
+        if (errno == EINTR || errno == ECONNABORTED)
+          continue;
+        // SHUTDOWN makes accept fail by shutting down the listening socket.
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!shuttingDown)
+          acceptError = errno;
+        break;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (activeConnections.size() < maxConnections) {
+          activeConnections.push_back(fd);
+          std::thread(&QueryServer::serveConnection, this, fd).detach();
+          continue;
+        }
+      }
+      Connection(fd).write(BUSY_REPLY);
+      close(fd);
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      shuttingDown = true;
+      for (const auto fd : activeConnections)
+        shutdown(fd, SHUT_RD);
+      // Workers keep answering tasks until all connections are closed.
+      connectionClosed.wait(lock, [&] { return activeConnections.empty(); });
+      stoppingWorkers = true;
+    }
+    taskPending.notify_all();
+    for (auto& worker : workers)
+      worker.join();
+    close(listenFd);
+    unlink(socketPath.c_str());
+    if (acceptError != 0)
+      throw std::system_error(acceptError, std::generic_category(), "accept");
+  }
+
+ private:
+  // Takes pending tasks one after another and answers their queries.
+  void answerTasks() {
+    std::shared_ptr<const CustomizationT> customization;
+    std::unique_ptr<Query> query;
+    while (true) {
+      Task* task;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        taskPending.wait(lock, [&] { return stoppingWorkers || !pendingTasks.empty(); });
+        if (pendingTasks.empty())
+          return;
+        task = pendingTasks.front();
+        pendingTasks.pop_front();
+      }
+
+      if (task->customization != customization) {
+        query.reset();
+        customization = task->customization;
+        query = customization->newQuery();
+      }
+      for (auto q = task->firstQuery; q != task->lastQuery; ++q)
+        answerQuery(q->data(), q->data() + q->size(), *customization, *query, task->reply);
+
+      bool outdated;
+      {
+        // The task must not be accessed once the group is done, as it is freed by its connection.
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--task->group->numPendingTasks == 0)
+          task->group->tasksDone.notify_one();
+        outdated = pendingTasks.empty() && customization != current;
+      }
+      // Do not keep an outdated customization alive while waiting for the next task.
+      if (outdated) {
+        query.reset();
+        customization.reset();
+      }
+    }
+  }
+
+  // Serves the requests on the specified connection until the client closes it or the server shuts
+  // down. In the latter case, the client is told so.
+  void serveConnection(const int fd) {
+    Connection conn(fd);
+    if (!serveRequests(conn) && isShuttingDown())
+      conn.write(SHUTDOWN_REPLY);
+    {
+      // The server must not be accessed once the last connection is closed, as it may be gone.
+      std::lock_guard<std::mutex> lock(mutex);
+      activeConnections.erase(std::find(activeConnections.begin(), activeConnections.end(), fd));
+      connectionClosed.notify_one();
+    }
+    close(fd);
+  }
+
+  // Serves the requests on the specified connection until it is closed. Returns false if reading
+  // a request failed, and true if the client sent QUIT or SHUTDOWN or cannot be written to.
+  bool serveRequests(Connection& conn) {
+    std::string line;
+    std::string reply;
+    std::vector<std::string> queries;
+    while (true) {
+      if (!conn.readLine(line))
+        return false;
+      const char* const first = line.data();
+      const char* const last = line.data() + line.size();
+      const auto commandEnd = std::find(first, last, ' ');
+      const std::string command(first, commandEnd);
+      const char* args = commandEnd;
+      reply.clear();
+
+      if (command == "QUERY") {
+        queries.assign(1, std::string(args, last));
+        answerQueries(currentCustomization(), queries, reply);
+      } else if (command == "BATCH") {
+        int numQueries;
+        if (!parseInt(args, last, numQueries) || numQueries < 0) {
+          reply = "ERROR invalid batch size\n";
+        } else {
+          // All queries of a batch are answered on the same customization.
+          const auto customization = currentCustomization();
+          for (auto i = 0; i < numQueries; i += BATCH_CHUNK_SIZE) {
+            queries.resize(std::min(BATCH_CHUNK_SIZE, numQueries - i));
+            for (auto j = 0; j < queries.size(); ++j) {
+              if (!conn.readLine(queries[j])) {
+                // Send the replies to the queries read so far.
+                queries.resize(j);
+                answerQueries(customization, queries, reply);
+                conn.write(reply);
+                return false;
+              }
+            }
+            answerQueries(customization, queries, reply);
+            if (!conn.write(reply))
+              return true;
+            reply.clear();
+          }
+        }
+      } else if (command == "CUSTOMIZE") {
+        while (args != last && *args == ' ')
+          ++args;
+        customize(std::string(args, last), reply);
+      } else if (command == "QUIT") {
+        return true;
+      } else if (command == "SHUTDOWN") {
+        requestShutdown();
+        conn.write("OK\n");
+        return true;
+      } else if (command.empty()) {
+        continue;
+      } else {
+        reply = "ERROR unknown command '" + command + "'\n";
+      }
+
+      if (!conn.write(reply))
+        return true;
+    }
+  }
+
+  // Splits the specified queries into tasks, hands them to the workers, and appends the replies in
+  // the order of the queries once all tasks have been answered.
+  void answerQueries(
+      const std::shared_ptr<const CustomizationT>& customization,
+      const std::vector<std::string>& queries, std::string& reply) {
+    if (queries.empty())
+      return;
+    TaskGroup group;
+    std::vector<Task> tasks;
+    for (auto i = 0; i < queries.size(); i += TASK_SIZE) {
+      const auto end = std::min<std::size_t>(i + TASK_SIZE, queries.size());
+      tasks.push_back({customization, queries.data() + i, queries.data() + end, &group, {}});
+    }
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      group.numPendingTasks = tasks.size();
+      for (auto& task : tasks)
+        pendingTasks.push_back(&task);
+      if (tasks.size() == 1)
+        taskPending.notify_one();
+      else
+        taskPending.notify_all();
+      group.tasksDone.wait(lock, [&] { return group.numPendingTasks == 0; });
+    }
+    for (const auto& task : tasks)
+      reply += task.reply;
+  }
+
+  // Answers the query '<s> <t>' in [first, last) and appends the reply.
+  void answerQuery(
+      const char* first, const char* const last, const CustomizationT& customization, Query& query,
+      std::string& reply) const {
+    const auto numVertices = index.graph.numVertices();
+    int s, t;
+    if (!parseInt(first, last, s) || !parseInt(first, last, t)) {
+      reply += "ERROR expected two vertex IDs\n";
+      return;
+    }
+    if (s < 0 || s >= numVertices || t < 0 || t >= numVertices) {
+      reply += "ERROR vertex ID out of range\n";
+      return;
+    }
+    const auto dist = customization.computeDistance(query, s, t);
+    if (dist >= INFTY) {
+      reply += "INF\n";
+    } else {
+      reply += std::to_string(dist);
+      reply += '\n';
+    }
+  }
+
+  // Returns the customization new requests run on.
+  std::shared_ptr<const CustomizationT> currentCustomization() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return current;
+  }
+
+  // Builds a customization with the weights in the specified file and swaps it in.
+  void customize(const std::string& weightFileName, std::string& reply) {
+    // Customizations are built one at a time, so at most two are alive apart from those that
+    // requests are still running on.
+    std::lock_guard<std::mutex> customizationLock(customizationMutex);
+    Timer timer;
+    std::shared_ptr<const CustomizationT> next;
+    try {
+      next = std::make_shared<const CustomizationT>(
+          index, readWeights(weightFileName, index.graph.numEdges()));
+    } catch (std::exception& e) {
+      reply = std::string("ERROR ") + e.what() + '\n';
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      std::swap(current, next);
+    }
+    // The old customization is freed here, outside the lock, unless a worker still uses it.
+    next.reset();
+    reply = "OK " + std::to_string(timer.elapsed()) + '\n';
+  }
+
+  // Returns true if the server is shutting down.
+  bool isShuttingDown() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return shuttingDown;
+  }
+
+  // Stops accepting connections and closes open connections once the requests already received
+  // on them have been answered.
+  void requestShutdown() {
+    std::lock_guard<std::mutex> lock(mutex);
+    shuttingDown = true;
+    for (const auto fd : activeConnections)
+      shutdown(fd, SHUT_RD);
+    shutdown(listenFd, SHUT_RDWR);
+  }
+
+  const StaticIndex& index;                        // The metric-independent part of the index.
+  std::shared_ptr<const CustomizationT> current;   // The customization new requests run on.
+
+  int listenFd = -1;                         // The socket on which the server listens.
+  std::mutex mutex;                          // Protects the members below and current.
+  std::condition_variable taskPending;       // Signals a pending task or that workers must stop.
+  std::condition_variable connectionClosed;  // Signals that a connection has been closed.
+  std::deque<Task*> pendingTasks;            // The tasks not yet taken by a worker.
+  std::vector<int> activeConnections;        // The connections being served.
+  bool shuttingDown = false;                 // Indicates whether the server is shutting down.
+  bool stoppingWorkers = false;              // Indicates whether the workers must stop.
+  std::mutex customizationMutex;             // Serializes customizations.
+};
+
+// Builds the index for the specified algorithm and serves queries until shut down.
+template <typename CustomizationT>
+inline void serve(const StaticIndex& index, std::vector<int32_t> weights,
+                  const std::string& socketPath, const int numWorkers, const int maxConnections) {
+  std::cout << "Running the customization..." << std::flush;
+  Timer timer;
+  QueryServer<CustomizationT> server(index, std::move(weights));
+  std::cout << " done (" << timer.elapsed() << " ms)." << std::endl;
+  std::cout << "Listening on " << socketPath << " with " << numWorkers << " workers." << std::endl;
+  server.run(socketPath, numWorkers, maxConnections);
+  std::cout << "Shut down." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  try {
+    CommandLineParser clp(argc, argv);
+    if (clp.isSet("help")) {
+      printUsage();
+      return EXIT_SUCCESS;
+    }
+
+    const auto algorithmName = clp.getValue<std::string>("a", "CTL");
+    const auto graphFileName = clp.getValue<std::string>("g");
+    const auto sepFileName = clp.getValue<std::string>("s");
+    const auto socketPath = clp.getValue<std::string>("socket");
+    const auto useLengths = clp.isSet("l");
+    const auto useMmap = clp.isSet("mmap");
+    const auto numWorkers =
+        clp.getValue<int>("t", std::max(1, static_cast<int>(std::thread::hardware_concurrency())));
+    const auto maxConnections = clp.getValue<int>("c", 1024);
+    if (algorithmName != "CTL" && algorithmName != "CCH")
+      throw std::invalid_argument("invalid algorithm -- '" + algorithmName + "'");
+    if (socketPath.empty())
+      throw std::invalid_argument("no socket specified");
+    if (numWorkers < 1)
+      throw std::invalid_argument("invalid number of threads -- '" + std::to_string(numWorkers) + "'");
+    if (maxConnections < 1)
+      throw std::invalid_argument(
+          "invalid number of connections -- '" + std::to_string(maxConnections) + "'");
+
+    std::cout << "Reading the input..." << std::flush;
+    StaticIndex index;
+    if (useMmap) {
+      MemoryMappedFile graphFile(graphFileName);
+      index.graph.readFrom(graphFile);
+    } else {
+      std::ifstream graphFile(graphFileName, std::ios::binary);
+      if (!graphFile.good())
+        throw std::invalid_argument("file not found -- '" + graphFileName + "'");
+      index.graph.readFrom(graphFile);
+    }
+    std::ifstream sepFile(sepFileName, std::ios::binary);
+    if (!sepFile.good())
+      throw std::invalid_argument("file not found -- '" + sepFileName + "'");
+    SeparatorDecomposition sepDecomp;
+    sepDecomp.readFrom(sepFile);
+    sepFile.close();
+    std::cout << " done." << std::endl;
+
+    std::cout << "Running the metric-independent preprocessing..." << std::flush;
+    index.cch.preprocess(index.graph, sepDecomp);
+    if (algorithmName == "CTL")
+      index.hierarchy.preprocess(index.graph, sepDecomp);
+    std::cout << " done." << std::endl;
+
+    const auto& graph = index.graph;
+    std::vector<int32_t> weights(graph.numEdges());
+    FORALL_EDGES(graph, e)
+      weights[e] = useLengths ? graph.length(e) : graph.travelTime(e);
+
+    if (algorithmName == "CTL")
+      serve<CTLCustomization>(index, std::move(weights), socketPath, numWorkers, maxConnections);
+    else
+      serve<CCHCustomization>(
+          index, std::move(weights), socketPath, numWorkers, maxConnections);
+  } catch (std::invalid_argument& e) {
+    std::cerr << argv[0] << ": " << e.what() << std::endl;
+    std::cerr << "Try '" << argv[0] << " -help' for more information." << std::endl;
+    return EXIT_FAILURE;
+  } catch (std::system_error& e) {
+    std::cerr << argv[0] << ": " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -3,6 +3,7 @@
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -16,9 +17,11 @@
 #include "Algorithms/CTL/CTLQuery.h"
 #include "Algorithms/CCH/CCH.h"
 #include "Algorithms/CCH/CCHMetric.h"
+#include "Algorithms/CCH/CCHPathUnpacker.h"
 #include "Algorithms/CCH/EliminationTreeQuery.h"
 #include "Algorithms/CTNR/CTNR.h"
 #include "Algorithms/CH/CH.h"
+#include "Algorithms/CH/CHPathUnpacker.h"
 #include "Algorithms/CH/CHQuery.h"
 #include "Algorithms/Dijkstra/BiDijkstra.h"
 #include "Algorithms/Dijkstra/Dijkstra.h"
@@ -28,9 +31,15 @@
 #include "DataStructures/Graph/Graph.h"
 #include "DataStructures/Labels/BasicLabelSet.h"
 #include "DataStructures/Labels/ParentInfo.h"
+#include "DataStructures/Partitioning/InertialFlowSeparator.h"
 #include "DataStructures/Partitioning/SeparatorDecomposition.h"
 #include "DataStructures/Partitioning/nested_strict_dissection.h"
+#include "DataStructures/Utilities/OriginDestination.h"
+#include "Tools/ArenaAllocator.h"
 #include "Tools/CommandLine/CommandLineParser.h"
+#include "Tools/EnumParser.h"
+#include "Tools/MemoryMappedFile.h"
+#include "Tools/PerfCounters.h"
 #include "Tools/StringHelpers.h"
 #include "Tools/Timer.h"
 #include <ctlsa/road_network.h>
@@ -52,7 +61,7 @@ inline void printUsage() {
               "       RunP2PAlgo -a CH         -o <file> -h <file> -d <file>\n"
               "       RunP2PAlgo -a CCH-Dij    -o <file> -g <file> -d <file> -s <file>\n"
               "       RunP2PAlgo -a CCH-tree   -o <file> -g <file> -d <file> -s <file>\n"
-              "       RunP2PAlgo -a CTL        -o <file> -g <file> -d <file> -s <file>\n"
+              "       RunP2PAlgo -a CTL        -o <file> -g <file> -d <file> -s <file> [-cache <MB>] [-paths]\n"
               "       RunP2PAlgo -a CTNR       -o <file> -g <file> -d <file> -s <file>\n\n"
 
               "Runs the preprocessing, customization or query phase of various point-to-point\n"
@@ -60,13 +69,21 @@ inline void printUsage() {
 
               "  -l                use physical lengths as metric (default: travel times)\n"
               "  -no-stall         do not use the stall-on-demand technique\n"
+              "  -mmap             memory-map the input graph instead of reading it through a stream\n"
               "  -a <algo>         run algorithm <algo>\n"
-              "  -b <balance>      balance parameter in % for nested dissection (default: 30)\n"
+              "  -b <balances>     space-separated balance parameters in % for nested dissection\n"
+              "                      (default: 30); each is tried and the best cut is kept\n"
+              "  -rot <num>        try <num> rotations of the inertial-flow directions (default: 1)\n"
               "  -n <num>          run customization <num> times (default: 1000)\n"
+              "  -cache <MB>       cache labels of truncated vertices in <MB> MB of memory (default: 0)\n"
+              "  -paths            retrieve the path in the input graph for each CTL query\n"
+              "  -pages <kind>     kind of pages backing the CCH weights and CTL labels\n"
+              "                      possible values: default thp 2mb 1gb\n"
+              "  -interleave       interleave the CCH weights and CTL labels across NUMA nodes\n"
               "  -g <file>         input graph in binary format\n"
               "  -s <file>         separator decomposition of input graph\n"
               "  -h <file>         weighted contraction hierarchy\n"
-              "  -d <file>         file that contains OD pairs (queries)\n"
+              "  -d <file>         OD pairs (queries), binary OD file if <file> ends in .bin\n"
               "  -o <file>         place output in <file>\n"
               "  -help             display this help and exit\n";
 }
@@ -106,40 +123,191 @@ inline void writeRecordLine(std::ofstream &out, Dij &algo, const int dst, const
     out << algo.getDistance(dst) << ',' << elapsed << '\n';
 }
 
+// Reads the input graph from the specified binary file, optionally through a memory mapping.
+inline InputGraph readGraph(const std::string &graphFileName, const bool useMmap) {
+    InputGraph graph;
+    if (useMmap) {
+        MemoryMappedFile graphFile(graphFileName);
+        graph.readFrom(graphFile);
+    } else {
+        std::ifstream graphFile(graphFileName, std::ios::binary);
+        if (!graphFile.good())
+            throw std::invalid_argument("file not found -- '" + graphFileName + "'");
+        graph.readFrom(graphFile);
+    }
+    return graph;
+}
+
+// Writes the hardware events counted during the specified phase to the output file, in total and, if
+// the phase consists of several repetitions (e.g., queries), per repetition.
+inline void writePerfCounts(std::ofstream &out, const std::string &phase, const PerfCounts &counts,
+                            const int numReps = 1, const std::string &rep = "") {
+    if constexpr (PERF_COUNTERS_ENABLED) {
+        out << "# Perf " << phase << ": ";
+        counts.print(out);
+        out << '\n';
+        if (numReps > 1) {
+            out << "# Perf " << phase << " per " << rep << ": ";
+            counts.print(out, numReps);
+            out << '\n';
+        }
+    }
+}
+
 // Runs the specified P2P algorithm on the given OD pairs.
 template<typename AlgoT, typename T>
-inline void runQueries(AlgoT &algo, const std::string &demand, std::ofstream &out, T translate) {
-    Timer timer;
-    int src, dst, rank;
-    using TrimPolicy = io::trim_chars<>;
-    using QuotePolicy = io::no_quote_escape<','>;
-    using OverflowPolicy = io::throw_on_overflow;
-    using CommentPolicy = io::single_line_comment<'#'>;
-    io::CSVReader<3, TrimPolicy, QuotePolicy, OverflowPolicy, CommentPolicy> demandFile(demand);
-    const auto ignore = io::ignore_extra_column | io::ignore_missing_column;
-    demandFile.read_header(ignore, "origin", "destination", "dijkstra_rank");
-    const auto hasRanks = demandFile.has_column("dijkstra_rank");
+inline void runQueries(AlgoT &algo, const std::string &demand, const int numVertices, std::ofstream &out,
+                       T translate) {
+    // Load all queries before the first one is timed, so that reading the OD file does not
+    // interfere with the measurements.
+    const auto queries = importODPairColumnsFrom(demand, numVertices);
+    const auto rankCol = queries.findColumn("dijkstra_rank");
+    const auto hasRanks = rankCol != -1;
     if (hasRanks) out << "dijkstra_rank,";
     writeHeaderLine(out, algo);
-    while (demandFile.read_row(src, dst, rank)) {
-        src = translate(src);
-        dst = translate(dst);
+    Timer timer;
+    PerfMeter perfMeter(PerfScope::THREAD);
+    PerfCounts queryPerf;
+    for (auto i = 0; i < queries.numPairs(); ++i) {
+        const auto src = translate(queries.origins()[i]);
+        const auto dst = translate(queries.destinations()[i]);
+        perfMeter.restart();
         timer.restart();
         algo.run(src, dst);
         const auto elapsed = timer.elapsed<std::chrono::nanoseconds>();
-        if (hasRanks) out << rank << ',';
+        queryPerf += perfMeter.elapsed();
+        if (hasRanks) out << queries.column(rankCol)[i] << ',';
         writeRecordLine(out, algo, dst, elapsed);
         if constexpr (std::is_same_v<AlgoT, CTNRQuery<InputGraph>>) {
             out.seekp(-1, std::ios_base::cur); // overwrite newline
             out << ',' << algo.getLastMode() << '\n';
         }
     }
+    writePerfCounts(out, "queries", queryPerf, queries.numPairs(), "query");
+}
+
+// Runs the specified P2P algorithm on the given OD pairs and unpacks the path in the input graph for each query.
+// The time to compute the distance and the additional time to retrieve the path are reported separately.
+template<typename AlgoT, typename UnpackerT, typename T>
+inline void runPathQueries(AlgoT &algo, UnpackerT &unpacker, const std::string &demand, const int numVertices,
+                           std::ofstream &out, T translate) {
+    const auto queries = importODPairColumnsFrom(demand, numVertices);
+    const auto rankCol = queries.findColumn("dijkstra_rank");
+    const auto hasRanks = rankCol != -1;
+    if (hasRanks) out << "dijkstra_rank,";
+    out << "distance,query_time,path_time,path_length" << '\n';
+    std::vector<int32_t> path;
+    Timer timer;
+    PerfMeter perfMeter(PerfScope::THREAD);
+    PerfCounts queryPerf;
+    PerfCounts pathPerf;
+    for (auto i = 0; i < queries.numPairs(); ++i) {
+        const auto src = translate(queries.origins()[i]);
+        const auto dst = translate(queries.destinations()[i]);
+        perfMeter.restart();
+        timer.restart();
+        algo.run(src, dst);
+        const auto queryTime = timer.elapsed<std::chrono::nanoseconds>();
+        queryPerf += perfMeter.elapsed();
+        perfMeter.restart();
+        timer.restart();
+        path.clear();
+        if (algo.getDistance() != INFTY)
+            unpacker.unpackUpDownPath(algo.getUpEdgePath(), algo.getDownEdgePath(), path);
+        const auto pathTime = timer.elapsed<std::chrono::nanoseconds>();
+        pathPerf += perfMeter.elapsed();
+        if (hasRanks) out << queries.column(rankCol)[i] << ',';
+        out << algo.getDistance() << ',' << queryTime << ',' << pathTime << ',' << path.size() << '\n';
+    }
+    writePerfCounts(out, "queries", queryPerf, queries.numPairs(), "query");
+    writePerfCounts(out, "path retrieval", pathPerf, queries.numPairs(), "query");
+}
+
+// Customizes a CTL on the specified graph and runs CTL queries on the given OD pairs. If the label set keeps parent
+// edges, the path in the input graph is retrieved for each query.
+template<ParentInfo PARENT_INFO>
+inline void runCTLQueries(const CommandLineParser &clp, std::ofstream &outputFile) {
+    const auto useLengths = clp.isSet("l");
+    const auto useMmap = clp.isSet("mmap");
+    const auto graphFileName = clp.getValue<std::string>("g");
+    const auto sepFileName = clp.getValue<std::string>("s");
+    const auto demandFileName = clp.getValue<std::string>("d");
+
+    static constexpr uint64_t BYTES_PER_MB = 1 << 20;
+
+    InputGraph graph = readGraph(graphFileName, useMmap);
+
+    std::ifstream sepFile(sepFileName, std::ios::binary);
+    if (!sepFile.good())
+        throw std::invalid_argument("file not found -- '" + sepFileName + "'");
+    SeparatorDecomposition sepDecomp;
+    sepDecomp.readFrom(sepFile);
+    sepFile.close();
+
+    CCH cch;
+    cch.preprocess(graph, sepDecomp);
+
+    BalancedTopologyCentricTreeHierarchy treeHierarchy;
+    treeHierarchy.preprocess(graph, sepDecomp);
+
+    using CTLLabelSet = std::conditional_t<CTL_SIMD_LOGK == 0,
+            BasicLabelSet<0, PARENT_INFO>,
+            SimdLabelSet<CTL_SIMD_LOGK, PARENT_INFO>>;
+    using LabellingT = TruncatedTreeLabelling<CTLLabelSet::K, CTLLabelSet::KEEP_PARENT_EDGES>;
+    using CTLMetricT = CTLMetric<LabellingT, CTLLabelSet, CTL_USE_PERFECT_CUSTOMIZATION>;
+    LabellingT ctl(treeHierarchy);
+    ctl.init();
+
+    const auto inputWeights = useLengths ? &graph.length(0) : &graph.travelTime(0);
+    CTLMetricT metric(treeHierarchy, cch, inputWeights);
+    PerfMeter perfMeter;
+    metric.buildCustomizedCTL(ctl);
+    const auto customizationPerf = perfMeter.elapsed();
+
+    outputFile << "# Graph: " << graphFileName << '\n';
+    outputFile << "# Separator: " << sepFileName << '\n';
+    outputFile << "# OD pairs: " << demandFileName << '\n';
+    writePerfCounts(outputFile, "customization", customizationPerf);
+
+    const auto labelCacheBudget = clp.getValue<int>("cache", 0);
+    if (labelCacheBudget < 0)
+        throw std::invalid_argument("invalid label cache size -- '" + std::to_string(labelCacheBudget) + "'");
+    CTLQuery<typename CTLMetricT::SearchGraph, LabellingT, CTLLabelSet> algo(treeHierarchy, metric.upwardGraph(),
+                                                                             metric.downwardGraph(),
+                                                                             metric.upwardWeights(),
+                                                                             metric.downwardWeights(), ctl,
+                                                                             labelCacheBudget * BYTES_PER_MB);
+
+    outputFile << "# Memory usage CCH: " << (cch.sizeInBytes()) / BYTES_PER_MB << " MB" << '\n';
+    outputFile << "# Memory usage TreeHierarchy: " << (treeHierarchy.sizeInBytes()) / BYTES_PER_MB << " MB" << '\n';
+    outputFile << "# Memory usage Labelling: " << (ctl.sizeInBytes()) / BYTES_PER_MB << " MB" << '\n';
+    outputFile << "# Memory usage CTLMetric: " << (metric.sizeInBytes()) / BYTES_PER_MB << " MB" << '\n';
+    outputFile << "# Memory usage CTLQuery: " << (algo.sizeInBytes()) / BYTES_PER_MB << " MB" << '\n';
+    outputFile << "# Memory usage total: " <<
+               (cch.sizeInBytes() + treeHierarchy.sizeInBytes() + ctl.sizeInBytes() + metric.sizeInBytes() +
+                algo.sizeInBytes()) / BYTES_PER_MB << " MB" << '\n';
+    const auto translate = [&](const int v) { return cch.getRanks()[v]; };
+    if constexpr (!CTLLabelSet::KEEP_PARENT_EDGES) {
+        runQueries(algo, demandFileName, graph.numVertices(), outputFile, translate);
+    } else if constexpr (CTL_USE_PERFECT_CUSTOMIZATION) {
+        // The search graphs are the upward and downward graph of a CH, which stores unpacking information.
+        CHPathUnpacker unpacker(metric.getMinimumWeightedCH());
+        runPathQueries(algo, unpacker, demandFileName, graph.numVertices(), outputFile, translate);
+    } else {
+        // The search graphs are the CCH itself, whose shortcuts are unpacked via their lower triangles.
+        CCHPathUnpacker unpacker(cch, metric.upwardWeights(), metric.downwardWeights(), inputWeights);
+        runPathQueries(algo, unpacker, demandFileName, graph.numVertices(), outputFile, translate);
+    }
+    outputFile << "# Memory usage CTLQuery after queries: " << (algo.sizeInBytes()) / BYTES_PER_MB << " MB" << '\n';
+    outputFile << "# Label cache hits: " << algo.getNumLabelCacheHits() << '\n';
+    outputFile << "# Label cache misses: " << algo.getNumLabelCacheMisses() << '\n';
 }
 
 // Invoked when the user wants to run the query phase of a P2P algorithm.
 inline void runQueries(const CommandLineParser &clp) {
     const auto useLengths = clp.isSet("l");
     const auto noStalling = clp.isSet("no-stall");
+    const auto useMmap = clp.isSet("mmap");
     const auto algorithmName = clp.getValue<std::string>("a");
     const auto graphFileName = clp.getValue<std::string>("g");
     const auto sepFileName = clp.getValue<std::string>("s");
@@ -159,11 +327,7 @@ inline void runQueries(const CommandLineParser &clp) {
     if (algorithmName == "Dij") {
 
         // Run the query phase of Dijkstra's algorithm.
-        std::ifstream graphFile(graphFileName, std::ios::binary);
-        if (!graphFile.good())
-            throw std::invalid_argument("file not found -- '" + graphFileName + "'");
-        InputGraph graph(graphFile);
-        graphFile.close();
+        InputGraph graph = readGraph(graphFileName, useMmap);
         if (useLengths)
             FORALL_EDGES(graph, e)graph.travelTime(e) = graph.length(e);
 
@@ -171,16 +335,12 @@ inline void runQueries(const CommandLineParser &clp) {
         outputFile << "# OD pairs: " << demandFileName << '\n';
 
         Dij algo(graph);
-        runQueries(algo, demandFileName, outputFile, [](const int v) { return v; });
+        runQueries(algo, demandFileName, graph.numVertices(), outputFile, [](const int v) { return v; });
 
     } else if (algorithmName == "Bi-Dij") {
 
         // Run the query phase of bidirectional search.
-        std::ifstream graphFile(graphFileName, std::ios::binary);
-        if (!graphFile.good())
-            throw std::invalid_argument("file not found -- '" + graphFileName + "'");
-        InputGraph graph(graphFile);
-        graphFile.close();
+        InputGraph graph = readGraph(graphFileName, useMmap);
         if (useLengths)
             FORALL_EDGES(graph, e)graph.travelTime(e) = graph.length(e);
 
@@ -189,7 +349,7 @@ inline void runQueries(const CommandLineParser &clp) {
 
         InputGraph reverseGraph = graph.getReverseGraph();
         BiDij algo(graph, reverseGraph);
-        runQueries(algo, demandFileName, outputFile, [](const int v) { return v; });
+        runQueries(algo, demandFileName, graph.numVertices(), outputFile, [](const int v) { return v; });
 
     } else if (algorithmName == "CH") {
 
@@ -199,26 +359,23 @@ inline void runQueries(const CommandLineParser &clp) {
             throw std::invalid_argument("file not found -- '" + chFileName + "'");
         CH ch(chFile);
         chFile.close();
+        const auto numVertices = ch.upwardGraph().numVertices();
 
         outputFile << "# CH: " << chFileName << '\n';
         outputFile << "# OD pairs: " << demandFileName << '\n';
 
         if (noStalling) {
             CCHDij<false> algo(ch);
-            runQueries(algo, demandFileName, outputFile, [&](const int v) { return ch.rank(v); });
+            runQueries(algo, demandFileName, numVertices, outputFile, [&](const int v) { return ch.rank(v); });
         } else {
             CCHDij<true> algo(ch);
-            runQueries(algo, demandFileName, outputFile, [&](const int v) { return ch.rank(v); });
+            runQueries(algo, demandFileName, numVertices, outputFile, [&](const int v) { return ch.rank(v); });
         }
 
     } else if (algorithmName == "CCH-Dij") {
 
         // Run the Dijkstra-based query phase of CCH.
-        std::ifstream graphFile(graphFileName, std::ios::binary);
-        if (!graphFile.good())
-            throw std::invalid_argument("file not found -- '" + graphFileName + "'");
-        InputGraph graph(graphFile);
-        graphFile.close();
+        InputGraph graph = readGraph(graphFileName, useMmap);
 
         std::ifstream sepFile(sepFileName, std::ios::binary);
         if (!sepFile.good())
@@ -238,20 +395,18 @@ inline void runQueries(const CommandLineParser &clp) {
 
         if (noStalling) {
             CCHDij<false> algo(minCH);
-            runQueries(algo, demandFileName, outputFile, [&](const int v) { return minCH.rank(v); });
+            runQueries(algo, demandFileName, graph.numVertices(), outputFile,
+                       [&](const int v) { return minCH.rank(v); });
         } else {
             CCHDij<true> algo(minCH);
-            runQueries(algo, demandFileName, outputFile, [&](const int v) { return minCH.rank(v); });
+            runQueries(algo, demandFileName, graph.numVertices(), outputFile,
+                       [&](const int v) { return minCH.rank(v); });
         }
 
     } else if (algorithmName == "CCH-tree") {
 
         // Run the elimination-tree-based query phase of CCH.
-        std::ifstream graphFile(graphFileName, std::ios::binary);
-        if (!graphFile.good())
-            throw std::invalid_argument("file not found -- '" + graphFileName + "'");
-        InputGraph graph(graphFile);
-        graphFile.close();
+        InputGraph graph = readGraph(graphFileName, useMmap);
 
         std::ifstream sepFile(sepFileName, std::ios::binary);
         if (!sepFile.good())
@@ -276,66 +431,20 @@ inline void runQueries(const CommandLineParser &clp) {
         outputFile << "# Memory usage total: "
                    << (cch.sizeInBytes() + metric.sizeInBytes() + algo.sizeInBytes()) / BYTES_PER_MB << " MB" << '\n';
 
-        runQueries(algo, demandFileName, outputFile, [&](const int v) { return minCH.rank(v); });
+        runQueries(algo, demandFileName, graph.numVertices(), outputFile, [&](const int v) { return minCH.rank(v); });
 
     } else if (algorithmName == "CTL") {
 
-        // Run truncated tree labelling (CTL) queries
-        std::ifstream graphFile(graphFileName, std::ios::binary);
-        if (!graphFile.good())
-            throw std::invalid_argument("file not found -- '" + graphFileName + "'");
-        InputGraph graph(graphFile);
-        graphFile.close();
-
-        std::ifstream sepFile(sepFileName, std::ios::binary);
-        if (!sepFile.good())
-            throw std::invalid_argument("file not found -- '" + sepFileName + "'");
-        SeparatorDecomposition sepDecomp;
-        sepDecomp.readFrom(sepFile);
-        sepFile.close();
-
-        CCH cch;
-        cch.preprocess(graph, sepDecomp);
-
-        BalancedTopologyCentricTreeHierarchy treeHierarchy;
-        treeHierarchy.preprocess(graph, sepDecomp);
-
-        using CTLLabelSet = std::conditional_t<CTL_SIMD_LOGK == 0,
-                BasicLabelSet<0, ParentInfo::NO_PARENT_INFO>,
-                SimdLabelSet<CTL_SIMD_LOGK, ParentInfo::NO_PARENT_INFO>>;
-        using LabellingT = TruncatedTreeLabelling<CTLLabelSet::K, CTLLabelSet::KEEP_PARENT_EDGES>;
-        LabellingT ctl(treeHierarchy);
-        ctl.init();
-
-        CTLMetric<LabellingT, CTLLabelSet, CTL_USE_PERFECT_CUSTOMIZATION> metric(treeHierarchy, cch, useLengths ? &graph.length(0) : &graph.travelTime(0));
-        metric.buildCustomizedCTL(ctl);
-
-        outputFile << "# Graph: " << graphFileName << '\n';
-        outputFile << "# Separator: " << sepFileName << '\n';
-        outputFile << "# OD pairs: " << demandFileName << '\n';
-
-        CTLQuery<CTLMetric<LabellingT, CTLLabelSet, CTL_USE_PERFECT_CUSTOMIZATION>::SearchGraph, LabellingT, CTLLabelSet> algo(treeHierarchy, metric.upwardGraph(),
-                                                                      metric.downwardGraph(), metric.upwardWeights(),
-                                                                      metric.downwardWeights(), ctl);
-
-        outputFile << "# Memory usage CCH: " << (cch.sizeInBytes()) / BYTES_PER_MB << " MB" << '\n';
-        outputFile << "# Memory usage TreeHierarchy: " << (treeHierarchy.sizeInBytes()) / BYTES_PER_MB << " MB" << '\n';
-        outputFile << "# Memory usage Labelling: " << (ctl.sizeInBytes()) / BYTES_PER_MB << " MB" << '\n';
-        outputFile << "# Memory usage CTLMetric: " << (metric.sizeInBytes()) / BYTES_PER_MB << " MB" << '\n';
-        outputFile << "# Memory usage CTLQuery: " << (algo.sizeInBytes()) / BYTES_PER_MB << " MB" << '\n';
-        outputFile << "# Memory usage total: " <<
-                   (cch.sizeInBytes() + treeHierarchy.sizeInBytes() + ctl.sizeInBytes() + metric.sizeInBytes() +
-                    algo.sizeInBytes()) / BYTES_PER_MB << " MB" << '\n';
-        runQueries(algo, demandFileName, outputFile, [&](const int v) { return cch.getRanks()[v]; });
+        // Run truncated tree labelling (CTL) queries, optionally retrieving the paths in the input graph.
+        if (clp.isSet("paths"))
+            runCTLQueries<ParentInfo::FULL_PARENT_INFO>(clp, outputFile);
+        else
+            runCTLQueries<ParentInfo::NO_PARENT_INFO>(clp, outputFile);
 
     } else if (algorithmName == "CTNR") {
 
         // Run customizable transit node routing (CTNR) queries
-        std::ifstream graphFile(graphFileName, std::ios::binary);
-        if (!graphFile.good())
-            throw std::invalid_argument("file not found -- '" + graphFileName + "'");
-        InputGraph graph(graphFile);
-        graphFile.close();
+        InputGraph graph = readGraph(graphFileName, useMmap);
 
         std::ifstream sepFile(sepFileName, std::ios::binary);
         if (!sepFile.good())
@@ -363,7 +472,8 @@ inline void runQueries(const CommandLineParser &clp) {
         // Use generic runQueries with CTNRQuery; pass CCH rank IDs to the algo
         const auto &metric = ctnr.getMetric();
         CTNRQuery<InputGraph> algo(metric);
-        runQueries(algo, demandFileName, outputFile, [&](const int v) { return ctnr.getCCH().getRanks()[v]; });
+        runQueries(algo, demandFileName, graph.numVertices(), outputFile,
+                   [&](const int v) { return ctnr.getCCH().getRanks()[v]; });
 
     } else {
 
@@ -373,10 +483,24 @@ inline void runQueries(const CommandLineParser &clp) {
 }
 
 
+// Parses a space-separated list of balance parameters for nested dissection.
+inline std::vector<int> parseBalances(const std::string &str) {
+    std::vector<int> balances;
+    std::istringstream iss(str);
+    int balance;
+    while (iss >> balance)
+        balances.push_back(balance);
+    if (!iss.eof() || balances.empty())
+        throw std::invalid_argument("invalid balance parameters -- '" + str + "'");
+    return balances;
+}
+
 // Invoked when the user wants to run the preprocessing or customization phase of a P2P algorithm.
 inline void runPreprocessing(const CommandLineParser &clp) {
     const auto useLengths = clp.isSet("l");
-    const auto imbalance = clp.getValue<int>("b", 30);
+    const auto useMmap = clp.isSet("mmap");
+    const auto balances = parseBalances(clp.getValue<std::string>("b", "30"));
+    const auto numRotations = clp.getValue<int>("rot", 1);
     const auto numCustomRuns = clp.getValue<int>("n", 1000);
     const auto algorithmName = clp.getValue<std::string>("a");
     const auto graphFileName = clp.getValue<std::string>("g");
@@ -384,11 +508,7 @@ inline void runPreprocessing(const CommandLineParser &clp) {
     auto outputFileName = clp.getValue<std::string>("o");
 
     // Read the input graph.
-    std::ifstream graphFile(graphFileName, std::ios::binary);
-    if (!graphFile.good())
-        throw std::invalid_argument("file not found -- '" + graphFileName + "'");
-    InputGraph graph(graphFile);
-    graphFile.close();
+    InputGraph graph = readGraph(graphFileName, useMmap);
     if (useLengths)
         FORALL_EDGES(graph, e)graph.travelTime(e) = graph.length(e);
 
@@ -417,8 +537,6 @@ inline void runPreprocessing(const CommandLineParser &clp) {
         // Run the preprocessing phase of CCH.
         std::cout << "Constructing separator decomposition for CCH for " << graphFileName << "... " << std::flush;
         Timer timer;
-        if (imbalance < 0)
-            throw std::invalid_argument("invalid imbalance -- '" + std::to_string(imbalance) + "'");
 
         // Convert the input graph to RoutingKit's graph representation.
         std::vector<float> lats(graph.numVertices());
@@ -436,8 +554,9 @@ inline void runPreprocessing(const CommandLineParser &clp) {
 
         // Compute a separator decomposition for the input graph.
         const auto fragment = RoutingKit::make_graph_fragment(graph.numVertices(), tails, heads);
+        const InertialFlowSeparator computeCut(lats, lngs, balances, numRotations);
         auto computeSep = [&](const RoutingKit::GraphFragment &fragment) {
-            const auto cut = inertial_flow(fragment, imbalance, lats, lngs);
+            const auto cut = computeCut(fragment);
             return derive_separator_from_cut(fragment, cut.is_node_on_side);
         };
         const auto decomp = compute_separator_decomposition(fragment, computeSep);
@@ -483,12 +602,15 @@ inline void runPreprocessing(const CommandLineParser &clp) {
         outputFile << "# Separator: " << sepFileName << '\n';
 
         Timer timer;
+        PerfMeter perfMeter;
         CCH cch;
         cch.preprocess(graph, decomp);
         const auto preprocessTime = timer.elapsed<std::chrono::microseconds>();
         outputFile << "# Preprocess time (for given sepdecomp): " << preprocessTime << " microseconds.\n";
+        writePerfCounts(outputFile, "preprocessing", perfMeter.elapsed());
 
         outputFile << "basic_customization,perfect_customization,construction,total_time\n";
+        PerfCounts customizationPerf;
         int64_t basicCustom, perfectCustom, construct, tot;
         for (auto i = 0; i < numCustomRuns; ++i) {
 //            {
@@ -508,20 +630,21 @@ inline void runPreprocessing(const CommandLineParser &clp) {
 //            }
 
             timer.restart();
+            perfMeter.restart();
             CCHMetric metric(cch, &graph.travelTime(0));
             metric.buildMinimumWeightedCH<Timer>(basicCustom, perfectCustom, construct);
             tot = timer.elapsed<std::chrono::microseconds>();
+            customizationPerf += perfMeter.elapsed();
 
             outputFile << basicCustom << ',' << perfectCustom << ',' << construct << ',' << tot << '\n';
         }
+        writePerfCounts(outputFile, "customization", customizationPerf, numCustomRuns, "run");
 
     } else if (algorithmName == "CTL") {
         // Run the preprocessing phase of CTL.
         std::cout << "Constructing separator decomposition with strict dissection for CTL for " << graphFileName
                   << "... " << std::flush;
         Timer timer;
-        if (imbalance < 0)
-            throw std::invalid_argument("invalid imbalance -- '" + std::to_string(imbalance) + "'");
 
         // Convert the input graph to RoutingKit's graph representation.
         std::vector<float> lats(graph.numVertices());
@@ -539,13 +662,14 @@ inline void runPreprocessing(const CommandLineParser &clp) {
 
         // Compute a strict bisection separator decomposition for the input graph.
         auto fragment = RoutingKit::make_graph_fragment(graph.numVertices(), tails, heads);
-        auto computeCut = [&](const RoutingKit::GraphFragment &fragment) {
-            return inertial_flow(fragment, imbalance, lats, lngs);
-        };
+        const InertialFlowSeparator computeCut(lats, lngs, balances, numRotations);
         RoutingKit::BitVector all(fragment.node_count(), true);
         RoutingKit::BitVector none = ~all;
-        const auto decomp = compute_separator_decomposition_with_strict_dissection(std::move(fragment), computeCut,
-                                                                                   std::move(none), std::move(all));
+        RoutingKit::SeparatorDecomposition decomp;
+#pragma omp parallel // parallelizes the recursion within compute_separator_decomposition_with_strict_dissection.
+#pragma omp single nowait
+        decomp = compute_separator_decomposition_with_strict_dissection(std::move(fragment), computeCut,
+                                                                        std::move(none), std::move(all));
 
         // Convert the separator decomposition to our representation.
         SeparatorDecomposition sepDecomp;
@@ -563,6 +687,14 @@ inline void runPreprocessing(const CommandLineParser &clp) {
         const auto preprocessTime = timer.elapsed<std::chrono::microseconds>();
         std::cout << " finished (" << preprocessTime << " microseconds)." << std::endl;
 
+        // Report the size of the labels induced by the separator decomposition.
+        static constexpr uint64_t BYTES_PER_MB = 1 << 20;
+        BalancedTopologyCentricTreeHierarchy treeHierarchy;
+        treeHierarchy.preprocess(graph, sepDecomp);
+        const auto numHubs = treeHierarchy.getTotalNumHubs();
+        std::cout << "Labels have " << numHubs << " hubs in total, i.e., the up and down distances take "
+                  << 2 * numHubs * sizeof(int32_t) / BYTES_PER_MB << " MB." << std::endl;
+
         if (!endsWith(outputFileName, ".strict_bisep.bin"))
             outputFileName += ".strict_bisep.bin";
         std::ofstream outputFile(outputFileName, std::ios::binary);
@@ -631,6 +763,7 @@ inline void runPreprocessing(const CommandLineParser &clp) {
         outputFile << "# Separator: " << sepFileName << '\n';
 
         Timer timer;
+        PerfMeter perfMeter;
         CCH cch;
         cch.preprocess(graph, decomp);
         BalancedTopologyCentricTreeHierarchy treeHierarchy;
@@ -643,30 +776,41 @@ inline void runPreprocessing(const CommandLineParser &clp) {
         ctl.init();
         const auto preprocessTime = timer.elapsed<std::chrono::microseconds>();
         outputFile << "# Preprocess time (for given sepdecomp): " << preprocessTime << " microseconds.\n";
+        writePerfCounts(outputFile, "preprocessing", perfMeter.elapsed());
 
         outputFile << "cch_customization,ctl_customization,total_time\n";
         timer.restart();
         int cchCustom, ctlCustom, tot;
+        PerfCounts cchCustomizationPerf;
+        PerfCounts ctlCustomizationPerf;
         for (auto i = 0; i < numCustomRuns; ++i) {
             {
                 CCHMetric metric(cch, &graph.travelTime(0));
                 timer.restart();
+                perfMeter.restart();
                 if constexpr (CTL_USE_PERFECT_CUSTOMIZATION) {
                     metric.buildMinimumWeightedCH();
                 } else {
                     metric.customize();
                 }
                 cchCustom = timer.elapsed<std::chrono::microseconds>();
+                cchCustomizationPerf += perfMeter.elapsed();
             }
             {
                 CTLMetric<LabellingT, CTLLabelSet, CTL_USE_PERFECT_CUSTOMIZATION> metric(treeHierarchy, cch, &graph.travelTime(0));
                 timer.restart();
+                perfMeter.restart();
                 metric.buildCustomizedCTL(ctl);
                 tot = timer.elapsed<std::chrono::microseconds>();
+                ctlCustomizationPerf += perfMeter.elapsed();
             }
             ctlCustom = tot - cchCustom;
             outputFile << cchCustom << ',' << ctlCustom << ',' << tot << '\n';
         }
+        // The CTL customization includes the CCH customization, which is subtracted as for the times.
+        ctlCustomizationPerf -= cchCustomizationPerf;
+        writePerfCounts(outputFile, "CCH customization", cchCustomizationPerf, numCustomRuns, "run");
+        writePerfCounts(outputFile, "CTL customization", ctlCustomizationPerf, numCustomRuns, "run");
     } else if (algorithmName == "CTLSACCH-custom") {
 
         // TODO: Allow using CCH from CTLSA again.
@@ -848,6 +992,8 @@ int main(int argc, char *argv[]) {
     omp_set_num_threads(NUM_THREADS);
     try {
         CommandLineParser clp(argc, argv);
+        ArenaPolicy::global().pageKind = EnumParser<PageKind>()(clp.getValue<std::string>("pages", "default"));
+        ArenaPolicy::global().interleave = clp.isSet("interleave");
         if (clp.isSet("help"))
             printUsage();
         else if (clp.isSet("d"))
@@ -0,0 +1,67 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "Tools/ColumnarFile.h"
+#include "Tools/CommandLine/CommandLineParser.h"
+#include "Tools/StringHelpers.h"
+
+inline void printUsage() {
+  std::cout <<
+      "Usage: ColumnarToCsv -i <file> -o <file>\n"
+      "Converts a binary columnar file (e.g., flow patterns or OD distances written by\n"
+      "AssignTraffic -bin) into the CSV format written by AssignTraffic without -bin.\n"
+      "  -i <file>         input file in binary columnar format\n"
+      "  -o <file>         output file without file extension\n"
+      "  -help             display this help and exit\n";
+}
+
+int main(int argc, char* argv[]) {
+  try {
+    CommandLineParser clp(argc, argv);
+    if (clp.isSet("help")) {
+      printUsage();
+      return EXIT_SUCCESS;
+    }
+
+    const auto infile = clp.getValue<std::string>("i");
+    auto outfile = clp.getValue<std::string>("o");
+    if (!endsWith(outfile, ".csv"))
+      outfile += ".csv";
+
+    std::ifstream in(infile, std::ios::binary);
+    if (!in.good())
+      throw std::invalid_argument("file not found -- '" + infile + "'");
+    std::ofstream out(outfile);
+    if (!out.good())
+      throw std::invalid_argument("file cannot be opened -- '" + outfile + "'");
+
+    std::cout << "Converting the input file..." << std::flush;
+    const auto columns = columnar::readHeader(in);
+    out << "iteration";
+    for (const auto& col : columns)
+      out << ',' << col.name;
+    out << '\n';
+
+    columnar::Block block;
+    while (block.readFrom(in, columns)) {
+      for (auto i = 0; i < block.numRows(); ++i) {
+        out << block.blockId();
+        for (auto j = 0; j < columns.size(); ++j)
+          if (columns[j].type == columnar::ColumnType::INT32)
+            out << ',' << block.intColumn(j)[i];
+          else
+            out << ',' << block.floatColumn(j)[i];
+        out << '\n';
+      }
+    }
+    std::cout << " done." << std::endl;
+  } catch (std::invalid_argument& e) {
+    std::cerr << argv[0] << ": " << e.what() << std::endl;
+    std::cerr << "Try '" << argv[0] << " -help' for more information." << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -27,19 +27,24 @@
 #include "DataStructures/Graph/Attributes/XatfRoadCategoryAttribute.h"
 #include "DataStructures/Graph/Export/DefaultExporter.h"
 #include "DataStructures/Graph/Graph.h"
+#include "DataStructures/Graph/VertexOrders.h"
 #include "DataStructures/Graph/Import/DimacsImporter.h"
 #include "DataStructures/Graph/Import/MatSimImporter.h"
 #include "DataStructures/Graph/Import/OsmImporter.h"
 #include "DataStructures/Graph/Import/VisumImporter.h"
 #include "DataStructures/Graph/Import/XatfImporter.h"
+#include "DataStructures/Partitioning/SeparatorDecomposition.h"
+#include "DataStructures/Utilities/Permutation.h"
 #include "Tools/CommandLine/CommandLineParser.h"
 #include "Tools/ContainerHelpers.h"
 
 inline void printUsage() {
   std::cout <<
-      "Usage: ConvertGraph -s <fmt> -d <fmt> [-c] [-scc] -a <attrs> -i <file> -o <file>\n"
+      "Usage: ConvertGraph -s <fmt> -d <fmt> [-c] [-scc] [-ord <ord>] -a <attrs>\n"
+      "                    -i <file> -o <file>\n"
       "This program converts a graph from a source file format to a destination format,\n"
-      "possibly extracting the largest strongly connected component of the input graph.\n"
+      "possibly extracting the largest strongly connected component of the input graph and\n"
+      "reordering its vertices to improve spatial locality.\n"
       "  -s <fmt>          source file format\n"
       "                      possible values:\n"
       "                        binary default dimacs matsim osm visum xatf\n"
@@ -49,6 +54,10 @@ inline void printUsage() {
       "  -c                compress the output file(s), if available\n"
       "  -p <file>         extract a region given as an OSM POLY file\n"
       "  -scc              extract the largest strongly connected component\n"
+      "  -ord <ord>        reorder the vertices and also output the permutation (.perm.bin)\n"
+      "                      possible values: hilbert dfs bfs nd\n"
+      "  -sep <file>       separator decomposition of the graph to be reordered; required for\n"
+      "                      -ord nd, and also output for the reordered graph (.sep.bin)\n"
       "  -dp <prec>        travel distances are given in 1/<prec> meters (DIMACS only)\n"
       "  -tp <prec>        travel times are given in 1/<prec> seconds (DIMACS only)\n"
       "  -cp <prec>        coordinates are given in 1/<prec> degrees (DIMACS only)\n"
@@ -63,6 +72,7 @@ inline void printUsage() {
       "                        road_geometry sequential_vertex_id speed_limit\n"
       "                        travel_time vertex_id xatf_road_category\n"
       "  -i <file>         input file(s) without file extension\n"
+      "                      (DIMACS files may also be gzip-compressed, ending in .gz)\n"
       "  -o <file>         output file(s) without file extension\n"
       "  -help             display this help and exit\n";
 }
@@ -159,7 +169,10 @@ inline void exportGraph(const CommandLineParser& clp, const GraphT& graph) {
     for (const auto& attr : GraphT::getAttributeNames())
       if (!contains(attrsToOutput.begin(), attrsToOutput.end(), attr))
         attrsToIgnore.push_back(attr);
-    graph.writeTo(out, attrsToIgnore);
+    if (compress)
+      graph.writeCompressedTo(out, attrsToIgnore);
+    else
+      graph.writeTo(out, attrsToIgnore);
   } else if (format == "default") {
     doExport(clp, graph, DefaultExporter(compress));
   } else {
@@ -206,6 +219,44 @@ int main(int argc, char* argv[]) {
       std::cout << " done." << std::endl;
     }
 
+    if (clp.isSet("ord")) {
+      std::cout << "Reordering the vertices..." << std::flush;
+      if (!clp.isSet("o"))
+        throw std::invalid_argument("option -ord requires option -o");
+      const auto outfile = clp.getValue<std::string>("o");
+      SeparatorDecomposition sepDecomp;
+      if (clp.isSet("sep")) {
+        const auto sepFileName = clp.getValue<std::string>("sep");
+        std::ifstream sepFile(sepFileName, std::ios::binary);
+        if (!sepFile.good())
+          throw std::invalid_argument("file not found -- '" + sepFileName + "'");
+        sepDecomp.readFrom(sepFile);
+        if (sepDecomp.order.size() != graph.numVertices())
+          throw std::invalid_argument("separator decomposition does not match the graph");
+      }
+      const auto sepDecompPtr = clp.isSet("sep") ? &sepDecomp : nullptr;
+      const auto perm = computeVertexOrder(graph, clp.getValue<std::string>("ord"), sepDecompPtr);
+
+      // Record the vertex IDs before reordering, so that OD pairs can still be mapped onto it.
+      if (graph.numVertices() > 0 && graph.sequentialVertexId(0) == INVALID_VERTEX)
+        FORALL_VERTICES(graph, v)
+          graph.sequentialVertexId(v) = v;
+      graph.permuteVertices(perm);
+
+      std::ofstream permFile(outfile + ".perm.bin", std::ios::binary);
+      if (!permFile.good())
+        throw std::invalid_argument("file cannot be opened -- '" + outfile + ".perm.bin'");
+      perm.writeTo(permFile);
+      if (clp.isSet("sep")) {
+        permuteSeparatorDecomposition(sepDecomp, perm);
+        std::ofstream sepFile(outfile + ".sep.bin", std::ios::binary);
+        if (!sepFile.good())
+          throw std::invalid_argument("file cannot be opened -- '" + outfile + ".sep.bin'");
+        sepDecomp.writeTo(sepFile);
+      }
+      std::cout << " done." << std::endl;
+    }
+
     if (clp.isSet("o")) {
       std::cout << "Writing the output file(s)..." << std::flush;
       exportGraph(clp, graph);
@@ -7,6 +7,7 @@
 #include <fstream>
 #include <iostream>
 #include <random>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 
@@ -24,6 +25,7 @@
 #include "DataStructures/Graph/Attributes/SequentialVertexIdAttribute.h"
 #include "DataStructures/Graph/Attributes/TravelTimeAttribute.h"
 #include "DataStructures/Graph/Graph.h"
+#include "DataStructures/Utilities/OriginDestination.h"
 #include "ODPairGenerator.h"
 #include "Tools/CommandLine/CommandLineParser.h"
 #include "Tools/CommandLine/ProgressBar.h"
@@ -49,6 +51,7 @@ inline void printUsage() {
       "  -geom             choose geometrically distributed ranks/distances\n"
       "  -g <file>         input graph in binary format\n"
       "  -a <file>         restrict origins and destinations to polygonal study area\n"
+      "  -bin              write a binary OD file instead of a CSV file\n"
       "  -o <file>         place output in <file>\n"
       "  -help             display this help and exit\n";
 }
@@ -71,9 +74,11 @@ int main(int argc, char* argv[]) {
     const auto isGeom = clp.isSet("geom");
     const auto graphFileName = clp.getValue<std::string>("g");
     const auto areaFileName = clp.getValue<std::string>("a");
+    const auto binaryOutput = clp.isSet("bin");
+    const std::string outputExtension = binaryOutput ? ".bin" : ".csv";
     auto outputFileName = clp.getValue<std::string>("o");
-    if (!endsWith(outputFileName, ".csv"))
-      outputFileName += ".csv";
+    if (!endsWith(outputFileName, outputExtension))
+      outputFileName += outputExtension;
     const auto partFileStem = "/tmp/" + outputFileName.substr(outputFileName.rfind('/') + 1);
 
     // Read the graph from file.
@@ -110,23 +115,27 @@ int main(int argc, char* argv[]) {
       std::cout << " done.\n";
     }
 
-    // Write header to the output file.
-    std::ofstream outputFile(outputFileName);
-    if (!outputFile.good())
-      throw std::invalid_argument("file cannot be opened -- '" + outputFileName + "'");
-    outputFile << "# Input graph: " << graphFileName << '\n';
-    outputFile << "# Methodology: ";
+    // Open the output file. The header is written to it only if the output is a CSV file.
+    std::ofstream outputFile;
+    if (!binaryOutput) {
+      outputFile.open(outputFileName);
+      if (!outputFile.good())
+        throw std::invalid_argument("file cannot be opened -- '" + outputFileName + "'");
+    }
+    std::ostringstream header;
+    header << "# Input graph: " << graphFileName << '\n';
+    header << "# Methodology: ";
 
     if (expectedRanks.size() > 0) {
 
       // Choose the destination by Dijkstra rank.
       if (isGeom)
-        outputFile << "geometrically distributed ";
-      outputFile << "Dijkstra ranks (" << expectedRanks[0];
+        header << "geometrically distributed ";
+      header << "Dijkstra ranks (" << expectedRanks[0];
       for (auto i = 1; i < expectedRanks.size(); ++i)
-        outputFile << " " << expectedRanks[i];
-      outputFile << ")\n";
-      outputFile << "origin,destination,dijkstra_rank\n";
+        header << " " << expectedRanks[i];
+      header << ")\n";
+      header << "origin,destination,dijkstra_rank\n";
 
       Timer timer;
       ProgressBar bar;
@@ -178,12 +187,12 @@ int main(int argc, char* argv[]) {
 
       // Choose the destination by distance.
       if (isGeom)
-        outputFile << "geometrically distributed ";
-      outputFile << "distances (" << expectedDists[0];
+        header << "geometrically distributed ";
+      header << "distances (" << expectedDists[0];
       for (auto i = 1; i < expectedDists.size(); ++i)
-        outputFile << " " << expectedDists[i];
-      outputFile << ")\n";
-      outputFile << "origin,destination,distance\n";
+        header << " " << expectedDists[i];
+      header << ")\n";
+      header << "origin,destination,distance\n";
 
       Timer timer;
       ProgressBar bar;
@@ -234,8 +243,8 @@ int main(int argc, char* argv[]) {
     } else if (clp.isSet("n")) {
 
       // Choose the destination uniformly at random.
-      outputFile << "random\n";
-      outputFile << "origin,destination\n";
+      header << "random\n";
+      header << "origin,destination\n";
 
       Timer timer;
       ProgressBar bar;
@@ -273,8 +282,8 @@ int main(int argc, char* argv[]) {
 
       // Choose random OD pairs with a specified total length.
       const auto reverseGraph = graph.getReverseGraph();
-      outputFile << "random with a total length of " << totalLength << "\n";
-      outputFile << "origin,destination\n";
+      header << "random with a total length of " << totalLength << "\n";
+      header << "origin,destination\n";
 
       Timer timer;
       ProgressBar bar;
@@ -319,6 +328,11 @@ int main(int argc, char* argv[]) {
 
     // Merge the part files into a single output file.
     std::cout << "Merging part files into single output file..." << std::flush;
+    outputFile << header.str();
+    ODPairColumns odPairs;
+    const auto rankCol = !expectedRanks.empty() ? odPairs.addColumn("dijkstra_rank") : -1;
+    const auto distCol = expectedRanks.empty() && !expectedDists.empty() ?
+        odPairs.addColumn("distance") : -1;
     int src, dst, rank = -1, dist = -1;
     for (auto i = 0; true; ++i) {
       const auto partFileName = partFileStem + ".part" + std::to_string(i);
@@ -329,6 +343,13 @@ int main(int argc, char* argv[]) {
       partFileReader.read_header(
           io::ignore_missing_column, "origin", "destination", "dijkstra_rank", "distance");
       while (partFileReader.read_row(src, dst, rank, dist)) {
+        if (binaryOutput) {
+          odPairs.column(0).push_back(graph.sequentialVertexId(src));
+          odPairs.column(1).push_back(graph.sequentialVertexId(dst));
+          if (rankCol != -1) odPairs.column(rankCol).push_back(rank);
+          if (distCol != -1) odPairs.column(distCol).push_back(dist);
+          continue;
+        }
         outputFile << graph.sequentialVertexId(src) << ',' << graph.sequentialVertexId(dst);
         if (rank != -1) outputFile << ',' << rank;
         if (dist != -1) outputFile << ',' << dist;
@@ -337,6 +358,8 @@ int main(int argc, char* argv[]) {
       partFile.close();
       std::remove(partFileName.c_str());
     }
+    if (binaryOutput)
+      odPairs.writeTo(outputFileName);
     std::cout << " done.\n";
   } catch (std::exception& e) {
     std::cerr << argv[0] << ": " << e.what() << '\n';
@@ -24,8 +24,18 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+#include "DataStructures/Geometry/HilbertCurve.h"
+#include "DataStructures/Geometry/KDTree.h"
 #include "Tools/Logging/NullLogger.h"
 #include "Tools/Logging/LogManager.h"
+#include "Tools/OpenMP.h"
 #include "Utils.h"
 
 // Given a latitude/longitude coordinate, finds the closest vertex to that coordinate in a target road network.
@@ -64,13 +74,50 @@ public:
         const auto closestVertexInTar = eligibleVerticesInTar[pointIdx];
         const auto greatCircleDist = targetGraph.latLng(closestVertexInTar).getGreatCircleDistanceTo(latLng);
 
-        logMatch(latLng, closestVertexInTar, greatCircleDist);
+        logMatch(matchLogger, latLng, closestVertexInTar, greatCircleDist);
 
         if (greatCircleDist > maxVertexMatchDist)
             return INVALID_VERTEX;
         return closestVertexInTar;
     }
 
+    // Maps a batch of LatLng coordinates to the closest vertices in the target network in parallel. Returns the
+    // vertex in the target graph for each coordinate, or INVALID_VERTEX if no vertex is closer than the maximum
+    // distance. Both the result and the log are the same as when calling mapToTargetVertex for each coordinate.
+    std::vector<int> mapToTargetVertices(const std::vector<LatLng>& latLngs) {
+        const int numQueries = latLngs.size();
+
+        // Answer the queries in the order of a Hilbert curve, so that the queries that a thread answers one
+        // after another traverse mostly the same nodes of the KD-tree.
+        std::vector<uint64_t> keys(numQueries);
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < numQueries; ++i)
+            keys[i] = hilbertCurveIndex(latLngs[i]);
+        std::vector<int> queryOrder(numQueries);
+        std::iota(queryOrder.begin(), queryOrder.end(), 0);
+        std::stable_sort(queryOrder.begin(), queryOrder.end(), [&](const int i, const int j) {
+            return keys[i] < keys[j];
+        });
+
+        std::vector<int> closestVerticesInTar(numQueries);
+        std::vector<double> greatCircleDists(numQueries);
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (int j = 0; j < numQueries; ++j) {
+            const auto i = queryOrder[j];
+            const auto& latLng = latLngs[i];
+            const auto pointIdx = kdTree.findClosestPoint(Point(latLng.longitude(), latLng.latitude()));
+            closestVerticesInTar[i] = eligibleVerticesInTar[pointIdx];
+            greatCircleDists[i] = targetGraph.latLng(closestVerticesInTar[i]).getGreatCircleDistanceTo(latLng);
+        }
+
+        logMatches(latLngs, closestVerticesInTar, greatCircleDists);
+
+        for (int i = 0; i < numQueries; ++i)
+            if (greatCircleDists[i] > maxVertexMatchDist)
+                closestVerticesInTar[i] = INVALID_VERTEX;
+        return closestVerticesInTar;
+    }
+
 
 private:
 
@@ -106,8 +153,9 @@ private:
         return tree;
     }
 
-    void logMatch(const LatLng& srcLatLng, const int vInTar, const double greatCircleDist) {
-        matchLogger
+    template<typename OutputStreamT>
+    void logMatch(OutputStreamT& out, const LatLng& srcLatLng, const int vInTar, const double greatCircleDist) {
+        out
                 << latLngForCsv(srcLatLng) << ","
                 << vInTar << ","
                 << latLngForCsv(targetGraph.latLng(vInTar)) << ","
@@ -115,6 +163,28 @@ private:
                 << greatCircleDist << "\n";
     }
 
+    // Logs a batch of matches in order. Each thread formats a contiguous range of matches into a buffer of its own,
+    // and the buffers are written to the logger in the order of the ranges.
+    void logMatches(const std::vector<LatLng>& srcLatLngs, const std::vector<int>& verticesInTar,
+                    const std::vector<double>& greatCircleDists) {
+        if constexpr (!std::is_same_v<LoggerT, NullLogger>) {
+            const int numMatches = srcLatLngs.size();
+            std::vector<std::ostringstream> buffers;
+            #pragma omp parallel
+            {
+                #pragma omp single
+                buffers.resize(omp_get_num_threads());
+
+                auto& buffer = buffers[omp_get_thread_num()];
+                #pragma omp for schedule(static)
+                for (int i = 0; i < numMatches; ++i)
+                    logMatch(buffer, srcLatLngs[i], verticesInTar[i], greatCircleDists[i]);
+            }
+            for (const auto& buffer : buffers)
+                matchLogger << buffer.str();
+        }
+    }
+
     const GraphT &targetGraph;
     double maxVertexMatchDist;
     IsVertexEligibleT isVertexEligible;
@@ -24,6 +24,8 @@
 
 #pragma once
 
+#include <cassert>
+#include <vector>
 
 // Facilitates the mappings of input locations to output locations.
 // The central part maps a given latitude/longitude coordinate to the closest vertex in the target graph.
@@ -40,6 +42,8 @@ class LocationMapper {
 
 public:
 
+    using InputType = typename InputLocationToLatLngMapperT::InputType;
+
     LocationMapper(InputLocationToLatLngMapperT &inputLocationToLatLngMapper,
                    LatLngToTargetVertexMapperT &latLngToTargetVertexMapper,
                    TarVertexToOutputLocT &tarVertexToOutputLoc)
@@ -47,8 +51,7 @@ public:
               latLngToTargetVertexMapper(latLngToTargetVertexMapper),
               tarVertexToOutputLoc(tarVertexToOutputLoc) {}
 
-    bool mapLocation(const typename InputLocationToLatLngMapperT::InputType &inputLoc,
-                    int &outLoc, const int tarLocToAvoid = INVALID_ID) {
+    bool mapLocation(const InputType &inputLoc, int &outLoc, const int tarLocToAvoid = INVALID_ID) {
         const LatLng &latLng = inputLocationToLatLngMapper(inputLoc);
         const int tarVertex = latLngToTargetVertexMapper.mapToTargetVertex(latLng);
         if (tarVertex == INVALID_VERTEX)
@@ -58,6 +61,25 @@ public:
         return true;
     }
 
+    // Maps a batch of input locations to the closest vertices in the target graph. The closest vertices are found
+    // in parallel. Returns the vertex in the target graph for each input location, or INVALID_VERTEX if there is
+    // none. Each vertex can then be mapped to an output location by mapTargetVertex. The batched mapping yields the
+    // same result as mapLocation if the output locations are computed in the order of the input locations.
+    std::vector<int> mapToTargetVertices(const std::vector<InputType> &inputLocs) {
+        std::vector<LatLng> latLngs;
+        latLngs.reserve(inputLocs.size());
+        for (const auto &inputLoc: inputLocs)
+            latLngs.push_back(inputLocationToLatLngMapper(inputLoc));
+        return latLngToTargetVertexMapper.mapToTargetVertices(latLngs);
+    }
+
+    // Maps a vertex in the target graph, found by mapToTargetVertices for the given input location, to an output
+    // location.
+    int mapTargetVertex(const int tarVertex, const InputType &inputLoc, const int tarLocToAvoid = INVALID_ID) {
+        assert(tarVertex != INVALID_VERTEX);
+        return tarVertexToOutputLoc(tarVertex, inputLoc, tarLocToAvoid);
+    }
+
 private:
 
     InputLocationToLatLngMapperT &inputLocationToLatLngMapper;
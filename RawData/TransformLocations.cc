@@ -74,6 +74,7 @@ inline void printUsage() {
               "                             edge-id\n"
               "  -a <file>              optional .poly file describing area encompassing all OD-pairs/all vehicle locations.\n"
               "  -o <file>              place transformed OD-pairs in <file>\n"
+              "  -bin                   write transformed OD-pairs to a binary OD file instead of a CSV file\n"
               "  -help                  display this help and exit\n";
 }
 
@@ -81,17 +82,37 @@ inline void printUsage() {
 template<typename InputLocsT, typename LocationMapperT>
 void transformPairs(const InputLocsT &inputPairs,
                     LocationMapperT &locationMapper,
-                    const std::string &outputFileName) {
+                    const std::string &outputFileName,
+                    const bool binaryOutput) {
 
     std::cout << "Transforming OD-pairs ... " << std::endl;
+
+    // Find the closest vertices in the target network for all origins and destinations in one batch.
+    std::vector<typename LocationMapperT::InputType> inputLocs;
+    inputLocs.reserve(2 * inputPairs.size());
+    for (const auto& curPair : inputPairs) {
+        inputLocs.push_back(curPair.first);
+        inputLocs.push_back(curPair.second);
+    }
+    const auto tarVertices = locationMapper.mapToTargetVertices(inputLocs);
+
+    // Map the vertices to output locations in the order of the input pairs, as the output mappers are stateful.
     std::vector<OriginDestination> outputPairs;
     ProgressBar progressBar(inputPairs.size());
-    for (const auto& curPair : inputPairs) {
+    for (int i = 0; i < inputPairs.size(); ++i) {
+        const auto& curPair = inputPairs[i];
+        const auto tarVertexOfOrigin = tarVertices[2 * i];
+        const auto tarVertexOfDestination = tarVertices[2 * i + 1];
 
         int mappingOfOrigin = INVALID_VERTEX;
-        bool success = locationMapper.mapLocation(curPair.first, mappingOfOrigin);
+        bool success = tarVertexOfOrigin != INVALID_VERTEX;
+        if (success)
+            mappingOfOrigin = locationMapper.mapTargetVertex(tarVertexOfOrigin, curPair.first);
         int mappingOfDestination = INVALID_VERTEX;
-        success &= locationMapper.mapLocation(curPair.second, mappingOfDestination, mappingOfOrigin);
+        success &= tarVertexOfDestination != INVALID_VERTEX;
+        if (tarVertexOfDestination != INVALID_VERTEX)
+            mappingOfDestination = locationMapper.mapTargetVertex(tarVertexOfDestination, curPair.second,
+                                                                  mappingOfOrigin);
 
         ++progressBar;
         if (!success)
@@ -102,6 +123,16 @@ void transformPairs(const InputLocsT &inputPairs,
     std::cout << "\ndone.\n";
 
     std::cout << "Writing " << outputPairs.size() << " pairs to output..." << std::flush;
+    if (binaryOutput) {
+        ODPairColumns columns;
+        for (const auto &pair: outputPairs) {
+            columns.column(0).push_back(pair.origin);
+            columns.column(1).push_back(pair.destination);
+        }
+        columns.writeTo(outputFileName + ".bin");
+        std::cout << "done.\n";
+        return;
+    }
     std::ofstream out(outputFileName + ".csv");
     if (!out.good())
         throw std::invalid_argument("file cannot be opened -- '" + outputFileName + "'");
@@ -121,14 +152,15 @@ void transformInitialVehicleLocations(const InputLocsT &inputInitialVehLocations
                                       const std::string &outputFileName) {
 
     std::cout << "Transforming initial vehicle locations ... " << std::flush;
+    std::vector<typename LocationMapperT::InputType> inputLocs(inputInitialVehLocations.begin(),
+                                                               inputInitialVehLocations.end());
+    const auto tarVertices = locationMapper.mapToTargetVertices(inputLocs);
     std::vector<int> outputInitialVehicleLocations;
-    for (const auto& loc : inputInitialVehLocations) {
-
-        int mappingOfLoc = INVALID_VERTEX;
-        if (!locationMapper.mapLocation(loc, mappingOfLoc))
+    for (int i = 0; i < inputLocs.size(); ++i) {
+        if (tarVertices[i] == INVALID_VERTEX)
             continue;
 
-        outputInitialVehicleLocations.emplace_back(mappingOfLoc);
+        outputInitialVehicleLocations.emplace_back(locationMapper.mapTargetVertex(tarVertices[i], inputLocs[i]));
     }
     std::cout << " done.\n";
 
@@ -323,8 +355,9 @@ int main(int argc, char *argv[]) {
         auto maxDist = clp.getValue<double>("d", 0.0f);
         if (maxDist == 0.0f) maxDist = std::numeric_limits<double>::max();
         const auto areaFileName = clp.getValue<std::string>("a");
+        const auto binaryOutput = clp.isSet("bin");
         auto outputFileName = clp.getValue<std::string>("o");
-        if (endsWith(outputFileName, ".csv"))
+        if (endsWith(outputFileName, ".csv") || endsWith(outputFileName, ".bin"))
             outputFileName = outputFileName.substr(0, outputFileName.size() - 4);
         LogManager<std::ofstream>::setBaseFileName(outputFileName + ".");
 
@@ -413,7 +446,7 @@ int main(int argc, char *argv[]) {
 
             decideInputLocType<ODPairs>(inLocType, outLocType, targetGraph,
                                         sourceGraphPtr, inputReader,  maxDist, studyArea,
-                                        outputFileName);
+                                        outputFileName, binaryOutput);
 
         } else if (clp.isSet("v")) {
 
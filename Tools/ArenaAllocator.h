@@ -0,0 +1,212 @@
+#pragma once
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Tools/CompilerSpecific.h"
+#include "Tools/EnumParser.h"
+#include "Tools/MachineSpecs.h"
+#include "Tools/Numa.h"
+
+// The kinds of pages that may back large arenas.
+enum class PageKind {
+  DEFAULT,          // Regular pages, or transparent huge pages if enabled system-wide.
+  TRANSPARENT_HUGE, // Transparent huge pages, requested via madvise.
+  HUGE_2MB,         // Explicit 2MB huge pages, falling back to regular pages if none are reserved.
+  HUGE_1GB,         // Explicit 1GB huge pages, falling back to regular pages if none are reserved.
+};
+
+// Make EnumParser usable with PageKind.
+template <>
+inline void EnumParser<PageKind>::initNameToEnumMap() {
+  nameToEnum = {
+    {"default", PageKind::DEFAULT},
+    {"thp",     PageKind::TRANSPARENT_HUGE},
+    {"2mb",     PageKind::HUGE_2MB},
+    {"1gb",     PageKind::HUGE_1GB}
+  };
+}
+
+// The memory policy for large arenas, such as the label data of a CTL and the edge weights of a
+// CCH metric. The policy is process-wide and should be set before any arena is allocated.
+struct ArenaPolicy {
+  PageKind pageKind = PageKind::DEFAULT; // The kind of pages backing arenas.
+  bool interleave = false;               // Indicates whether pages are interleaved across NUMA nodes.
+  bool replicate = false;                // Indicates whether read-only indices are replicated per node.
+
+  // Returns the process-wide policy.
+  static ArenaPolicy& global() {
+    static ArenaPolicy policy;
+    return policy;
+  }
+};
+
+// An allocator for large arrays that are accessed randomly or by many threads. Arrays of at least
+// MIN_ARENA_SIZE bytes are mapped directly from the OS, backed by the pages and placed on the NUMA
+// nodes as specified by the global ArenaPolicy. Moreover, elements are default-initialized rather
+// than value-initialized, so resizing an array does not touch its pages. This way, the first
+// (parallel) write decides on which node each page is placed.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  // Arrays smaller than this number of bytes are allocated on the heap.
+  static constexpr size_t MIN_ARENA_SIZE = size_t{1} << 21;
+
+  ArenaAllocator() noexcept = default;
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>&) noexcept {}
+
+  // Allocates an array of n elements.
+  T* allocate(const size_t n) {
+    const auto bytes = n * sizeof(T);
+    if (bytes < MIN_ARENA_SIZE)
+      return static_cast<T*>(::operator new(bytes, std::align_val_t{ALIGNMENT}));
+    return static_cast<T*>(allocateArena(bytes));
+  }
+
+  // Deallocates the specified array of n elements.
+  void deallocate(T* const p, const size_t n) noexcept {
+    if (n * sizeof(T) < MIN_ARENA_SIZE) {
+      ::operator delete(p, std::align_val_t{ALIGNMENT});
+      return;
+    }
+    size_t len;
+    {
+      std::lock_guard<std::mutex> lock(arenaMutex());
+      const auto it = arenaLengths().find(p);
+      len = it->second;
+      arenaLengths().erase(it);
+    }
+    munmap(p, len);
+  }
+
+  // Default-initializes the object at p, which leaves trivial types uninitialized.
+  template <typename U>
+  void construct(U* const p) noexcept(std::is_nothrow_default_constructible<U>::value) {
+    ::new (static_cast<void*>(p)) U;
+  }
+
+  // Constructs an object at p from the specified arguments.
+  template <typename U, typename... Args>
+  void construct(U* const p, Args&&... args) {
+    ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+  }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>&) const noexcept {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>&) const noexcept {
+    return false;
+  }
+
+ private:
+  // The alignment of the arrays allocated on the heap. Arenas are aligned to page boundaries.
+  static constexpr size_t ALIGNMENT = std::max(MIN_ALIGNMENT, CACHE_LINE_SIZE);
+
+  // Returns the lengths of the mappings of all live arenas, keyed by their start addresses. The
+  // lengths are kept outside the arenas, so that no page is touched before the first write. The
+  // table is never destroyed, since arrays with static storage duration may outlive it otherwise.
+  static std::unordered_map<void*, size_t>& arenaLengths() {
+    static auto* const lengths = new std::unordered_map<void*, size_t>;
+    return *lengths;
+  }
+
+  // Returns the mutex protecting the table of mapping lengths.
+  static std::mutex& arenaMutex() {
+    static auto* const mutex = new std::mutex;
+    return *mutex;
+  }
+
+  // Maps an arena of the specified number of bytes and records the length of the mapping.
+  static void* allocateArena(const size_t bytes) {
+    const auto& policy = ArenaPolicy::global();
+    const size_t regularPageSize = sysconf(_SC_PAGESIZE);
+    size_t pageSize = regularPageSize;
+    // Do not pass MAP_NORESERVE, so that mapping huge pages fails (rather than faulting on first
+    // touch) if not enough huge pages are reserved.
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (policy.pageKind == PageKind::HUGE_2MB) {
+      pageSize = size_t{1} << 21;
+      flags |= MAP_HUGETLB | (21 << MAP_HUGE_SHIFT);
+    } else if (policy.pageKind == PageKind::HUGE_1GB) {
+      pageSize = size_t{1} << 30;
+      flags |= MAP_HUGETLB | (30 << MAP_HUGE_SHIFT);
+    }
+
+    auto len = roundUp(bytes, pageSize);
+    auto base = mmap(nullptr, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (base == MAP_FAILED && (flags & MAP_HUGETLB)) {
+      // No huge pages of the requested size are available, so fall back to regular pages.
+      len = roundUp(bytes, regularPageSize);
+      base = mmap(nullptr, len, PROT_READ | PROT_WRITE, flags & ~MAP_HUGETLB & ~(63 << MAP_HUGE_SHIFT), -1, 0);
+    }
+    if (UNLIKELY(base == MAP_FAILED))
+      throw std::bad_alloc();
+
+    // Both requests are hints. If the kernel does not support them, we keep the default behavior.
+    if (policy.pageKind == PageKind::TRANSPARENT_HUGE)
+      madvise(base, len, MADV_HUGEPAGE);
+    if (policy.interleave)
+      interleave(base, len);
+
+    try {
+      std::lock_guard<std::mutex> lock(arenaMutex());
+      arenaLengths().emplace(base, len);
+    } catch (...) {
+      munmap(base, len);
+      throw;
+    }
+    return base;
+  }
+
+  // Interleaves the pages of the specified mapping across all NUMA nodes. Warns once if the kernel
+  // rejects the request, since the pages are then placed by the default policy.
+  static void interleave(void* const base, const size_t len) {
+    // The kernel ignores the last bit of the mask, hence the +1. It restricts the mask to the nodes
+    // the process may allocate memory on.
+    constexpr int BITS_PER_WORD = sizeof(unsigned long) * 8;
+    const auto maxNode = getNumNumaNodes() + 1;
+    std::vector<unsigned long> nodeMask((maxNode + BITS_PER_WORD - 1) / BITS_PER_WORD);
+    for (auto node = 0; node < maxNode - 1; ++node)
+      nodeMask[node / BITS_PER_WORD] |= 1ul << (node % BITS_PER_WORD);
+    if (syscall(SYS_mbind, base, len, MPOL_INTERLEAVE, nodeMask.data(), maxNode, 0) != 0) {
+      const auto error = errno;
+      static std::atomic<bool> warned(false);
+      if (!warned.exchange(true))
+        std::cerr << "warning: arenas cannot be interleaved across NUMA nodes (mbind: "
+                  << std::strerror(error) << ")" << std::endl;
+    }
+  }
+
+  // Rounds the specified number of bytes up to the next multiple of the page size.
+  static size_t roundUp(const size_t bytes, const size_t pageSize) {
+    return (bytes + pageSize - 1) / pageSize * pageSize;
+  }
+};
+
+// A std::vector whose elements are stored in an arena. Note that resize leaves new elements of
+// trivial types uninitialized, unless a value is specified.
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
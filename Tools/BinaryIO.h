@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
 #include <cstring>
 #include <fstream>
 #include <string>
@@ -57,6 +58,13 @@ inline void read(std::ifstream& in, T& obj) {
   assert(in.good());
 }
 
+// Reads an array of self-contained objects from a binary file.
+template <typename T>
+inline void read(std::ifstream& in, T* const data, const int count) {
+  in.read(reinterpret_cast<char*>(data), count * sizeof(T));
+  assert(in.good());
+}
+
 // Reads a string from a binary file.
 inline void read(std::ifstream& in, std::string& str) {
   getline(in, str, '\0');
@@ -97,6 +105,11 @@ inline void read(std::ifstream& in, boost::dynamic_bitset<BlockT, AllocT>& vec)
   boost::from_block_range(blocks.begin(), blocks.end(), vec);
 }
 
+// Skips the specified number of bytes in a binary file.
+inline void skip(std::ifstream& in, const int64_t numBytes) {
+  in.seekg(numBytes, std::ios::cur);
+}
+
 // Writes a self-contained object to a binary file.
 template <typename T>
 inline void write(std::ofstream& out, const T& obj) {
@@ -104,6 +117,13 @@ inline void write(std::ofstream& out, const T& obj) {
   assert(out.good());
 }
 
+// Writes an array of self-contained objects to a binary file.
+template <typename T>
+inline void write(std::ofstream& out, const T* const data, const int count) {
+  out.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+  assert(out.good());
+}
+
 // Writes a string to a binary file.
 inline void write(std::ofstream& out, const std::string& str) {
   out.write(str.data(), str.size() + 1);
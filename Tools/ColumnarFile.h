@@ -0,0 +1,284 @@
+#pragma once
+
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Tools/BinaryIO.h"
+
+// A binary columnar file stores a sequence of blocks, each holding one value per row for each of a
+// fixed set of columns. The file starts with a header consisting of a magic number, the number of
+// columns, and the type and name of each column. Each block consists of a block ID (for example,
+// the iteration that produced the data), the number of rows, and the values of each column stored
+// contiguously, one column after another.
+namespace columnar {
+
+// The magic number identifying binary columnar files.
+constexpr uint32_t MAGIC_NUMBER = 0x434f4c31;
+
+// The type of the values in a column.
+enum class ColumnType : int32_t {
+  INT32,
+  FLOAT32,
+};
+
+// A column in a binary columnar file.
+struct Column {
+  std::string name; // The name of the column.
+  ColumnType type;  // The type of the values in the column.
+};
+
+// A block of rows, stored column by column.
+class Block {
+ public:
+  // Prepares the block to hold the specified number of rows of the specified columns.
+  void init(const std::vector<Column>& columns, const int newId, const int newNumRows) {
+    id = newId;
+    rows = newNumRows;
+    columnSlots.resize(columns.size());
+    auto numIntColumns = 0;
+    auto numFloatColumns = 0;
+    for (auto i = 0; i < columns.size(); ++i)
+      columnSlots[i] = columns[i].type == ColumnType::INT32 ? numIntColumns++ : numFloatColumns++;
+    intColumns.resize(numIntColumns);
+    floatColumns.resize(numFloatColumns);
+    for (auto& col : intColumns)
+      col.resize(newNumRows);
+    for (auto& col : floatColumns)
+      col.resize(newNumRows);
+  }
+
+  // Returns the ID of the block.
+  int blockId() const {
+    return id;
+  }
+
+  // Returns the number of rows in the block.
+  int numRows() const {
+    return rows;
+  }
+
+  // Returns the values of the specified column, which must be of type INT32.
+  int32_t* intColumn(const int col) {
+    assert(col >= 0); assert(col < columnSlots.size());
+    return intColumns[columnSlots[col]].data();
+  }
+
+  // Returns the values of the specified column, which must be of type INT32.
+  const int32_t* intColumn(const int col) const {
+    assert(col >= 0); assert(col < columnSlots.size());
+    return intColumns[columnSlots[col]].data();
+  }
+
+  // Returns the values of the specified column, which must be of type FLOAT32.
+  float* floatColumn(const int col) {
+    assert(col >= 0); assert(col < columnSlots.size());
+    return floatColumns[columnSlots[col]].data();
+  }
+
+  // Returns the values of the specified column, which must be of type FLOAT32.
+  const float* floatColumn(const int col) const {
+    assert(col >= 0); assert(col < columnSlots.size());
+    return floatColumns[columnSlots[col]].data();
+  }
+
+  // Writes the block to the specified binary file.
+  void writeTo(std::ofstream& out, const std::vector<Column>& columns) const {
+    bio::write(out, id);
+    bio::write(out, rows);
+    for (auto i = 0; i < columns.size(); ++i)
+      if (columns[i].type == ColumnType::INT32)
+        out.write(reinterpret_cast<const char*>(intColumn(i)), rows * sizeof(int32_t));
+      else
+        out.write(reinterpret_cast<const char*>(floatColumn(i)), rows * sizeof(float));
+  }
+
+  // Reads the next block from the specified binary file. Returns false if there are no more blocks.
+  bool readFrom(std::ifstream& in, const std::vector<Column>& columns) {
+    int newId, newNumRows;
+    if (!in.read(reinterpret_cast<char*>(&newId), sizeof(newId)))
+      return false;
+    bio::read(in, newNumRows);
+    init(columns, newId, newNumRows);
+    for (auto i = 0; i < columns.size(); ++i)
+      if (columns[i].type == ColumnType::INT32)
+        in.read(reinterpret_cast<char*>(intColumn(i)), rows * sizeof(int32_t));
+      else
+        in.read(reinterpret_cast<char*>(floatColumn(i)), rows * sizeof(float));
+    if (!in.good())
+      throw std::invalid_argument("truncated block in columnar file");
+    return true;
+  }
+
+ private:
+  int id = 0;                                    // The ID of the block.
+  int rows = 0;                                  // The number of rows in the block.
+  std::vector<int> columnSlots;                  // The index of each column among those of its type.
+  std::vector<std::vector<int32_t>> intColumns;  // The values of the INT32 columns.
+  std::vector<std::vector<float>> floatColumns;  // The values of the FLOAT32 columns.
+};
+
+// Reads the header of a binary columnar file and returns its columns.
+inline std::vector<Column> readHeader(std::ifstream& in) {
+  uint32_t magic = 0;
+  in.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+  if (!in.good() || magic != MAGIC_NUMBER)
+    throw std::invalid_argument("not a binary columnar file");
+  int32_t numColumns;
+  bio::read(in, numColumns);
+  std::vector<Column> columns(numColumns);
+  for (auto& col : columns) {
+    bio::read(in, col.type);
+    bio::read(in, col.name);
+  }
+  return columns;
+}
+
+// Writes a binary columnar file in a background thread. The writer is double-buffered: while the
+// caller fills the current block, the previous one is written to disk. The caller blocks only if it
+// submits a block before the previous one has been written.
+class AsyncWriter {
+ public:
+  // Constructs a writer that is not associated with any file.
+  AsyncWriter() = default;
+
+  // Writes all submitted blocks and closes the file. Write errors are not reported here, so callers
+  // that need to detect them must call close() explicitly.
+  ~AsyncWriter() {
+    try {
+      close();
+    } catch (std::invalid_argument&) {}
+  }
+
+  AsyncWriter(const AsyncWriter&) = delete;
+  AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+  // Opens the specified file for the specified columns. In append mode, the file must have been
+  // written before with the same columns, and no header is written.
+  void open(const std::string& name, std::vector<Column> cols, const bool append = false) {
+    assert(!isOpen());
+    if (append) {
+      std::ifstream in(name, std::ios::binary);
+      if (!in.good())
+        throw std::invalid_argument("file not found -- '" + name + "'");
+      const auto existingColumns = readHeader(in);
+      auto sameColumns = existingColumns.size() == cols.size();
+      for (auto i = 0; sameColumns && i < cols.size(); ++i)
+        sameColumns = existingColumns[i].name == cols[i].name && existingColumns[i].type == cols[i].type;
+      if (!sameColumns)
+        throw std::invalid_argument("columns do not match the existing file -- '" + name + "'");
+    }
+    out.open(name, append ? std::ios::binary | std::ios::app : std::ios::binary);
+    if (!out.good())
+      throw std::invalid_argument("file cannot be opened -- '" + name + "'");
+    fileName = name;
+    columns = std::move(cols);
+    if (append) {
+      // Position the stream at the end of the file, so that size() is correct before any write.
+      out.seekp(0, std::ios::end);
+    } else {
+      bio::write(out, MAGIC_NUMBER);
+      bio::write(out, static_cast<int32_t>(columns.size()));
+      for (const auto& col : columns) {
+        bio::write(out, col.type);
+        bio::write(out, col.name);
+      }
+    }
+    closing = false;
+    hasPendingBlock = false;
+    failed = !out.good();
+    writerThread = std::thread(&AsyncWriter::writeSubmittedBlocks, this);
+  }
+
+  // Returns true if the writer is associated with a file.
+  bool isOpen() const {
+    return out.is_open();
+  }
+
+  // Returns an empty block with the specified ID and number of rows, to be filled by the caller and
+  // then handed to submit().
+  Block& nextBlock(const int blockId, const int numRows) {
+    assert(isOpen());
+    currentBlock.init(columns, blockId, numRows);
+    return currentBlock;
+  }
+
+  // Hands the current block over to the background thread. Throws if writing a previous block failed.
+  void submit() {
+    assert(isOpen());
+    std::unique_lock<std::mutex> lock(mutex);
+    blockWritten.wait(lock, [&] { return !hasPendingBlock; });
+    if (failed)
+      throw std::invalid_argument("file cannot be written -- '" + fileName + "'");
+    std::swap(currentBlock, pendingBlock);
+    hasPendingBlock = true;
+    blockSubmitted.notify_one();
+  }
+
+  // Waits until all submitted blocks are written and returns the size of the file in bytes.
+  int64_t size() {
+    assert(isOpen());
+    std::unique_lock<std::mutex> lock(mutex);
+    blockWritten.wait(lock, [&] { return !hasPendingBlock; });
+    return out.tellp();
+  }
+
+  // Waits until all submitted blocks are written and closes the file. Throws if any write failed.
+  void close() {
+    if (!isOpen())
+      return;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      closing = true;
+    }
+    blockSubmitted.notify_one();
+    writerThread.join();
+    out.close();
+    if (failed || !out.good())
+      throw std::invalid_argument("file cannot be written -- '" + fileName + "'");
+  }
+
+ private:
+  // The background thread that writes the submitted blocks to disk.
+  void writeSubmittedBlocks() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      blockSubmitted.wait(lock, [&] { return hasPendingBlock || closing; });
+      if (!hasPendingBlock)
+        return;
+      lock.unlock();
+      if (!failed) {
+        pendingBlock.writeTo(out, columns);
+        out.flush();
+      }
+      const auto ok = out.good();
+      lock.lock();
+      failed = failed || !ok;
+      hasPendingBlock = false;
+      blockWritten.notify_one();
+    }
+  }
+
+  std::ofstream out;            // The binary columnar file.
+  std::string fileName;         // The name of the binary columnar file.
+  std::vector<Column> columns;  // The columns of the file.
+  Block currentBlock;           // The block being filled by the caller.
+  Block pendingBlock;           // The block being written by the background thread.
+
+  std::thread writerThread;               // The background thread.
+  std::mutex mutex;                       // Protects the flags below.
+  std::condition_variable blockSubmitted; // Signals a submitted block or closing to the writer.
+  std::condition_variable blockWritten;   // Signals a written block to the caller.
+  bool hasPendingBlock = false;           // Indicates whether pendingBlock is yet to be written.
+  bool closing = false;                   // Indicates whether the file is to be closed.
+  bool failed = false;                    // Indicates whether writing to the file failed.
+};
+
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <zlib.h>
+
+#include "Tools/BinaryIO.h"
+#include "Tools/MemoryMappedFile.h"
+
+// Functions for reading and writing compressed binary files. Large arrays are split into blocks
+// that are compressed independently, so that both compression and decompression can proceed in
+// parallel. Small integers are stored as variable-length integers (varints).
+namespace cbio {
+
+// The number of uncompressed bytes in each block of a block-compressed array.
+constexpr int BLOCK_SIZE = 1 << 20;
+
+// The ways in which a vector can be stored.
+enum class Encoding : char {
+  RAW,             // As written by bio::write.
+  BLOCK_COMPRESSED // As a block-compressed array.
+};
+
+// Appends the specified unsigned integer as a varint to the specified buffer.
+inline void appendVarint(std::vector<uint8_t>& buf, uint32_t val) {
+  while (val >= 0x80) {
+    buf.push_back(static_cast<uint8_t>(val) | 0x80);
+    val >>= 7;
+  }
+  buf.push_back(static_cast<uint8_t>(val));
+}
+
+// Decodes the varint at the specified position and advances the position past it.
+inline uint32_t decodeVarint(const uint8_t*& pos) {
+  uint32_t val = *pos & 0x7f;
+  for (auto shift = 7; *pos++ & 0x80; shift += 7)
+    val |= static_cast<uint32_t>(*pos & 0x7f) << shift;
+  return val;
+}
+
+// Maps signed integers to unsigned integers such that values of small magnitude stay small.
+inline uint32_t zigzagEncode(const int32_t val) {
+  return (static_cast<uint32_t>(val) << 1) ^ static_cast<uint32_t>(val >> 31);
+}
+
+// Inverts zigzagEncode.
+inline int32_t zigzagDecode(const uint32_t val) {
+  return static_cast<int32_t>(val >> 1) ^ -static_cast<int32_t>(val & 1);
+}
+
+// Returns a pointer to the next numBytes bytes in a binary file. The bytes are read into buf.
+inline const char* fetch(std::ifstream& in, const int64_t numBytes, std::vector<char>& buf) {
+  buf.resize(numBytes);
+  in.read(buf.data(), numBytes);
+  assert(in.good());
+  return buf.data();
+}
+
+// Returns a pointer to the next numBytes bytes in a memory-mapped file. No bytes are copied.
+inline const char* fetch(MemoryMappedFile& in, const int64_t numBytes, std::vector<char>& /*buf*/) {
+  return in.consume(numBytes);
+}
+
+// A block-compressed array, held in memory.
+class CompressedArray {
+ public:
+  // Compresses the specified bytes, one block per loop iteration in parallel.
+  CompressedArray(const char* const data, const int64_t numBytes) : rawSize(numBytes) {
+    const int numBlocks = (numBytes + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::vector<std::vector<Bytef>> blocks(numBlocks);
+    #pragma omp parallel for schedule(dynamic)
+    for (auto b = 0; b < numBlocks; ++b) {
+      const auto first = static_cast<int64_t>(b) * BLOCK_SIZE;
+      const auto len = std::min<int64_t>(BLOCK_SIZE, numBytes - first);
+      auto compressedLen = compressBound(len);
+      blocks[b].resize(compressedLen);
+      const auto src = reinterpret_cast<const Bytef*>(data + first);
+      [[maybe_unused]] const auto res = compress2(blocks[b].data(), &compressedLen, src, len, 6);
+      assert(res == Z_OK);
+      blocks[b].resize(compressedLen);
+    }
+    blockSizes.resize(numBlocks);
+    for (auto b = 0; b < numBlocks; ++b) {
+      blockSizes[b] = blocks[b].size();
+      bytes.insert(bytes.end(), blocks[b].begin(), blocks[b].end());
+    }
+  }
+
+  // Returns the number of bytes the array occupies on disk.
+  int64_t sizeOnDisk() const {
+    return sizeof(int64_t) + bio::size(blockSizes) + bytes.size();
+  }
+
+  // Writes the array to a binary file.
+  void writeTo(std::ofstream& out) const {
+    bio::write(out, rawSize);
+    bio::write(out, blockSizes);
+    out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    assert(out.good());
+  }
+
+  // Reads a block-compressed array from a binary file and decompresses it into the specified
+  // buffer of numBytes bytes. The blocks are decompressed in parallel.
+  template <typename InputStreamT>
+  static void readFrom(InputStreamT& in, char* const data, const int64_t numBytes) {
+    int64_t rawSize;
+    std::vector<int> blockSizes;
+    bio::read(in, rawSize);
+    bio::read(in, blockSizes);
+    if (rawSize != numBytes)
+      throw std::invalid_argument("size mismatch in block-compressed array");
+    std::vector<int64_t> firstByteOfBlock(blockSizes.size() + 1);
+    for (auto b = 0; b < blockSizes.size(); ++b)
+      firstByteOfBlock[b + 1] = firstByteOfBlock[b] + blockSizes[b];
+    std::vector<char> buf;
+    const auto bytes = reinterpret_cast<const Bytef*>(fetch(in, firstByteOfBlock.back(), buf));
+
+    auto ok = true;
+    #pragma omp parallel for schedule(dynamic)
+    for (auto b = 0; b < blockSizes.size(); ++b) {
+      const auto first = static_cast<int64_t>(b) * BLOCK_SIZE;
+      uLongf len = std::min<int64_t>(BLOCK_SIZE, numBytes - first);
+      const auto dst = reinterpret_cast<Bytef*>(data + first);
+      const auto res = uncompress(dst, &len, bytes + firstByteOfBlock[b], blockSizes[b]);
+      if (res != Z_OK || len != std::min<int64_t>(BLOCK_SIZE, numBytes - first)) {
+        #pragma omp atomic write
+        ok = false;
+      }
+    }
+    if (!ok)
+      throw std::invalid_argument("corrupt block in block-compressed array");
+  }
+
+ private:
+  int64_t rawSize;              // The number of uncompressed bytes.
+  std::vector<int> blockSizes;  // The number of compressed bytes in each block.
+  std::vector<Bytef> bytes;     // The compressed blocks, one after another.
+};
+
+// Writes a vector to a compressed binary file, preceded by the number of bytes it occupies on disk.
+// Vectors of self-contained objects are block-compressed, all others are written as is.
+template <typename T, typename AllocT>
+inline void write(std::ofstream& out, const std::vector<T, AllocT>& vec) {
+  if constexpr (std::is_trivially_copyable<T>::value) {
+    const CompressedArray arr(reinterpret_cast<const char*>(vec.data()), vec.size() * sizeof(T));
+    const auto sizeOnDisk = sizeof(Encoding) + sizeof(int) + arr.sizeOnDisk();
+    assert(sizeOnDisk <= INT32_MAX);
+    bio::write(out, static_cast<int>(sizeOnDisk));
+    bio::write(out, Encoding::BLOCK_COMPRESSED);
+    bio::write(out, static_cast<int>(vec.size()));
+    arr.writeTo(out);
+  } else {
+    bio::write(out, static_cast<int>(sizeof(Encoding) + bio::size(vec)));
+    bio::write(out, Encoding::RAW);
+    bio::write(out, vec);
+  }
+}
+
+// Reads a vector written by cbio::write from a binary file. The preceding number of bytes the
+// vector occupies on disk must already have been read.
+template <typename InputStreamT, typename T, typename AllocT>
+inline void read(InputStreamT& in, std::vector<T, AllocT>& vec) {
+  Encoding encoding;
+  bio::read(in, encoding);
+  if (encoding == Encoding::RAW) {
+    bio::read(in, vec);
+  } else if constexpr (std::is_trivially_copyable<T>::value) {
+    assert(encoding == Encoding::BLOCK_COMPRESSED);
+    int size;
+    bio::read(in, size);
+    vec.resize(size);
+    CompressedArray::readFrom(in, reinterpret_cast<char*>(vec.data()), size * sizeof(T));
+  } else {
+    throw std::invalid_argument("unexpected encoding of non-trivially copyable vector");
+  }
+}
+
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A read-only memory mapping of a file, together with a read position. Reading a binary file
+// through a mapping avoids one system call and one intermediate copy per read, and skipping data
+// costs nothing, since pages that are never touched are never loaded.
+class MemoryMappedFile {
+ public:
+  // Constructs a mapping that is not associated with any file.
+  MemoryMappedFile() = default;
+
+  // Constructs a mapping of the specified file.
+  explicit MemoryMappedFile(const std::string& fileName) {
+    open(fileName);
+  }
+
+  // Unmaps the file.
+  ~MemoryMappedFile() {
+    close();
+  }
+
+  MemoryMappedFile(const MemoryMappedFile&) = delete;
+  MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+  // Maps the specified file into memory and sets the read position to the beginning of the file.
+  void open(const std::string& fileName) {
+    close();
+    const auto fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd == -1)
+      throw std::invalid_argument("file not found -- '" + fileName + "'");
+    struct stat fileStatus;
+    if (fstat(fd, &fileStatus) == -1) {
+      ::close(fd);
+      throw std::invalid_argument("file cannot be opened -- '" + fileName + "'");
+    }
+    fileSize = fileStatus.st_size;
+    if (fileSize > 0) {
+      void* const addr = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED) {
+        ::close(fd);
+        throw std::invalid_argument("file cannot be mapped -- '" + fileName + "'");
+      }
+      begin = static_cast<const char*>(addr);
+      // We usually read the file front to back, so ask the kernel for aggressive read-ahead.
+      madvise(addr, fileSize, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+    pos = 0;
+    mapped = true;
+  }
+
+  // Returns true if a file is mapped.
+  bool isOpen() const {
+    return mapped;
+  }
+
+  // Unmaps the file.
+  void close() {
+    if (begin != nullptr)
+      munmap(const_cast<char*>(begin), fileSize);
+    begin = nullptr;
+    fileSize = 0;
+    pos = 0;
+    mapped = false;
+  }
+
+  // Returns a pointer to the first byte of the file.
+  const char* data() const {
+    return begin;
+  }
+
+  // Returns the size of the file in bytes.
+  size_t size() const {
+    return fileSize;
+  }
+
+  // Returns the current read position.
+  size_t tell() const {
+    return pos;
+  }
+
+  // Returns true if the read position is at the end of the file.
+  bool eof() const {
+    return pos == fileSize;
+  }
+
+  // Returns a pointer to the byte at the current read position, and advances the read position by
+  // the specified number of bytes.
+  const char* consume(const size_t numBytes) {
+    if (numBytes > fileSize - pos)
+      throw std::invalid_argument("unexpected end of memory-mapped file");
+    const auto ptr = begin + pos;
+    pos += numBytes;
+    return ptr;
+  }
+
+ private:
+  const char* begin = nullptr; // The first byte of the mapping.
+  size_t fileSize = 0;         // The size of the file in bytes.
+  size_t pos = 0;              // The current read position.
+  bool mapped = false;         // Indicates whether a file is mapped.
+};
+
+// Overloads of the binary I/O functions in Tools/BinaryIO.h for memory-mapped files.
+namespace bio {
+
+// Reads a self-contained object from a memory-mapped file.
+template <typename T>
+inline void read(MemoryMappedFile& in, T& obj) {
+  std::memcpy(static_cast<void*>(&obj), in.consume(sizeof(T)), sizeof(T));
+}
+
+// Reads an array of self-contained objects from a memory-mapped file.
+template <typename T>
+inline void read(MemoryMappedFile& in, T* const data, const int count) {
+  assert(count >= 0);
+  if (count > 0)
+    std::memcpy(static_cast<void*>(data), in.consume(count * sizeof(T)), count * sizeof(T));
+}
+
+// Reads a string from a memory-mapped file.
+inline void read(MemoryMappedFile& in, std::string& str) {
+  const auto first = in.data() + in.tell();
+  const auto last = static_cast<const char*>(std::memchr(first, '\0', in.size() - in.tell()));
+  if (last == nullptr)
+    throw std::invalid_argument("unexpected end of memory-mapped file");
+  str.assign(first, last);
+  in.consume(last - first + 1);
+}
+
+// Reads a vector of self-contained objects from a memory-mapped file.
+template <typename T, typename AllocT>
+inline std::enable_if_t<std::is_trivially_copyable<T>::value>
+read(MemoryMappedFile& in, std::vector<T, AllocT>& vec) {
+  int size;
+  read(in, size);
+  vec.resize(size);
+  read(in, vec.data(), size);
+}
+
+// Reads a vector of objects from a memory-mapped file.
+template <typename T, typename AllocT>
+inline std::enable_if_t<!std::is_trivially_copyable<T>::value>
+read(MemoryMappedFile& in, std::vector<T, AllocT>& vec) {
+  int size;
+  read(in, size);
+  vec.resize(size);
+  for (auto& elem : vec)
+    read(in, elem);
+}
+
+// Skips the specified number of bytes in a memory-mapped file.
+inline void skip(MemoryMappedFile& in, const int64_t numBytes) {
+  assert(numBytes >= 0);
+  in.consume(numBytes);
+}
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+// Helpers to find out about the NUMA topology of the machine, without depending on libnuma.
+
+// Returns the number of NUMA nodes, more precisely, one plus the highest node ID. Returns 1 if the
+// topology cannot be determined.
+inline int getNumNumaNodes() {
+  static const int numNodes = [] {
+    auto maxNodeId = 0;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+      const auto name = entry.path().filename().string();
+      if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+          std::all_of(name.begin() + 4, name.end(), [](const char c) { return std::isdigit(c); }))
+        maxNodeId = std::max(maxNodeId, std::atoi(name.c_str() + 4));
+    }
+    return maxNodeId + 1;
+  }();
+  return numNodes;
+}
+
+// Returns the NUMA node of the core the calling thread currently runs on. Unless the thread is
+// bound to a core (e.g., by OMP_PROC_BIND=true), it may migrate to another node at any time.
+inline int getCurrentNumaNode() {
+  unsigned int cpu = 0;
+  unsigned int node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+    return 0;
+  return std::min(static_cast<int>(node), getNumNumaNodes() - 1);
+}
@@ -23,4 +23,9 @@ int omp_get_thread_num(void)
   return 0;
 }
 
+int omp_in_parallel(void)
+{
+  return 0;
+}
+
 #endif
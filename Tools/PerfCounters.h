@@ -0,0 +1,243 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <iomanip>
+#include <ios>
+#include <ostream>
+
+#ifdef USE_PERF_COUNTERS
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#endif
+
+// Hardware performance counters are read only if USE_PERF_COUNTERS is defined. Otherwise, a
+// PerfMeter does nothing, and reporting code should be compiled out by testing this constant.
+#ifdef USE_PERF_COUNTERS
+inline constexpr bool PERF_COUNTERS_ENABLED = true;
+#else
+inline constexpr bool PERF_COUNTERS_ENABLED = false;
+#endif
+
+// The numbers of occurrences of several hardware events, summed over all threads. The numbers are
+// estimates if the kernel had to multiplex the counters.
+struct PerfCounts {
+  // The events that are counted.
+  enum Event { CYCLES, INSTRUCTIONS, LLC_MISSES, DTLB_MISSES, BRANCH_MISSES, NUM_EVENTS };
+
+  // Adds the specified counts to this one.
+  PerfCounts& operator+=(const PerfCounts& other) {
+    for (auto e = 0; e < NUM_EVENTS; ++e)
+      values[e] += other.values[e];
+    return *this;
+  }
+
+  // Subtracts the specified counts from this one.
+  PerfCounts& operator-=(const PerfCounts& other) {
+    for (auto e = 0; e < NUM_EVENTS; ++e)
+      values[e] -= other.values[e];
+    return *this;
+  }
+
+  // Returns the difference between this and the specified counts.
+  PerfCounts operator-(const PerfCounts& other) const {
+    auto diff = *this;
+    return diff -= other;
+  }
+
+  // Writes the counts, each divided by the specified number (e.g., of queries), to the specified
+  // stream, followed by the number of instructions per cycle.
+  void print(std::ostream& os, const double divisor = 1) const {
+    static constexpr const char* NAMES[] = {
+      "cycles", "instructions", "llc_misses", "dtlb_misses", "branch_misses"
+    };
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+    os << std::fixed << std::setprecision(divisor == 1 ? 0 : 1);
+    for (auto e = 0; e < NUM_EVENTS; ++e)
+      os << (e > 0 ? " " : "") << NAMES[e] << '=' << values[e] / divisor;
+    os << std::setprecision(2) << " ipc=" << values[INSTRUCTIONS] / std::max(values[CYCLES], 1.0);
+    os.flags(flags);
+    os.precision(precision);
+  }
+
+  std::array<double, NUM_EVENTS> values = {}; // The number of occurrences of each event.
+};
+
+#ifdef USE_PERF_COUNTERS
+namespace perf {
+
+// The counters of a single thread, one for each event. Events that the hardware or the kernel do
+// not support are not counted.
+class ThreadCounters {
+ public:
+  // Opens counters for the calling thread.
+  ThreadCounters() {
+    static constexpr uint64_t DTLB_READ_MISSES =
+        PERF_COUNT_HW_CACHE_DTLB |
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    fds[PerfCounts::CYCLES] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fds[PerfCounts::INSTRUCTIONS] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    fds[PerfCounts::LLC_MISSES] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    fds[PerfCounts::DTLB_MISSES] = open(PERF_TYPE_HW_CACHE, DTLB_READ_MISSES);
+    fds[PerfCounts::BRANCH_MISSES] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+  }
+
+  ~ThreadCounters() {
+    for (const auto fd : fds)
+      if (fd != -1)
+        close(fd);
+  }
+
+  ThreadCounters(const ThreadCounters&) = delete;
+  ThreadCounters& operator=(const ThreadCounters&) = delete;
+
+  // Returns true if at least one event is counted.
+  bool isOpen() const {
+    for (const auto fd : fds)
+      if (fd != -1)
+        return true;
+    return false;
+  }
+
+  // Adds the current values of the counters to the specified counts. If the kernel multiplexed a
+  // counter, its value is extrapolated to the whole time it was enabled.
+  void addTo(PerfCounts& counts) const {
+    for (auto e = 0; e < PerfCounts::NUM_EVENTS; ++e) {
+      uint64_t buf[3]; // The value, the time enabled and the time running.
+      if (fds[e] == -1 || read(fds[e], buf, sizeof(buf)) != sizeof(buf) || buf[2] == 0)
+        continue;
+      counts.values[e] += buf[2] < buf[1] ? buf[0] * (static_cast<double>(buf[1]) / buf[2]) : buf[0];
+    }
+  }
+
+ private:
+  // Opens a counter for the specified event, counting in user space only.
+  static int open(const uint32_t type, const uint64_t config) {
+    perf_event_attr attr = {};
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+  }
+
+  std::array<int, PerfCounts::NUM_EVENTS> fds; // The file descriptor of each counter, or -1.
+};
+
+// The counters of all threads that have been registered so far.
+struct Registry {
+  std::mutex mutex;                                      // Protects the counters.
+  std::vector<std::unique_ptr<ThreadCounters>> counters; // The counters of each thread.
+};
+
+// Returns the process-wide registry.
+inline Registry& registry() {
+  static Registry registry;
+  return registry;
+}
+
+// Opens counters for the calling thread, unless it already has some. Returns the thread's counters.
+inline const ThreadCounters& registerCurrentThread() {
+  thread_local const ThreadCounters* threadCounters = nullptr;
+  if (threadCounters != nullptr)
+    return *threadCounters;
+  auto counters = std::make_unique<ThreadCounters>();
+  threadCounters = counters.get();
+  auto& reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  if (!counters->isOpen() && reg.counters.empty())
+    std::cerr << "warning: hardware performance counters are not available "
+              << "(check /proc/sys/kernel/perf_event_paranoid)" << std::endl;
+  reg.counters.push_back(std::move(counters));
+  return *threadCounters;
+}
+
+// Returns the current values of the counters, summed over all registered threads.
+inline PerfCounts readAll() {
+  PerfCounts counts;
+  auto& reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  for (const auto& counters : reg.counters)
+    counters->addTo(counts);
+  return counts;
+}
+
+}
+#endif
+
+// The threads on which a PerfMeter counts events.
+enum class PerfScope {
+  THREAD, // Only the thread that constructed the meter.
+  TEAM,   // The thread that constructed the meter and all threads of its OpenMP team.
+};
+
+// A meter counting hardware events during a phase of the program, much like a Timer measures its
+// duration. The threads are determined when the meter is constructed, so that restarting it is
+// cheap. If the OpenMP team grows later, the events on the new threads are missed.
+class PerfMeter {
+ public:
+  // Constructs a meter counting events on the specified threads and starts it.
+  explicit PerfMeter(const PerfScope scope = PerfScope::TEAM) {
+#ifdef USE_PERF_COUNTERS
+    threadCounters = &perf::registerCurrentThread();
+    if (scope == PerfScope::TEAM) {
+      threadCounters = nullptr;
+#ifdef _OPENMP
+      if (!omp_in_parallel()) {
+#pragma omp parallel
+        perf::registerCurrentThread();
+      }
+#endif
+    }
+#else
+    static_cast<void>(scope);
+#endif
+    restart();
+  }
+
+  // Returns the events counted since the meter was started.
+  PerfCounts elapsed() const {
+#ifdef USE_PERF_COUNTERS
+    return readCounts() - startCounts;
+#else
+    return {};
+#endif
+  }
+
+  // Restarts the meter.
+  void restart() {
+#ifdef USE_PERF_COUNTERS
+    startCounts = readCounts();
+#endif
+  }
+
+ private:
+#ifdef USE_PERF_COUNTERS
+  // Returns the current values of the counters on the threads of this meter.
+  PerfCounts readCounts() const {
+    if (threadCounters == nullptr)
+      return perf::readAll();
+    PerfCounts counts;
+    threadCounters->addTo(counts);
+    return counts;
+  }
+
+  const perf::ThreadCounters* threadCounters; // The counters of the thread, or nullptr for a team.
+  PerfCounts startCounts;                     // The counts when the meter was started.
+#endif
+};
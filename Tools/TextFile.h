@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+#include <zlib.h>
+
+#include "Tools/MemoryMappedFile.h"
+
+// The entire contents of a text file, held in memory. Uncompressed files are memory-mapped;
+// gzip-compressed files are decompressed into a buffer. Opening a file is self-contained and may
+// therefore run in a background thread while the contents of other files are being processed.
+class TextFile {
+ public:
+  // Opens the specified file. If the file does not exist, but its gzip-compressed version (with the
+  // additional extension .gz) does, the latter is decompressed. Returns false if neither exists.
+  bool open(const std::string& fileName) {
+    close();
+    if (std::filesystem::exists(fileName)) {
+      mapping.open(fileName);
+      first = mapping.data();
+      last = first + mapping.size();
+    } else if (std::filesystem::exists(fileName + ".gz")) {
+      decompress(fileName + ".gz");
+      first = decompressed.data();
+      last = first + decompressed.size();
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  // Returns true if a file is open.
+  bool isOpen() const {
+    return first != nullptr;
+  }
+
+  // Releases the contents of the file.
+  void close() {
+    mapping.close();
+    decompressed.clear();
+    decompressed.shrink_to_fit();
+    first = nullptr;
+    last = nullptr;
+  }
+
+  // Returns a pointer to the first character of the file.
+  const char* begin() const {
+    return first;
+  }
+
+  // Returns a pointer past the last character of the file.
+  const char* end() const {
+    return last;
+  }
+
+ private:
+  // Decompresses the specified gzip-compressed file into the buffer.
+  void decompress(const std::string& fileName) {
+    static constexpr int CHUNK_SIZE = 1 << 20;
+    const auto file = gzopen(fileName.c_str(), "rb");
+    if (file == nullptr)
+      throw std::invalid_argument("file cannot be opened -- '" + fileName + "'");
+    gzbuffer(file, CHUNK_SIZE);
+    auto size = 0ul;
+    int bytesRead;
+    do {
+      decompressed.resize(size + CHUNK_SIZE);
+      bytesRead = gzread(file, decompressed.data() + size, CHUNK_SIZE);
+      size += std::max(bytesRead, 0);
+    } while (bytesRead == CHUNK_SIZE);
+    decompressed.resize(size);
+    const auto ok = bytesRead >= 0;
+    gzclose(file);
+    if (!ok)
+      throw std::invalid_argument("corrupt gzip file -- '" + fileName + "'");
+  }
+
+  MemoryMappedFile mapping;    // The mapping of an uncompressed file.
+  std::string decompressed;    // The decompressed contents of a gzip-compressed file.
+  const char* first = nullptr; // The first character of the file.
+  const char* last = nullptr;  // Past the last character of the file.
+};